@@ -0,0 +1,34 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#define STRINGIFY(x) #x
+
+namespace bench {
+    /**
+    * @brief Runs the callable a number of times and returns the median duration in milliseconds
+    */
+    template<typename F>
+    double measure(F&& func, int repeats = 5) {
+        std::vector<double> results;
+        for (int i = 0; i < repeats; i++) {
+            const auto start = std::chrono::steady_clock::now();
+            func();
+            const auto end = std::chrono::steady_clock::now();
+            results.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        std::sort(results.begin(), results.end());
+        return results[results.size() / 2];
+    }
+
+    inline void report(const char* name, double ms, double baseline = 0.0) {
+        if (baseline > 0.0) {
+            std::printf("%-40s %10.3f ms (%+.2f%%)\n", name, ms, (ms / baseline - 1.0) * 100.0);
+        } else {
+            std::printf("%-40s %10.3f ms\n", name, ms);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#include <simplesquirrel/simplesquirrel.hpp>
+#include <iostream>
+#include "benchmark.hpp"
+
+static const char* source = STRINGIFY(
+    function update(position, speed, dt) {
+        return position + speed * dt;
+    }
+);
+
+int main() {
+    ssq::VM vm(1024, ssq::Libs::NONE);
+    vm.run(vm.compileSource(source, "benchmark.nut"));
+    ssq::Function update = vm.findFunc("update");
+
+    for (size_t count : { 1000, 10000, 100000 }) {
+        std::vector<std::tuple<float, float, float>> entities;
+        for (size_t i = 0; i < count; i++) {
+            entities.emplace_back(static_cast<float>(i), 2.0f, 0.016f);
+        }
+        std::vector<float> results(count);
+
+        std::printf("%zu calls:\n", count);
+        const double baseline = bench::measure([&]() {
+            for (size_t i = 0; i < count; i++) {
+                results[i] = vm.callFunc(update, vm, std::get<0>(entities[i]),
+                    std::get<1>(entities[i]), std::get<2>(entities[i])).to<float>();
+            }
+        });
+        bench::report("  callFunc", baseline);
+        bench::report("  callBatch", bench::measure([&]() {
+            vm.callBatch<float>(update, vm, entities, results.begin());
+        }), baseline);
+    }
+    return 0;
+}
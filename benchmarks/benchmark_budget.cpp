@@ -0,0 +1,49 @@
+#include <simplesquirrel/simplesquirrel.hpp>
+#include <iostream>
+#include "benchmark.hpp"
+
+static const char* source = STRINGIFY(
+    function work() {
+        local sum = 0;
+        for (local i = 0; i < 500000; i++) {
+            sum += i % 7;
+        }
+        return sum;
+    }
+);
+
+int main() {
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.enableDebugInfo(true);
+    vm.run(vm.compileSource(source, "benchmark.nut"));
+    ssq::Function work = vm.findFunc("work");
+
+    const double baseline = bench::measure([&]() {
+        vm.callFunc(work, vm);
+    }, 11);
+    bench::report("no budget", baseline);
+
+    const double instructions = bench::measure([&]() {
+        vm.setInstructionBudget(1000000000ULL);
+        vm.callFunc(work, vm);
+        vm.clearBudget();
+    }, 11);
+    bench::report("instruction budget", instructions, baseline);
+
+    const double deadline = bench::measure([&]() {
+        vm.setTimeLimit(std::chrono::milliseconds(60000));
+        vm.callFunc(work, vm);
+        vm.clearBudget();
+    }, 11);
+    bench::report("deadline", deadline, baseline);
+
+    const double both = bench::measure([&]() {
+        vm.setInstructionBudget(1000000000ULL);
+        vm.setTimeLimit(std::chrono::milliseconds(60000));
+        vm.callFunc(work, vm);
+        vm.clearBudget();
+    }, 11);
+    bench::report("instruction budget and deadline", both, baseline);
+
+    return 0;
+}
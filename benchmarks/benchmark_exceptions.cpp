@@ -0,0 +1,81 @@
+#include <simplesquirrel/simplesquirrel.hpp>
+#include <sstream>
+#include <exception>
+#include <string>
+#include "benchmark.hpp"
+
+static const char* source = STRINGIFY(
+    function validate(func, count) {
+        local rejected = 0;
+        for (local i = 0; i < count; i++) {
+            try {
+                func(-i);
+            } catch (e) {
+                rejected++;
+            }
+        }
+        return rejected;
+    }
+);
+
+// Type error as it was built before the message became lazy: two string streams
+// and a formatted copy for every rejection
+class LegacyTypeException: public std::exception {
+public:
+    LegacyTypeException(const std::string& msg, const char* expected, const char* got) {
+        std::stringstream ss;
+        ss << "Type error " << msg << " expected: " << expected << " got: " << got;
+        generateMessage(ss.str());
+    }
+
+    virtual const char* what() const throw() override {
+        return message.c_str();
+    }
+
+private:
+    void generateMessage(const std::string& msg) {
+        // A type error has no VM, so there is no last error to read
+        std::ostringstream out;
+        out << "Squirrel exception: " << msg << " (no detailed info)";
+        message = out.str();
+    }
+
+    std::string message;
+};
+
+int main() {
+    ssq::VM vm(1024, ssq::Libs::NONE);
+    vm.addFunc("accept", [](int value) -> int {
+        return value;
+    });
+    vm.addFunc("rejectTyped", [](int value) -> int {
+        if (value <= 0) {
+            throw ssq::TypeException(ssq::StaticText("bad value"), ssq::StaticText("positive integer"),
+                ssq::StaticText("integer"));
+        }
+        return value;
+    });
+    vm.addFunc("rejectEager", [](int value) -> int {
+        if (value <= 0) {
+            throw LegacyTypeException("bad value", "positive integer", "integer");
+        }
+        return value;
+    });
+    vm.run(vm.compileSource(source, "benchmark.nut"));
+    ssq::Function validate = vm.findFunc("validate");
+
+    for (int count : { 1000, 10000, 100000 }) {
+        std::printf("%d calls:\n", count);
+        const double baseline = bench::measure([&]() {
+            vm.callFunc(validate, vm, vm.find("accept"), count);
+        });
+        bench::report("  no exception", baseline);
+        bench::report("  eager message", bench::measure([&]() {
+            vm.callFunc(validate, vm, vm.find("rejectEager"), count);
+        }), baseline);
+        bench::report("  lazy message", bench::measure([&]() {
+            vm.callFunc(validate, vm, vm.find("rejectTyped"), count);
+        }), baseline);
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <simplesquirrel/simplesquirrel.hpp>
+#include <iostream>
+#include <thread>
+#include "benchmark.hpp"
+
+static const char* source = STRINGIFY(
+    function fib(n) {
+        return n < 2 ? n : fib(n - 1) + fib(n - 2);
+    }
+);
+
+static double runJobs(size_t numOfWorkers, int numOfJobs, int n) {
+    ssq::VMExecutor executor(numOfWorkers, ssq::VMExecutor::runScript(source, "benchmark.nut"));
+    return bench::measure([&]() {
+        std::vector<std::future<int>> results;
+        results.reserve(numOfJobs);
+        for (int i = 0; i < numOfJobs; i++) {
+            results.push_back(executor.call<int>("fib", n));
+        }
+        for (auto& result : results) {
+            result.get();
+        }
+    }, 3);
+}
+
+int main() {
+    const size_t maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Running fib(20) jobs on up to " << maxWorkers << " workers" << std::endl;
+
+    const double single = runJobs(1, 256, 20);
+    bench::report("1 worker", single);
+    for (size_t workers = 2; workers <= maxWorkers; workers *= 2) {
+        const double ms = runJobs(workers, 256, 20);
+        const std::string name = std::to_string(workers) + " workers";
+        bench::report(name.c_str(), ms, single);
+        std::printf("    %.2fx speedup\n", single / ms);
+    }
+
+    // Small jobs show the queueing overhead
+    bench::report("10000 fib(1) jobs, 1 worker", runJobs(1, 10000, 1));
+    bench::report("10000 fib(1) jobs, all workers", runJobs(maxWorkers, 10000, 1));
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <simplesquirrel/simplesquirrel.hpp>
+#include <iostream>
+#include "benchmark.hpp"
+
+static const char* source = STRINGIFY(
+    function makeConfig(count) {
+        local items = array(count);
+        for (local i = 0; i < count; i++) {
+            local item = {};
+            item.id <- i;
+            item.name <- "item \"" + i + "\"";
+            item.weight <- i * 0.25;
+            item.tags <- array(3, "tag");
+            item.enabled <- (i % 2) == 0;
+            items[i] = item;
+        }
+        return items;
+    }
+);
+
+static void throughput(int count) {
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.run(vm.compileSource(source, "benchmark.nut"));
+    ssq::Object config = vm.callFunc(vm.findFunc("makeConfig"), vm, count);
+
+    std::string text;
+    const double write = bench::measure([&]() {
+        text = ssq::json::stringify(config);
+    });
+    const double read = bench::measure([&]() {
+        ssq::json::parse(vm, text);
+    });
+
+    const double mb = text.size() / (1024.0 * 1024.0);
+    std::printf("%d items: %.2f MB of JSON\n", count, mb);
+    bench::report("stringify", write);
+    std::printf("    %.0f MB/s\n", mb / (write / 1000.0));
+    bench::report("parse", read);
+    std::printf("    %.0f MB/s\n", mb / (read / 1000.0));
+}
+
+int main() {
+    throughput(10000);
+    throughput(100000);
+    return 0;
+}
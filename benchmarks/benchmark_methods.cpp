@@ -0,0 +1,42 @@
+#include <simplesquirrel/simplesquirrel.hpp>
+#include "benchmark.hpp"
+
+class Counter : public ssq::ExposableClass {
+public:
+    int add(int value) {
+        total += value;
+        return total;
+    }
+    int total = 0;
+};
+
+static const char* source = STRINGIFY(
+    function run(counter, name, count) {
+        local func = counter[name];
+        for (local i = 0; i < count; i++) {
+            func.call(counter, 1);
+        }
+    }
+);
+
+int main() {
+    ssq::VM vm(1024, ssq::Libs::NONE);
+    ssq::Class cls = vm.addClass("Counter", ssq::Class::Ctor<Counter()>());
+    cls.addFunc("addFunc", &Counter::add);
+    cls.addMethod<SSQ_METHOD(&Counter::add)>("addMethod");
+    vm.run(vm.compileSource(source, "benchmark.nut"));
+    ssq::Function run = vm.findFunc("run");
+    ssq::Instance counter = vm.newInstance(cls);
+
+    for (int count : { 10000, 100000, 1000000 }) {
+        std::printf("%d calls:\n", count);
+        const double baseline = bench::measure([&]() {
+            vm.callFunc(run, vm, counter, std::string("addFunc"), count);
+        });
+        bench::report("  addFunc (std::function)", baseline);
+        bench::report("  addMethod (direct)", bench::measure([&]() {
+            vm.callFunc(run, vm, counter, std::string("addMethod"), count);
+        }), baseline);
+    }
+    return 0;
+}
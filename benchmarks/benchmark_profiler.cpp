@@ -0,0 +1,43 @@
+#include <simplesquirrel/simplesquirrel.hpp>
+#include <iostream>
+#include "benchmark.hpp"
+
+static const char* source = STRINGIFY(
+    function fib(n) {
+        if (n < 2) return n;
+        return fib(n - 1) + fib(n - 2);
+    }
+
+    function work() {
+        local sum = 0;
+        for (local i = 0; i < 200000; i++) {
+            sum += i % 7;
+        }
+        return sum + fib(22);
+    }
+);
+
+int main() {
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.enableDebugInfo(true);
+    vm.run(vm.compileSource(source, "benchmark.nut"));
+    ssq::Function work = vm.findFunc("work");
+
+    auto run = [&]() { vm.callFunc(work, vm); };
+
+    const double baseline = bench::measure(run, 11);
+    bench::report("no profiler", baseline);
+
+    for (unsigned int rate : {100u, ssq::Profiler::DEFAULT_RATE, 10000u}) {
+        ssq::Profiler profiler(vm, rate);
+        profiler.start();
+        const double ms = bench::measure(run, 11);
+        profiler.stop();
+
+        const std::string name = "profiler @ " + std::to_string(rate) + " Hz";
+        bench::report(name.c_str(), ms, baseline);
+        std::cout << "    samples: " << profiler.getNumOfSamples() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <simplesquirrel/simplesquirrel.hpp>
+#include <iostream>
+#include "benchmark.hpp"
+
+static const char* source = STRINGIFY(
+    function task(rounds) {
+        local sum = 0;
+        for (local i = 0; i < rounds; i++) {
+            sum += i;
+            suspend();
+        }
+        return sum;
+    }
+
+    function listener() {
+        while (true) {
+            local sent = suspend("event");
+            mark(sent);
+        }
+    }
+);
+
+static void throughput(size_t numOfTasks, int rounds) {
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.run(vm.compileSource(source, "benchmark.nut"));
+    ssq::Function task = vm.findFunc("task");
+
+    ssq::Scheduler scheduler(vm, 64);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numOfTasks; i++) {
+        scheduler.spawn(task, rounds);
+    }
+    const auto spawned = std::chrono::steady_clock::now();
+
+    size_t resumes = 0;
+    while (scheduler.getNumOfTasks() > 0) {
+        resumes += scheduler.run();
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    // Spawning again reuses the threads of the finished tasks
+    const auto respawn = bench::measure([&]() {
+        for (size_t i = 0; i < numOfTasks; i++) {
+            scheduler.spawn(task, 0);
+        }
+    }, 1);
+
+    const double spawnMs = std::chrono::duration<double, std::milli>(spawned - start).count();
+    const double runMs = std::chrono::duration<double, std::milli>(end - spawned).count();
+    const std::string name = std::to_string(numOfTasks) + " tasks";
+    bench::report((name + " spawn").c_str(), spawnMs);
+    bench::report((name + " respawn").c_str(), respawn);
+    bench::report((name + " run").c_str(), runMs);
+    std::printf("    %.0f resumes/s\n", resumes / (runMs / 1000.0));
+}
+
+static void latency(size_t numOfTasks, int iterations) {
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.run(vm.compileSource(source, "benchmark.nut"));
+
+    std::vector<double> latencies;
+    latencies.reserve(numOfTasks * iterations);
+    auto epoch = std::chrono::steady_clock::now();
+    vm.addFunc("mark", [&](float sent) -> void {
+        const auto now = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+        latencies.push_back(now - sent);
+    });
+
+    ssq::Scheduler scheduler(vm, 64);
+    for (size_t i = 0; i < numOfTasks; i++) {
+        scheduler.spawn(vm.findFunc("listener"));
+    }
+
+    for (int i = 0; i < iterations; i++) {
+        const float sent = static_cast<float>(
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count());
+        scheduler.signal("event", sent);
+        scheduler.run();
+        epoch = std::chrono::steady_clock::now();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+    std::printf("wakeup latency of %zu tasks: p50 %.2f us, p90 %.2f us, p99 %.2f us, max %.2f us\n",
+        numOfTasks, percentile(0.5), percentile(0.9), percentile(0.99), latencies.back());
+}
+
+int main() {
+    throughput(10000, 10);
+    throughput(100000, 10);
+    latency(1000, 100);
+    return 0;
+}
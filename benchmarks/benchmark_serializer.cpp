@@ -0,0 +1,56 @@
+#include <simplesquirrel/simplesquirrel.hpp>
+#include <iostream>
+#include <sstream>
+#include "benchmark.hpp"
+
+static const char* source = STRINGIFY(
+    function makeState(count) {
+        local entities = array(count);
+        for (local i = 0; i < count; i++) {
+            local entity = {};
+            entity.id <- i;
+            entity.name <- "entity" + i;
+            local position = array(3, -1.0);
+            position[0] = i * 0.5;
+            position[1] = i * 2.0;
+            entity.position <- position;
+            entity.alive <- (i % 3) != 0;
+            entities[i] = entity;
+        }
+        return entities;
+    }
+);
+
+static void throughput(int count) {
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.run(vm.compileSource(source, "benchmark.nut"));
+    ssq::Object state = vm.callFunc(vm.findFunc("makeState"), vm, count);
+
+    std::string bytes;
+    const double write = bench::measure([&]() {
+        bytes = ssq::serialize(state);
+    });
+    const double read = bench::measure([&]() {
+        ssq::deserialize(vm, bytes);
+    });
+    const double stream = bench::measure([&]() {
+        std::stringstream buffer;
+        ssq::serialize(state, buffer);
+        ssq::deserialize(vm, buffer);
+    });
+
+    const double mb = bytes.size() / (1024.0 * 1024.0);
+    const std::string name = std::to_string(count) + " entities";
+    std::printf("%s: %.2f MB\n", name.c_str(), mb);
+    bench::report("serialize", write);
+    std::printf("    %.0f MB/s\n", mb / (write / 1000.0));
+    bench::report("deserialize", read);
+    std::printf("    %.0f MB/s\n", mb / (read / 1000.0));
+    bench::report("stream round trip", stream);
+}
+
+int main() {
+    throughput(10000);
+    throughput(100000);
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <simplesquirrel/simplesquirrel.hpp>
+#include <iostream>
+#include "benchmark.hpp"
+
+static const char* source = STRINGIFY(
+    function loopSum(x) {
+        local total = 0.0;
+        foreach (value in x) total += value;
+        return total;
+    }
+
+    function loopDot(a, b) {
+        local total = 0.0;
+        for (local i = 0; i < a.len(); i++) total += a[i] * b[i];
+        return total;
+    }
+
+    function loopMax(x) {
+        local result = x[0];
+        foreach (value in x) if (value > result) result = value;
+        return result;
+    }
+
+    function loopScale(x, factor) {
+        foreach (i, value in x) x[i] = value * factor;
+        return x;
+    }
+
+    function fill(x) {
+        for (local i = 0; i < x.len(); i++) x[i] = (i % 100) * 0.01;
+        return x;
+    }
+);
+
+static void compare(ssq::VM& vm, const char* name, const ssq::Object& input) {
+    ssq::Function loopSum = vm.findFunc("loopSum");
+    ssq::Function loopDot = vm.findFunc("loopDot");
+    ssq::Function loopMax = vm.findFunc("loopMax");
+    ssq::Function loopScale = vm.findFunc("loopScale");
+    ssq::Table lib = vm.find("vecmath").toTable();
+    ssq::Function sum = lib.findFunc("sum");
+    ssq::Function dot = lib.findFunc("dot");
+    ssq::Function max = lib.findFunc("max");
+    ssq::Function scale = lib.findFunc("scale");
+
+    std::printf("%s:\n", name);
+    double baseline = bench::measure([&]() { vm.callFunc(loopSum, vm, input); });
+    bench::report("  loop sum", baseline);
+    bench::report("  vecmath.sum", bench::measure([&]() { vm.callFunc(sum, lib, input); }), baseline);
+
+    baseline = bench::measure([&]() { vm.callFunc(loopDot, vm, input, input); });
+    bench::report("  loop dot", baseline);
+    bench::report("  vecmath.dot", bench::measure([&]() { vm.callFunc(dot, lib, input, input); }), baseline);
+
+    baseline = bench::measure([&]() { vm.callFunc(loopMax, vm, input); });
+    bench::report("  loop max", baseline);
+    bench::report("  vecmath.max", bench::measure([&]() { vm.callFunc(max, lib, input); }), baseline);
+
+    baseline = bench::measure([&]() { vm.callFunc(loopScale, vm, input, 1.0f); });
+    bench::report("  loop scale", baseline);
+    bench::report("  vecmath.scale", bench::measure([&]() { vm.callFunc(scale, lib, input, 1.0f); }), baseline);
+}
+
+int main() {
+    static const char* names[] = { "scalar", "SSE2", "AVX2" };
+    std::printf("instruction set: %s\n", names[static_cast<int>(ssq::vecmath::getInstructionSet())]);
+
+    ssq::VM vm(1024, ssq::Libs::VECMATH);
+    vm.run(vm.compileSource(source, "benchmark.nut"));
+    ssq::Function fill = vm.findFunc("fill");
+
+    const size_t size = 1000000;
+    compare(vm, "float buffer, 1M elements", vm.callFunc(fill, vm, vm.newBuffer<float>(size)));
+    compare(vm, "double buffer, 1M elements", vm.callFunc(fill, vm, vm.newBuffer<double>(size)));
+    compare(vm, "array, 1M elements", vm.callFunc(fill, vm, vm.newArray(std::vector<float>(size))));
+    return 0;
+}
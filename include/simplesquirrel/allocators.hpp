@@ -17,6 +17,29 @@ namespace ssq {
             return 0;
         }
 
+        // Copies the C++ object of a bound class instance, null if not copy constructible
+        struct ClassCopier {
+            SQUserPointer (*copy)(SQUserPointer ptr);
+            SQRELEASEHOOK release;
+        };
+
+        template<class T>
+        static SQUserPointer classCopy(SQUserPointer ptr) {
+            return new T(*static_cast<T*>(ptr));
+        }
+
+        template<class T>
+        inline typename std::enable_if<std::is_copy_constructible<T>::value, ClassCopier>::type
+        makeClassCopier() {
+            return ClassCopier{&classCopy<T>, &classDestructor<T>};
+        }
+
+        template<class T>
+        inline typename std::enable_if<!std::is_copy_constructible<T>::value, ClassCopier>::type
+        makeClassCopier() {
+            return ClassCopier{nullptr, nullptr};
+        }
+
         template<class T>
         static SQInteger classPtrDestructor(SQUserPointer ptr, SQInteger size) {
             T** p = static_cast<T**>(ptr);
@@ -3,11 +3,13 @@
 #include "allocators.hpp"
 #include "exceptions.hpp"
 #include "exposable_class.hpp"
+#include "object_ref.hpp"
 
 #include <squirrel.h>
 #include <cassert>
 #include <iostream>
 #include <typeinfo>
+#include <type_traits>
 #include <vector>
 
 namespace ssq {
@@ -15,27 +17,35 @@ namespace ssq {
     class Enum;
     class VM;
     class SqWeakRef;
+    template<typename T> class Buffer;
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
     namespace detail {
-        SSQ_API void addClassObj(size_t hashCode, const HSQOBJECT& obj);
-        SSQ_API const HSQOBJECT& getClassObj(size_t hashCode);
+        template<typename T> struct IsBuffer: std::false_type {};
+        template<typename T> struct IsBuffer<Buffer<T>>: std::true_type {};
+
+        template<typename T>
+        inline T popBuffer(HSQUIRRELVM vm, SQInteger index);
+        SSQ_API void addClassObj(HSQUIRRELVM vm, size_t hashCode, const HSQOBJECT& obj);
+        SSQ_API const HSQOBJECT& getClassObj(HSQUIRRELVM vm, size_t hashCode);
+        SSQ_API void addClassCopier(HSQUIRRELVM vm, size_t hashCode, const ClassCopier& copier);
+        SSQ_API const ClassCopier* getClassCopier(HSQUIRRELVM vm, size_t hashCode);
 
         inline void checkType(HSQUIRRELVM vm, SQInteger index, SQObjectType expected) {
             auto type = sq_gettype(vm, index);
             if (expected == OT_CLOSURE) {
                 if (type != OT_CLOSURE && type != OT_NATIVECLOSURE)
-                  throw TypeException("bad cast", typeToStr(Type(expected)), typeToStr(Type(type)));
+                  throw TypeException(StaticText("bad cast"), StaticText(typeToStr(Type(expected))), StaticText(typeToStr(Type(type))));
                 return;
             }
             if (type != expected)
-              throw TypeException("bad cast", typeToStr(Type(expected)), typeToStr(Type(type)));
+              throw TypeException(StaticText("bad cast"), StaticText(typeToStr(Type(expected))), StaticText(typeToStr(Type(type))));
         }
 
         inline void checkTypeNumber(HSQUIRRELVM vm, SQInteger index, bool allow_bool) {
             auto type = sq_gettype(vm, index);
             if ((allow_bool ? type != OT_BOOL : true) && type != OT_INTEGER && type != OT_FLOAT)
-              throw TypeException("bad cast", allow_bool ? "BOOL|INTEGER|FLOAT" : "INTEGER|FLOAT", typeToStr(Type(type)));
+              throw TypeException(StaticText("bad cast"), StaticText(allow_bool ? "BOOL|INTEGER|FLOAT" : "INTEGER|FLOAT"), StaticText(typeToStr(Type(type))));
         }
 
 
@@ -51,13 +61,18 @@ namespace ssq {
         }
 
         template<typename T>
-        inline T popValue(HSQUIRRELVM vm, SQInteger index){
+        inline T popValue(HSQUIRRELVM vm, SQInteger index, std::true_type) {
+            return popBuffer<T>(vm, index);
+        }
+
+        template<typename T>
+        inline T popValue(HSQUIRRELVM vm, SQInteger index, std::false_type) {
             const SQObjectType type = sq_gettype(vm, index);
             SQUserPointer ptr;
             if(type == OT_USERDATA) {
                 SQUserPointer typetag;
                 if (SQ_FAILED(sq_getuserdata(vm, index, &ptr, &typetag))) {
-                    throw RuntimeException(vm, "Could not get instance from Squirrel stack!");
+                    throw RuntimeException(vm, StaticText("Could not get instance from Squirrel stack!"));
                 }
 
                 if(reinterpret_cast<size_t>(typetag) != typeid(T).hash_code()) {
@@ -69,33 +84,38 @@ namespace ssq {
             } 
             else if(type == OT_INSTANCE) {
                 if (SQ_FAILED(sq_getinstanceup(vm, index, &ptr, nullptr, SQTrue))) {
-                    throw RuntimeException(vm, "Could not get instance from Squirrel stack!");
+                    throw RuntimeException(vm, StaticText("Could not get instance from Squirrel stack!"));
                 }
 
                 return T(*popInstance<T*>(vm, ptr));
             }
             else {
-                throw TypeException("bad cast", "INSTANCE", typeToStr(Type(type)));
+                throw TypeException(StaticText("bad cast"), StaticText("INSTANCE"), StaticText(typeToStr(Type(type))));
             }
         }
 
+        template<typename T>
+        inline T popValue(HSQUIRRELVM vm, SQInteger index){
+            return popValue<T>(vm, index, IsBuffer<T>());
+        }
+
         template<typename T>
         inline T popPointer(HSQUIRRELVM vm, SQInteger index) {
             const SQObjectType type = sq_gettype(vm, index);
             SQUserPointer ptr;
             if(type == OT_USERPOINTER) {
                 if (SQ_FAILED(sq_getuserpointer(vm, index, &ptr))) {
-                    throw RuntimeException(vm, "Could not get instance from Squirrel stack!");
+                    throw RuntimeException(vm, StaticText("Could not get instance from Squirrel stack!"));
                 }
                 return reinterpret_cast<T>(ptr);
             }
             else {
                 if (type != OT_INSTANCE) {
-                    throw TypeException("bad cast", typeToStr(Type(OT_INSTANCE)), typeToStr(Type(type)));
+                    throw TypeException(StaticText("bad cast"), StaticText(typeToStr(Type(OT_INSTANCE))), StaticText(typeToStr(Type(type))));
                 }
 
                 if (SQ_FAILED(sq_getinstanceup(vm, index, &ptr, nullptr, SQTrue))) {
-                    throw RuntimeException(vm, "Could not get instance from Squirrel stack!");
+                    throw RuntimeException(vm, StaticText("Could not get instance from Squirrel stack!"));
                 }
 
                 return popInstance<T>(vm, ptr);
@@ -110,16 +130,23 @@ namespace ssq {
         template<>
         inline Object popValue(HSQUIRRELVM vm, SQInteger index){
             Object val(vm);
-            if (SQ_FAILED(sq_getstackobj(vm, index, &val.getRaw()))) throw RuntimeException(vm, "Could not get Object from squirrel stack");
+            if (SQ_FAILED(sq_getstackobj(vm, index, &val.getRaw()))) throw RuntimeException(vm, StaticText("Could not get Object from squirrel stack"));
             sq_addref(vm, &val.getRaw());
             return val;
         }
 
+        template<>
+        inline ObjectRef popValue(HSQUIRRELVM vm, SQInteger index){
+            HSQOBJECT val;
+            if (SQ_FAILED(sq_getstackobj(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get Object from squirrel stack"));
+            return ObjectRef(vm, val);
+        }
+
         template<>
         inline char popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQInteger val;
-            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, "Could not get char from squirrel stack");
+            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get char from squirrel stack"));
             return static_cast<char>(val);
         }
 
@@ -127,7 +154,7 @@ namespace ssq {
         inline signed char popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQInteger val;
-            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, "Could not get signed char from squirrel stack");
+            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get signed char from squirrel stack"));
             return static_cast<signed char>(val);
         }
 
@@ -135,7 +162,7 @@ namespace ssq {
         inline short popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQInteger val;
-            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, "Could not get short from squirrel stack");
+            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get short from squirrel stack"));
             return static_cast<short>(val);
         }
 
@@ -143,7 +170,7 @@ namespace ssq {
         inline int popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQInteger val;
-            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, "Could not get int from squirrel stack");
+            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get int from squirrel stack"));
             return static_cast<int>(val);
         }
 
@@ -151,7 +178,7 @@ namespace ssq {
         inline long popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQInteger val;
-            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, "Could not get long from squirrel stack");
+            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get long from squirrel stack"));
             return static_cast<long>(val);
         }
 
@@ -159,7 +186,7 @@ namespace ssq {
         inline unsigned char popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQInteger val;
-            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, "Could not get unsigned char from squirrel stack");
+            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get unsigned char from squirrel stack"));
             return static_cast<unsigned char>(val);
         }
 
@@ -167,7 +194,7 @@ namespace ssq {
         inline unsigned short popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQInteger val;
-            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, "Could not get unsigned short from squirrel stack");
+            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get unsigned short from squirrel stack"));
             return static_cast<unsigned short>(val);
         }
 
@@ -175,7 +202,7 @@ namespace ssq {
         inline unsigned int popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQInteger val;
-            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, "Could not get unsigned int from squirrel stack");
+            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get unsigned int from squirrel stack"));
             return static_cast<unsigned int>(val);
         }
 
@@ -183,7 +210,7 @@ namespace ssq {
         inline unsigned long popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQInteger val;
-            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, "Could not get unsigned long from squirrel stack");
+            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get unsigned long from squirrel stack"));
             return static_cast<unsigned long>(val);
         }
 
@@ -192,7 +219,7 @@ namespace ssq {
         inline long long popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQInteger val;
-            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, "Could not get long long from squirrel stack");
+            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get long long from squirrel stack"));
             return static_cast<long long>(val);
         }
 
@@ -200,7 +227,7 @@ namespace ssq {
         inline unsigned long long popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQInteger val;
-            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, "Could not get unsigned long long from squirrel stack");
+            if (SQ_FAILED(sq_getinteger(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get unsigned long long from squirrel stack"));
             return static_cast<unsigned long long>(val);
         }
 #endif
@@ -210,7 +237,7 @@ namespace ssq {
         inline double popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, false);
             SQFloat val;
-            if (SQ_FAILED(sq_getfloat(vm, index, &val))) throw RuntimeException(vm, "Could not get double from squirrel stack");
+            if (SQ_FAILED(sq_getfloat(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get double from squirrel stack"));
             return static_cast<double>(val);
         }
 #endif
@@ -219,7 +246,7 @@ namespace ssq {
         inline float popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, false);
             SQFloat val;
-            if (SQ_FAILED(sq_getfloat(vm, index, &val))) throw RuntimeException(vm, "Could not get float from squirrel stack");
+            if (SQ_FAILED(sq_getfloat(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get float from squirrel stack"));
             return static_cast<float>(val);
         }
 
@@ -227,7 +254,7 @@ namespace ssq {
         inline bool popValue(HSQUIRRELVM vm, SQInteger index){
             checkTypeNumber(vm, index, true);
             SQBool val;
-            if (SQ_FAILED(sq_getbool(vm, index, &val))) throw RuntimeException(vm, "Could not get bool from squirrel stack");
+            if (SQ_FAILED(sq_getbool(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get bool from squirrel stack"));
             return val == 1;
         }
 
@@ -236,7 +263,7 @@ namespace ssq {
         inline std::wstring popValue(HSQUIRRELVM vm, SQInteger index){
             checkType(vm, index, OT_STRING);
             const SQChar* val;
-            if (SQ_FAILED(sq_getstring(vm, index, &val))) throw RuntimeException(vm, "Could not get string from squirrel stack");
+            if (SQ_FAILED(sq_getstring(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get string from squirrel stack"));
 
             if(val == nullptr)
             {
@@ -251,7 +278,7 @@ namespace ssq {
         inline std::string popValue(HSQUIRRELVM vm, SQInteger index){
             checkType(vm, index, OT_STRING);
             const SQChar* val;
-            if (SQ_FAILED(sq_getstring(vm, index, &val))) throw RuntimeException(vm, "Could not get string from squirrel stack");
+            if (SQ_FAILED(sq_getstring(vm, index, &val))) throw RuntimeException(vm, StaticText("Could not get string from squirrel stack"));
 
             if(val == nullptr)
             {
@@ -306,7 +333,7 @@ namespace ssq {
         inline void pushByCopy(HSQUIRRELVM vm, const T& value) {
             static const auto hashCode = typeid(T*).hash_code();
             try {
-                sq_pushobject(vm, getClassObj(hashCode));
+                sq_pushobject(vm, getClassObj(vm, hashCode));
                 sq_createinstance(vm, -1);
                 sq_remove(vm, -2);
 
@@ -322,12 +349,23 @@ namespace ssq {
             }
         }
 
+        SSQ_API void pushRaw(HSQUIRRELVM vm, const Object& value);
+
         template<typename T>
-        inline void pushValue(HSQUIRRELVM vm, const T& value){
+        inline void pushValue(HSQUIRRELVM vm, const T& value, std::true_type) {
+            pushRaw(vm, static_cast<const Object&>(value));
+        }
+
+        template<typename T>
+        inline void pushValue(HSQUIRRELVM vm, const T& value, std::false_type) {
             pushByCopy<T>(vm, value);
         }
 
-        SSQ_API void pushRaw(HSQUIRRELVM vm, const Object& value);
+        template<typename T>
+        inline void pushValue(HSQUIRRELVM vm, const T& value){
+            pushValue<T>(vm, value, IsBuffer<T>());
+        }
+
         SSQ_API void pushRaw(HSQUIRRELVM vm, const Class& value);
         SSQ_API void pushRaw(HSQUIRRELVM vm, const Instance& value);
         SSQ_API void pushRaw(HSQUIRRELVM vm, const Table& value);
@@ -352,6 +390,11 @@ namespace ssq {
             pushRaw(vm, value);
         }
 
+        template<>
+        inline void pushValue(HSQUIRRELVM vm, const ObjectRef& value){
+            sq_pushobject(vm, value.getRaw());
+        }
+
         template<>
         inline void pushValue(HSQUIRRELVM vm, const Class& value){
             pushRaw(vm, value);
@@ -481,7 +524,7 @@ namespace ssq {
             }
             else {
                 try {
-                    sq_pushobject(vm, getClassObj(hashCode));
+                    sq_pushobject(vm, getClassObj(vm, hashCode));
                     sq_createinstance(vm, -1);
                     sq_remove(vm, -2);
                     sq_setinstanceup(vm, -1, reinterpret_cast<SQUserPointer>(value));
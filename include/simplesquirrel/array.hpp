@@ -19,12 +19,13 @@ namespace ssq {
         /**
         * @brief Destructor
         */
-        virtual ~Array() override = default;
+        ~Array() = default;
         /**
         * @brief Constructs array out of std::vector
         */
         template<typename T>
         Array(HSQUIRRELVM vm_, const std::vector<T>& vector):Object(vm_) {
+            StackGuard guard(vm);
             sq_newarray(vm, 0);
             sq_getstackobj(vm, -1, &obj);
             sq_addref(vm, &obj);
@@ -32,12 +33,9 @@ namespace ssq {
             for(const auto& val : vector) {
                 detail::push(vm, val);
                 if(SQ_FAILED(sq_arrayappend(vm, -2))) {
-                    sq_pop(vm, 2);
                     throw RuntimeException(vm, "Failed to push value to the back of array!");
                 }
             }
-
-            sq_pop(vm, 1); // Pop array
         }
         /**
         * @brief Converts Object to Array
@@ -61,38 +59,29 @@ namespace ssq {
         */
         template<typename T>
         void push(const T& value) {
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
             detail::push(vm, value);
             if(SQ_FAILED(sq_arrayappend(vm, -2))) {
-                sq_pop(vm, 2);
                 throw RuntimeException(vm, "Failed to push value to the back of array!");
             }
-            sq_pop(vm, 1);
         }
         /**
         * @brief Pops an element from the back of the array and returns it
         */
         template<typename T>
         T popAndGet() {
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
             auto s = sq_getsize(vm, -1);
             if(s == 0) {
-                sq_pop(vm, 1);
                 throw RuntimeException(vm, "Failed to pop empty array!");
             }
 
-            try {
-                if(SQ_FAILED(sq_arraypop(vm, -1, true))) {
-                    sq_pop(vm, 1);
-                    throw RuntimeException(vm, "Failed to pop value from the back of array!");
-                }
-                T ret(detail::pop<T>(vm, -1));
-                sq_pop(vm, 1);
-                return std::move(ret);
-            } catch (...) {
-                sq_pop(vm, 1);
-                std::rethrow_exception(std::current_exception());
+            if(SQ_FAILED(sq_arraypop(vm, -1, true))) {
+                throw RuntimeException(vm, "Failed to pop value from the back of array!");
             }
+            return detail::pop<T>(vm, -1);
         }
         /**
         * @brief Pops an element from the back of the array
@@ -108,25 +97,28 @@ namespace ssq {
         */
         template<typename T>
         T get(size_t index) {
+            return tryGet<T>(index).unwrap(vm);
+        }
+        /**
+        * @brief Returns an element from the specific index without throwing
+        * @returns ErrorCode::RUNTIME_ERROR error if the index is out of bounds, or
+        * ErrorCode::TYPE_MISMATCH error if the element is not a type of T
+        */
+        template<typename T>
+        Result<T> tryGet(size_t index) {
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
             auto s = static_cast<size_t>(sq_getsize(vm, -1));
             if(index >= s) {
-                sq_pop(vm, 1);
-                throw RuntimeException(vm, "Failed to get out-of-bounds element from array!");
+                return Error(ErrorCode::RUNTIME_ERROR, "Failed to get out-of-bounds element from array!");
             }
             detail::push(vm, index);
             if(SQ_FAILED(sq_get(vm, -2))) {
-                sq_pop(vm, 1);
-                throw RuntimeException(vm, "Failed to get value from array!");
-            }
-            try {
-                T ret(detail::pop<T>(vm, -1));
-                sq_pop(vm, 2);
-                return std::move(ret);
-            } catch (...) {
-                sq_pop(vm, 2);
-                std::rethrow_exception(std::current_exception());
+                return Error(ErrorCode::RUNTIME_ERROR, "Failed to get value from array!");
             }
+            Result<void> checked = detail::checkExpectedType<T>(vm, -1);
+            if(!checked) return checked.getError();
+            return detail::pop<T>(vm, -1);
         }
         /**
          * Returns the element at the start of the array
@@ -152,19 +144,26 @@ namespace ssq {
         */
         template<typename T>
         void set(size_t index, const T& value) {
+            trySet(index, value).unwrap(vm);
+        }
+        /**
+        * @brief Sets an element at the specific index without throwing
+        * @returns ErrorCode::RUNTIME_ERROR error if the index is out of bounds or element cannot be set
+        */
+        template<typename T>
+        Result<void> trySet(size_t index, const T& value) {
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
             auto s = static_cast<size_t>(sq_getsize(vm, -1));
             if(index >= s) {
-                sq_pop(vm, 1);
-                throw RuntimeException(vm, "Failed to get out-of-bounds element from array!");
+                return Error(ErrorCode::RUNTIME_ERROR, "Failed to get out-of-bounds element from array!");
             }
             detail::push(vm, index);
             detail::push(vm, value);
             if(SQ_FAILED(sq_set(vm, -3))) {
-                sq_pop(vm, 1);
-                throw RuntimeException(vm, "Failed to set value in array!");
+                return Error(ErrorCode::RUNTIME_ERROR, "Failed to set value in array!");
             }
-            sq_pop(vm, 1);
+            return Result<void>();
         }
         /**
          * @brief Converts this array to std::vector of objects
@@ -175,7 +174,7 @@ namespace ssq {
          */
         template<typename T>
         std::vector<T> convert() const {
-            const SQInteger old_top = sq_gettop(vm);
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
             size_t s = static_cast<size_t>(sq_getsize(vm, -1));
 
@@ -191,7 +190,6 @@ namespace ssq {
                 sq_pop(vm, 2); // pop key and value of this iteration
             }
 
-            sq_settop(vm, old_top);
             return ret;
         }
         /**
@@ -209,7 +207,7 @@ namespace ssq {
         inline Array popValue(HSQUIRRELVM vm, SQInteger index){
             checkType(vm, index, OT_ARRAY);
             Array val(vm);
-            if (SQ_FAILED(sq_getstackobj(vm, index, &val.getRaw()))) throw RuntimeException(vm, "Could not get Array from Squirrel stack!");
+            if (SQ_FAILED(sq_getstackobj(vm, index, &val.getRaw()))) throw RuntimeException(vm, StaticText("Could not get Array from Squirrel stack!"));
             sq_addref(vm, &val.getRaw());
             return val;
         }
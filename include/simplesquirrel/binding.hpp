@@ -52,11 +52,27 @@ namespace ssq {
         }
 
 
+        // Raises the exception in the VM, formatting the message on the stack if possible
+        inline SQInteger throwError(HSQUIRRELVM vm, const std::exception& e) {
+            const Exception* ex = dynamic_cast<const Exception*>(&e);
+            if (ex == nullptr) return sq_throwerror(vm, e.what());
+            char buffer[512];
+            if (ex->format(buffer, sizeof(buffer)) >= sizeof(buffer)) return sq_throwerror(vm, e.what());
+            return sq_throwerror(vm, buffer);
+        }
+
+        // Raises the error of a VM whose budget is exhausted, see VM::setInstructionBudget()
+        SSQ_API bool raiseInterrupt(HSQUIRRELVM vm);
+
         template<typename Ret, typename... Args>
-        static void bindUserData(HSQUIRRELVM vm, const std::function<Ret(Args...)>& func) {
+        static FuncPtr<Ret(Args...)>* bindUserData(HSQUIRRELVM vm, const std::function<Ret(Args...)>& func) {
             auto funcStruct = reinterpret_cast<detail::FuncPtr<Ret(Args...)>*>(sq_newuserdata(vm, sizeof(detail::FuncPtr<Ret(Args...)>)));
             funcStruct->ptr = new std::function<Ret(Args...)>(func);
+#ifdef SSQ_NATIVE_STATS
+            funcStruct->stats = nullptr;
+#endif
             sq_setreleasehook(vm, -1, &detail::funcReleaseHook<Ret, Args...>);
+            return funcStruct;
         }
 
         template<typename... Args>
@@ -114,11 +130,13 @@ namespace ssq {
         template<class T, class... Args, class... DefaultArgs>
         struct classAllocatorBinding<T, DefaultArgumentsImpl<DefaultArgs...>, Args...> {
             static SQInteger call(HSQUIRRELVM vm) {
-                try {
-                    FuncPtr<T*(Args...)>* funcPtr;
-                    sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
-                    sq_pop(vm, 1);
+                if (raiseInterrupt(vm)) return SQ_ERROR;
+                FuncPtr<T*(Args...)>* funcPtr;
+                sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
+                sq_pop(vm, 1);
 
+                NativeCallScope scope(funcPtr);
+                try {
                     T* p = detail::callFunc<1, DefaultArgs...>(vm, funcPtr);
                     sq_setinstanceup(vm, 1, p);
                     sq_setreleasehook(vm, 1, &detail::classDestructor<T>);
@@ -129,7 +147,8 @@ namespace ssq {
 
                     return sizeof...(Args);
                 } catch (const std::exception& e) {
-                    return sq_throwerror(vm, e.what());
+                    scope.fail();
+                    return throwError(vm, e);
                 }
             }
         };
@@ -140,11 +159,13 @@ namespace ssq {
         template<class T, class... Args, class... DefaultArgs>
         struct classAllocatorNoReleaseBinding<T, DefaultArgumentsImpl<DefaultArgs...>, Args...> {
             static SQInteger call(HSQUIRRELVM vm) {
-                try {
-                    FuncPtr<T*(Args...)>* funcPtr;
-                    sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
-                    sq_pop(vm, 1);
+                if (raiseInterrupt(vm)) return SQ_ERROR;
+                FuncPtr<T*(Args...)>* funcPtr;
+                sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
+                sq_pop(vm, 1);
 
+                NativeCallScope scope(funcPtr);
+                try {
                     T* p = detail::callFunc<1, DefaultArgs...>(vm, funcPtr);
                     sq_setinstanceup(vm, 1, p);
 
@@ -154,7 +175,8 @@ namespace ssq {
 
                     return sizeof...(Args);
                 } catch (const std::exception& e) {
-                    return sq_throwerror(vm, e.what());
+                    scope.fail();
+                    return throwError(vm, e);
                 }
             }
         };
@@ -166,30 +188,36 @@ namespace ssq {
         template<int offset, typename R, typename... Args, typename... DefaultArgs>
         struct funcBinding<offset, R, DefaultArgumentsImpl<DefaultArgs...>, Args...> {
             static SQInteger call(HSQUIRRELVM vm) {
-                try {
-                    FuncPtr<R(Args...)>* funcPtr;
-                    sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
-                    sq_pop(vm, 1);
+                if (raiseInterrupt(vm)) return SQ_ERROR;
+                FuncPtr<R(Args...)>* funcPtr;
+                sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
+                sq_pop(vm, 1);
 
+                NativeCallScope scope(funcPtr);
+                try {
                     push(vm, std::forward<R>(detail::callFunc<offset, DefaultArgs...>(vm, funcPtr)));
                     return 1;
                 } catch (const std::exception& e) {
-                    return sq_throwerror(vm, e.what());
+                    scope.fail();
+                    return throwError(vm, e);
                 }
             }
         };
         template<int offset, typename R, typename... Args, typename... DefaultArgs>
         struct funcBinding<offset, std::vector<R>, DefaultArgumentsImpl<DefaultArgs...>, Args...> {
             static SQInteger call(HSQUIRRELVM vm) {
-                try {
-                    FuncPtr<std::vector<R>(Args...)>* funcPtr;
-                    sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
-                    sq_pop(vm, 1);
+                if (raiseInterrupt(vm)) return SQ_ERROR;
+                FuncPtr<std::vector<R>(Args...)>* funcPtr;
+                sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
+                sq_pop(vm, 1);
 
+                NativeCallScope scope(funcPtr);
+                try {
                     push(vm, std::forward<std::vector<R>>(detail::callFunc<offset, DefaultArgs...>(vm, funcPtr)));
                     return 1;
                 } catch (const std::exception& e) {
-                    return sq_throwerror(vm, e.what());
+                    scope.fail();
+                    return throwError(vm, e);
                 }
             }
         };
@@ -197,15 +225,18 @@ namespace ssq {
         template<int offset, typename... Args, typename... DefaultArgs>
         struct funcBinding<offset, void, DefaultArgumentsImpl<DefaultArgs...>, Args...> {
             static SQInteger call(HSQUIRRELVM vm) {
-                try {
-                    FuncPtr<void(Args...)>* funcPtr;
-                    sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
-                    sq_pop(vm, 1);
+                if (raiseInterrupt(vm)) return SQ_ERROR;
+                FuncPtr<void(Args...)>* funcPtr;
+                sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
+                sq_pop(vm, 1);
 
+                NativeCallScope scope(funcPtr);
+                try {
                     detail::callFunc<offset, DefaultArgs...>(vm, funcPtr);
                     return 0;
                 } catch (const std::exception& e) {
-                    return sq_throwerror(vm, e.what());
+                    scope.fail();
+                    return throwError(vm, e);
                 }
             }
         };
@@ -213,18 +244,187 @@ namespace ssq {
         template<int offset, typename... Args, typename... DefaultArgs>
         struct funcBinding<offset, SQInteger, DefaultArgumentsImpl<DefaultArgs...>, Args...> {
             static SQInteger call(HSQUIRRELVM vm) {
-                try {
-                    FuncPtr<SQInteger(Args...)>* funcPtr;
-                    sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
-                    sq_pop(vm, 1);
+                if (raiseInterrupt(vm)) return SQ_ERROR;
+                FuncPtr<SQInteger(Args...)>* funcPtr;
+                sq_getuserdata(vm, -1, reinterpret_cast<void**>(&funcPtr), nullptr);
+                sq_pop(vm, 1);
 
+                NativeCallScope scope(funcPtr);
+                try {
                     return detail::callFunc<offset, DefaultArgs...>(vm, funcPtr);
                 } catch (const std::exception& e) {
-                    return sq_throwerror(vm, e.what());
+                    scope.fail();
+                    return throwError(vm, e);
+                }
+            }
+        };
+
+        /* Functions called without any bound user data */
+        template<typename Binding, typename R>
+        struct directCall {
+            static SQInteger call(HSQUIRRELVM vm) {
+                push(vm, Binding::invoke(vm));
+                return 1;
+            }
+        };
+        template<typename Binding>
+        struct directCall<Binding, void> {
+            static SQInteger call(HSQUIRRELVM vm) {
+                Binding::invoke(vm);
+                return 0;
+            }
+        };
+        template<typename Binding>
+        struct directCall<Binding, SQInteger> {
+            static SQInteger call(HSQUIRRELVM vm) {
+                return Binding::invoke(vm);
+            }
+        };
+
+        template<typename F, F method>
+        struct methodBinding;
+
+        template<typename T, typename R, typename... Args, R(T::*method)(Args...)>
+        struct methodBinding<R(T::*)(Args...), method> {
+            typedef T Class;
+            static const std::size_t nparams = sizeof...(Args);
+
+            template<int... Is>
+            static R invoke(HSQUIRRELVM vm, index_list<Is...>) {
+                T* self = detail::pop<T*>(vm, 1);
+                return (self->*method)(detail::pop<typename std::remove_reference<Args>::type>(vm, Is)...);
+            }
+            static R invoke(HSQUIRRELVM vm) {
+                return invoke(vm, index_range<2, sizeof...(Args) + 2>());
+            }
+            static SQInteger call(HSQUIRRELVM vm) {
+                if (raiseInterrupt(vm)) return SQ_ERROR;
+                try {
+                    return directCall<methodBinding, R>::call(vm);
+                } catch (const std::exception& e) {
+                    return throwError(vm, e);
                 }
             }
+            static void params(std::string& str) {
+                paramPacker<T*, Args...>(str);
+            }
         };
 
+        template<typename T, typename R, typename... Args, R(T::*method)(Args...) const>
+        struct methodBinding<R(T::*)(Args...) const, method> {
+            typedef T Class;
+            static const std::size_t nparams = sizeof...(Args);
+
+            template<int... Is>
+            static R invoke(HSQUIRRELVM vm, index_list<Is...>) {
+                const T* self = detail::pop<T*>(vm, 1);
+                return (self->*method)(detail::pop<typename std::remove_reference<Args>::type>(vm, Is)...);
+            }
+            static R invoke(HSQUIRRELVM vm) {
+                return invoke(vm, index_range<2, sizeof...(Args) + 2>());
+            }
+            static SQInteger call(HSQUIRRELVM vm) {
+                if (raiseInterrupt(vm)) return SQ_ERROR;
+                try {
+                    return directCall<methodBinding, R>::call(vm);
+                } catch (const std::exception& e) {
+                    return throwError(vm, e);
+                }
+            }
+            static void params(std::string& str) {
+                paramPacker<T*, Args...>(str);
+            }
+        };
+
+        /* Plain function pointers, the parameters are taken from index 2 unless the first is the VM */
+        template<typename... Args>
+        struct pointerParams {
+            static const int offset = 2;
+            static const std::size_t count = sizeof...(Args);
+            static void pack(std::string& str) {
+                paramPacker<void, Args...>(str);
+            }
+        };
+        template<typename... Args>
+        struct pointerParams<HSQUIRRELVM, Args...> {
+            static const int offset = 1;
+            static const std::size_t count = sizeof...(Args);
+            static void pack(std::string& str) {
+                paramPacker<void, Args...>(str);
+            }
+        };
+
+        // Every object of a captureless lambda type converts to the same function pointer,
+        // which is stored once per type when the first one is bound
+        template<typename F, typename Ptr>
+        struct statelessSource {
+            static Ptr init(const F* func = nullptr) {
+                static const Ptr ptr = *func;
+                return ptr;
+            }
+            static Ptr get(HSQUIRRELVM) {
+                return init();
+            }
+        };
+
+        // Free functions are passed as the only free variable of the closure
+        template<typename Ptr>
+        struct pointerSource {
+            static Ptr get(HSQUIRRELVM vm) {
+                SQUserPointer ptr;
+                sq_getuserpointer(vm, -1, &ptr);
+                sq_pop(vm, 1);
+                return reinterpret_cast<Ptr>(ptr);
+            }
+        };
+
+        template<typename Source, typename Ptr>
+        struct pointerBinding;
+
+        template<typename Source, typename R, typename... Args>
+        struct pointerBinding<Source, R(*)(Args...)> {
+            typedef pointerParams<typename std::remove_cv<Args>::type...> Params;
+            static const std::size_t nparams = Params::count;
+
+            template<int... Is>
+            static R invoke(HSQUIRRELVM vm, R(*func)(Args...), index_list<Is...>) {
+                (void)vm; // Fix unused parameter warning.
+                return func(detail::pop<typename std::remove_reference<Args>::type>(vm, Is)...);
+            }
+            static R invoke(HSQUIRRELVM vm) {
+                return invoke(vm, Source::get(vm), index_range<Params::offset, sizeof...(Args) + Params::offset>());
+            }
+            static SQInteger call(HSQUIRRELVM vm) {
+                if (raiseInterrupt(vm)) return SQ_ERROR;
+                try {
+                    return directCall<pointerBinding, R>::call(vm);
+                } catch (const std::exception& e) {
+                    return throwError(vm, e);
+                }
+            }
+            static void params(std::string& str) {
+                Params::pack(str);
+            }
+        };
+
+        template<typename F>
+        struct isStateless: std::integral_constant<bool, std::is_class<F>::value && std::is_empty<F>::value &&
+            std::is_convertible<F, typename function_traits<F>::pointer_type>::value> {};
+
+        // 0 = std::function, 1 = captureless lambda, 2 = free function. Callables with
+        // default arguments, and all of them when counting native calls, use std::function.
+        template<typename F, typename... DefaultArgs>
+        struct callableKind: std::integral_constant<int,
+#ifdef SSQ_NATIVE_STATS
+            0
+#else
+            (sizeof...(DefaultArgs) > 0 ? 0 :
+            std::is_pointer<F>::value && std::is_function<typename std::remove_pointer<F>::type>::value ? 2 :
+            isStateless<F>::value ? 1 : 0)
+#endif
+        > {};
+
+
 
         template<typename T, typename... Args, typename... DefaultArgs>
         static Object addClass(HSQUIRRELVM vm, const char* name, const std::function<T*(Args...)>& allocator,
@@ -250,7 +450,9 @@ namespace ssq {
 
             HSQOBJECT obj;
             sq_getstackobj(vm, -1, &obj);
-            addClassObj(hashCode, obj);
+            addClassObj(vm, hashCode, obj);
+            addClassCopier(vm, hashCode, makeClassCopier<T>());
+            attachNativeStatsClass(vm, hashCode, name);
 
             sq_getstackobj(vm, -1, &clsObj.getRaw());
             sq_addref(vm, &clsObj.getRaw());
@@ -258,7 +460,7 @@ namespace ssq {
             sq_settypetag(vm, -1, reinterpret_cast<SQUserPointer>(hashCode));
 
             sq_pushstring(vm, "constructor", -1);
-            bindUserData<T*>(vm, allocator);
+            attachNativeStats(vm, bindUserData<T*>(vm, allocator), "constructor", -3);
             bindUserData(vm, std::move(defaultArgs));
 
             std::string params;
@@ -305,7 +507,8 @@ namespace ssq {
 
             HSQOBJECT obj;
             sq_getstackobj(vm, -1, &obj);
-            addClassObj(hashCode, obj);
+            addClassObj(vm, hashCode, obj);
+            attachNativeStatsClass(vm, hashCode, name);
 
             sq_getstackobj(vm, -1, &clsObj.getRaw());
             sq_addref(vm, &clsObj.getRaw());
@@ -329,7 +532,7 @@ namespace ssq {
 
             sq_pushstring(vm, name, strlen(name));
 
-            bindUserData(vm, func);
+            attachNativeStats(vm, bindUserData(vm, func), name, -3);
             bindUserData(vm, std::move(defaultArgs));
 
             std::string params;
@@ -349,7 +552,7 @@ namespace ssq {
 
             sq_pushstring(vm, name, strlen(name));
 
-            bindUserData(vm, func);
+            attachNativeStats(vm, bindUserData(vm, func), name, -3);
             bindUserData(vm, std::move(defaultArgs));
 
             std::string params;
@@ -362,6 +565,47 @@ namespace ssq {
             }
         }
 
+
+        template<typename Binding>
+        static void addDirectFunc(HSQUIRRELVM vm, SQUnsignedInteger nfreevars) {
+            std::string params;
+            Binding::params(params);
+
+            sq_newclosure(vm, &Binding::call, nfreevars);
+            sq_setparamscheck(vm, Binding::nparams + 1, Binding::nparams + 1, params.c_str());
+            if(SQ_FAILED(sq_newslot(vm, -3, SQFalse))) {
+                throw RuntimeException(vm, "Failed to bind function!");
+            }
+        }
+        template<typename F, typename... DefaultArgs>
+        static void addCallable(HSQUIRRELVM vm, const char* name, const F& func,
+                                DefaultArgumentsImpl<DefaultArgs...> defaultArgs, std::integral_constant<int, 0>) {
+            addFunc(vm, name, make_function(func), std::move(defaultArgs));
+        }
+        template<typename F>
+        static void addCallable(HSQUIRRELVM vm, const char* name, const F& func,
+                                DefaultArgumentsImpl<>, std::integral_constant<int, 1>) {
+            typedef typename function_traits<F>::pointer_type Ptr;
+            statelessSource<F, Ptr>::init(&func);
+
+            sq_pushstring(vm, name, strlen(name));
+            addDirectFunc<pointerBinding<statelessSource<F, Ptr>, Ptr>>(vm, 0);
+        }
+        template<typename F>
+        static void addCallable(HSQUIRRELVM vm, const char* name, const F& func,
+                                DefaultArgumentsImpl<>, std::integral_constant<int, 2>) {
+            sq_pushstring(vm, name, strlen(name));
+            sq_pushuserpointer(vm, reinterpret_cast<SQUserPointer>(func));
+            addDirectFunc<pointerBinding<pointerSource<F>, F>>(vm, 1);
+        }
+        // Binds lambdas and function pointers, without std::function where possible
+        template<typename F, typename... DefaultArgs>
+        static void addCallable(HSQUIRRELVM vm, const char* name, const F& func, DefaultArgumentsImpl<DefaultArgs...> defaultArgs) {
+            // Functions passed without & decay to function pointers
+            typedef typename std::decay<F>::type Callable;
+            addCallable<Callable>(vm, name, func, std::move(defaultArgs), callableKind<Callable, DefaultArgs...>());
+        }
+
         template<typename R, typename... Args, typename... DefaultArgs>
         static void addMemberFunc(HSQUIRRELVM vm, const char* name, const std::function<R(Args...)>& func,
                                   DefaultArgumentsImpl<DefaultArgs...> defaultArgs, bool isStatic) {
@@ -370,7 +614,7 @@ namespace ssq {
 
             sq_pushstring(vm, name, strlen(name));
 
-            bindUserData(vm, func);
+            attachNativeStats(vm, bindUserData(vm, func), name, -3);
             bindUserData(vm, std::move(defaultArgs));
 
             std::string params;
@@ -390,7 +634,7 @@ namespace ssq {
 
             sq_pushstring(vm, name, strlen(name));
 
-            bindUserData(vm, func);
+            attachNativeStats(vm, bindUserData(vm, func), name, -3);
             bindUserData(vm, std::move(defaultArgs));
 
             std::string params;
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "object.hpp"
+#include "args.hpp"
+
+namespace ssq {
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    namespace detail {
+        enum class BufferType : uint8_t {
+            INT8,
+            UINT8,
+            INT16,
+            UINT16,
+            INT32,
+            UINT32,
+            INT64,
+            FLOAT,
+            DOUBLE,
+            BYTES // Blob, only accessible as bytes from C++
+        };
+
+        template<typename T> struct BufferTraits;
+        template<> struct BufferTraits<int8_t> { static const BufferType type = BufferType::INT8; };
+        template<> struct BufferTraits<uint8_t> { static const BufferType type = BufferType::UINT8; };
+        template<> struct BufferTraits<int16_t> { static const BufferType type = BufferType::INT16; };
+        template<> struct BufferTraits<uint16_t> { static const BufferType type = BufferType::UINT16; };
+        template<> struct BufferTraits<int32_t> { static const BufferType type = BufferType::INT32; };
+        template<> struct BufferTraits<uint32_t> { static const BufferType type = BufferType::UINT32; };
+        template<> struct BufferTraits<int64_t> { static const BufferType type = BufferType::INT64; };
+        template<> struct BufferTraits<float> { static const BufferType type = BufferType::FLOAT; };
+        template<> struct BufferTraits<double> { static const BufferType type = BufferType::DOUBLE; };
+
+        struct BufferInfo {
+            void* data;
+            size_t size; // Number of elements
+            BufferType type;
+        };
+
+        // Pushes a buffer userdata, storage is allocated inside of the userdata if data is null
+        SSQ_API void pushBuffer(HSQUIRRELVM vm, BufferType type, size_t elementSize, size_t size, void* data);
+        // Returns false if the value is neither a buffer nor a blob
+        SSQ_API bool getBuffer(HSQUIRRELVM vm, SQInteger index, BufferInfo& info);
+    }
+#endif
+
+    /**
+    * @brief Typed view of contiguous memory shared between C++ and Squirrel
+    * @details A buffer is either a userdata created by VM::newBuffer(), which stores the
+    * elements in memory owned by the VM, a userdata created by VM::newBufferView(),
+    * which points at memory owned by C++, or a blob from the blob library. Neither
+    * side copies the elements, C++ accesses them directly through data(), scripts
+    * through indexing:
+    * ```
+    * local sum = 0.0;
+    * for (local i = 0; i < samples.len(); i++) sum += samples[i];
+    * foreach (i, value in samples) samples[i] = value * 0.5;
+    * ```
+    * Blobs are exposed to C++ as raw memory, scripts access them with the blob API.
+    * @note The memory of a view must outlive all references to it from Squirrel. The
+    * memory of a blob moves if the script resizes it, create a new Buffer afterwards.
+    * @ingroup simplesquirrel
+    */
+    template<typename T>
+    class Buffer: public Object {
+    public:
+        /**
+        * @brief Creates an empty buffer with null pointer
+        * @note This object won't be usable
+        */
+        Buffer():Object(), ptr(nullptr), count(0) {
+        }
+        /**
+        * @brief Converts an Object holding a buffer or a blob
+        * @throws TypeException if the object is not a buffer of T, or a blob
+        */
+        explicit Buffer(const Object& object):Object(object), ptr(nullptr), count(0) {
+            sq_pushobject(vm, obj);
+            detail::BufferInfo info;
+            const bool found = detail::getBuffer(vm, -1, info);
+            sq_pop(vm, 1);
+            if (!found)
+                throw TypeException(StaticText("bad cast"), StaticText("BUFFER"), StaticText(typeToStr(getType())));
+            if (info.type == detail::BufferType::BYTES) {
+                count = info.size / sizeof(T);
+            } else if (info.type == detail::BufferTraits<T>::type) {
+                count = info.size;
+            } else {
+                throw TypeException("bad cast", "BUFFER", "BUFFER of a different type");
+            }
+            ptr = static_cast<T*>(info.data);
+        }
+        /**
+        * @brief Returns a pointer to the first element
+        */
+        T* data() const {
+            return ptr;
+        }
+        /**
+        * @brief Returns the number of elements
+        */
+        size_t size() const {
+            return count;
+        }
+        /**
+        * @brief Returns the element at the index, without bounds checking
+        */
+        T& operator [] (size_t index) const {
+            return ptr[index];
+        }
+        /**
+        * @brief Returns a pointer to the first element
+        */
+        T* begin() const {
+            return ptr;
+        }
+        /**
+        * @brief Returns a pointer past the last element
+        */
+        T* end() const {
+            return ptr + count;
+        }
+    private:
+        T* ptr;
+        size_t count;
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    namespace detail {
+        template<typename T>
+        inline T popBuffer(HSQUIRRELVM vm, SQInteger index) {
+            return T(popValue<Object>(vm, index));
+        }
+    }
+#endif
+}
@@ -3,8 +3,27 @@
 #include <functional>
 #include "function.hpp"
 #include "binding.hpp"
+#include "funcdef.hpp"
+
+/**
+* @brief Expands a pointer to member function into the template arguments of
+* Class::addMethod() and nativeMethod()
+* @ingroup simplesquirrel
+*/
+#define SSQ_METHOD(memfunc) decltype(memfunc), memfunc
 
 namespace ssq {
+    /**
+    * @brief Native function calling a member function known at compile time
+    * @details Can be used in FuncDef tables, the first parameter is the instance:
+    * { "bar", &ssq::nativeMethod<SSQ_METHOD(&Foo::bar)>, 2, 2, "xi", ssq::FuncDef::NONE }
+    * @ingroup simplesquirrel
+    */
+    template<typename F, F method>
+    SQInteger nativeMethod(HSQUIRRELVM vm) {
+        return detail::methodBinding<F, method>::call(vm);
+    }
+
     /**
     * @brief Squirrel class object
     * @ingroup simplesquirrel
@@ -30,7 +49,7 @@ namespace ssq {
         /**
         * @brief Destructor
         */
-        virtual ~Class() override = default;
+        ~Class() = default;
         /**
         * @brief Creates a new empty class
         */
@@ -60,6 +79,12 @@ namespace ssq {
         */
         Function findFunc(const char* name) const;
         /**
+        * @brief Finds a function in this class without throwing
+        * @returns ErrorCode::NOT_FOUND error if function was not found, or
+        * ErrorCode::TYPE_MISMATCH error if the object found is not a function
+        */
+        Result<Function> tryFindFunc(const char* name) const;
+        /**
         * @brief Adds a new function type to this class
         * @param name Name of the function to add
         * @param func std::function that contains "this" pointer to the class type followed
@@ -73,9 +98,9 @@ namespace ssq {
         Function addFunc(const char* name, const std::function<Return(Object*, Args...)>& func, DefaultArgumentsImpl<DefaultArgs...> defaultArgs = {}, bool isStatic = false) {
             if (vm == nullptr) throw RuntimeException(nullptr, "VM is not initialised");
             Function ret(vm);
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
             detail::addMemberFunc(vm, name, func, std::move(defaultArgs), isStatic);
-            sq_pop(vm, 1);
             return ret;
         }
         /**
@@ -120,6 +145,59 @@ namespace ssq {
         Function addFunc(const char* name, const F& lambda, DefaultArgumentsImpl<DefaultArgs...> defaultArgs = {}, bool isStatic = false) {
             return addFunc(name, detail::make_function(lambda), std::move(defaultArgs), isStatic);
         }
+        /**
+        * @brief Adds a member function known at compile time
+        * @details The generated native function calls the method directly, without
+        * the std::function allocated by addFunc() for every bound method. Use
+        * SSQ_METHOD() to pass the pointer, for example addMethod<SSQ_METHOD(&Foo::bar)>("bar").
+        * @note Default arguments are not supported, and the calls are not counted
+        * when built with SSQ_NATIVE_STATS
+        * @throws RuntimeException if VM is invalid
+        * @returns Function object references the added function
+        */
+        template<typename F, F method>
+        Function addMethod(const char* name, bool isStatic = false) {
+            typedef detail::methodBinding<F, method> Binding;
+            if (vm == nullptr) throw RuntimeException(nullptr, "VM is not initialised");
+            Function ret(vm);
+            StackGuard guard(vm);
+            sq_pushobject(vm, obj);
+            sq_pushstring(vm, name, strlen(name));
+
+            std::string params;
+            Binding::params(params);
+
+            sq_newclosure(vm, &Binding::call, 0);
+            sq_setparamscheck(vm, Binding::nparams + 1, Binding::nparams + 1, params.c_str());
+            if (SQ_FAILED(sq_newslot(vm, -3, isStatic))) {
+                throw RuntimeException(vm, "Failed to bind function!");
+            }
+            return ret;
+        }
+#if defined(__cpp_nontype_template_parameter_auto) && __cpp_nontype_template_parameter_auto >= 201606L
+        /**
+        * @brief Adds a member function known at compile time, for example addMethod<&Foo::bar>("bar")
+        * @details See addMethod<F, method>()
+        */
+        template<auto method>
+        Function addMethod(const char* name, bool isStatic = false) {
+            return addMethod<decltype(method), method>(name, isStatic);
+        }
+#endif
+        /**
+        * @brief Adds native functions, getters and setters described by an array of FuncDef
+        * @details The class is pushed only once for the whole array, see FuncDef::Flags
+        * @throws RuntimeException if VM is invalid or a function can not be added
+        */
+        void addFuncs(const FuncDef* defs, size_t count);
+        /**
+        * @brief Adds native functions, getters and setters described by an array of FuncDef
+        * @throws RuntimeException if VM is invalid or a function can not be added
+        */
+        template<size_t N>
+        void addFuncs(const FuncDef (&defs)[N]) {
+            addFuncs(defs, N);
+        }
         template<typename T, typename V>
         void addVar(const std::string& name, V T::* ptr, bool isStatic = false) {
             findTable("_get", tableGet, dlgGetStub);
@@ -165,7 +243,7 @@ namespace ssq {
 
         template<typename T, typename V>
         void bindGetter(const std::string& name, const std::function<V(T*)>& getter, HSQOBJECT& table, bool isStatic) {
-            auto rst = sq_gettop(vm);
+            StackGuard guard(vm);
 
             sq_pushobject(vm, table);
             sq_pushstring(vm, name.c_str(), name.size());
@@ -177,13 +255,10 @@ namespace ssq {
             if (SQ_FAILED(sq_newslot(vm, -3, isStatic))) {
                 throw RuntimeException(vm, "Failed to bind member variable getter function to class!");
             }
-
-            sq_pop(vm, 1);
-            sq_settop(vm, rst);
         }
         template<typename T, typename V>
         void bindSetter(const std::string& name, const std::function<void(T*, V)>& setter, HSQOBJECT& table, bool isStatic) {
-            auto rst = sq_gettop(vm);
+            StackGuard guard(vm);
 
             sq_pushobject(vm, table);
             sq_pushstring(vm, name.c_str(), name.size());
@@ -195,14 +270,11 @@ namespace ssq {
             if (SQ_FAILED(sq_newslot(vm, -3, isStatic))) {
                 throw RuntimeException(vm, "Failed to bind member variable setter function to class!");
             }
-
-            sq_pop(vm, 1);
-            sq_settop(vm, rst);
         }
 
         template<typename T, typename V>
         void bindVar(const std::string& name, V T::* ptr, HSQOBJECT& table, SQFUNCTION stub, bool isStatic) {
-            auto rst = sq_gettop(vm);
+            StackGuard guard(vm);
 
             sq_pushobject(vm, table);
             sq_pushstring(vm, name.c_str(), name.size());
@@ -215,9 +287,6 @@ namespace ssq {
             if (SQ_FAILED(sq_newslot(vm, -3, isStatic))) {
                 throw RuntimeException(vm, "Failed to bind member variable to class!");
             }
-
-            sq_pop(vm, 1);
-            sq_settop(vm, rst);
         }
 
         template<typename T, typename V>
@@ -258,7 +327,7 @@ namespace ssq {
         inline Class popValue(HSQUIRRELVM vm, SQInteger index){
             checkType(vm, index, OT_CLASS);
             Class val(vm);
-            if (SQ_FAILED(sq_getstackobj(vm, index, &val.getRaw()))) throw RuntimeException(vm, "Could not get Class from Squirrel stack!");
+            if (SQ_FAILED(sq_getstackobj(vm, index, &val.getRaw()))) throw RuntimeException(vm, StaticText("Could not get Class from Squirrel stack!"));
             sq_addref(vm, &val.getRaw());
             return val;
         }
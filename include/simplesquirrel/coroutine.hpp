@@ -0,0 +1,208 @@
+#pragma once
+
+#include "vm.hpp"
+
+#include <exception>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define SSQ_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning( disable: 4251 )
+#endif
+
+namespace ssq {
+    /**
+    * @brief Squirrel function running in its own thread, which can be suspended and resumed
+    * @details The function runs until it calls suspend(value) from Squirrel, at which
+    * point start() or resume() returns the value to C++. The next resume(value) continues
+    * the function and the value becomes the result of the suspend() call in Squirrel.
+    * Once the function returns, its return value is returned instead and the coroutine
+    * is finished. A finished coroutine can be reused with reset().
+    * @ingroup simplesquirrel
+    */
+    class SSQ_API Coroutine {
+    public:
+        /**
+        * @brief State of the coroutine
+        */
+        enum class State {
+            IDLE,
+            SUSPENDED,
+            FINISHED
+        };
+        /**
+        * @brief Creates an empty coroutine without a thread
+        * @note This object won't be usable
+        */
+        Coroutine();
+        /**
+        * @brief Creates a new thread in the VM for the function
+        * @param vm The main VM or any of its threads
+        * @param func The function to run
+        * @param stackSize The stack size of the new thread, or zero to use
+        * VM::getSuggestedThreadStackSize()
+        */
+        Coroutine(VM& vm, const Function& func, size_t stackSize = 0);
+        /**
+        * @brief Destroys the thread
+        */
+        ~Coroutine();
+        /**
+        * @brief Disabled copy constructor
+        */
+        Coroutine(const Coroutine& other) = delete;
+        /**
+        * @brief Move constructor
+        */
+        Coroutine(Coroutine&& other) NOEXCEPT;
+        /**
+        * @brief Swaps the contents of this coroutine with another one
+        */
+        void swap(Coroutine& other) NOEXCEPT;
+        /**
+        * @brief Starts the function with given arguments
+        * @returns The first suspended value, or the return value if the function
+        * finished without suspending
+        * @throws RuntimeException if the coroutine is not idle, the number of arguments
+        * does not match, or the function throws
+        * @throws TimeoutException if the thread has been interrupted, see VM::setInstructionBudget()
+        */
+        template<class... Args>
+        Object start(Args&&... args) {
+            const SQInteger nparams = sizeof...(Args);
+            prepare(nparams);
+            pushArgs(std::forward<Args>(args)...);
+            return call(nparams);
+        }
+        /**
+        * @brief Resumes the suspended function
+        * @param value The value returned by the suspend() call in Squirrel
+        * @returns The next suspended value, or the return value if the function finished
+        * @throws RuntimeException if the coroutine is not suspended or the function throws
+        * @throws TimeoutException if the thread has been interrupted, see VM::setInstructionBudget()
+        */
+        template<class T>
+        Object resume(const T& value) {
+            checkSuspended();
+            detail::push(thread.getHandle(), value);
+            return wakeup();
+        }
+        /**
+        * @brief Resumes the suspended function with null
+        * @see resume(const T& value)
+        */
+        Object resume();
+        /**
+        * @brief Resumes the suspended function and converts the result
+        * @throws TypeException if the result cannot be converted
+        */
+        template<class R, class T>
+        R resumeAs(const T& value) {
+            return resume(value).template to<R>();
+        }
+        /**
+        * @brief Replaces the function of an idle or finished coroutine, keeping its thread
+        * @throws RuntimeException if the coroutine is suspended
+        */
+        void reset(const Function& func);
+        /**
+        * @brief Returns the last suspended or returned value
+        */
+        const Object& getValue() const;
+        /**
+        * @brief Returns the state of the coroutine
+        */
+        State getState() const;
+        /**
+        * @brief Returns true if the function is waiting to be resumed
+        */
+        bool isSuspended() const;
+        /**
+        * @brief Returns true if the function has returned or thrown
+        */
+        bool isFinished() const;
+        /**
+        * @brief Returns the thread the function runs in
+        */
+        VM& getThread();
+        /**
+        * @brief Returns the function this coroutine runs
+        */
+        const Function& getFunc() const;
+        /**
+        * @brief Disabled copy assingment operator
+        */
+        Coroutine& operator = (const Coroutine& other) = delete;
+        /**
+        * @brief Move assingment operator
+        */
+        Coroutine& operator = (Coroutine&& other) NOEXCEPT;
+#ifdef SSQ_HAS_COROUTINES
+        /**
+        * @brief Awaitable that resumes the awaiting C++20 coroutine once this one finishes
+        * @details The awaiting coroutine continues from within the resume() call that
+        * finished the Squirrel function. The result of co_await is the return value,
+        * or the exception the function failed with is rethrown.
+        */
+        struct Awaiter {
+            Coroutine& coroutine;
+
+            bool await_ready() const NOEXCEPT {
+                return coroutine.isFinished();
+            }
+            void await_suspend(std::coroutine_handle<> handle) NOEXCEPT {
+                coroutine.continuation = [](void* address) {
+                    std::coroutine_handle<>::from_address(address).resume();
+                };
+                coroutine.continuationData = handle.address();
+            }
+            Object await_resume() const {
+                if (coroutine.error) std::rethrow_exception(coroutine.error);
+                return coroutine.getValue();
+            }
+        };
+        /**
+        * @brief Waits for the Squirrel function to finish
+        */
+        Awaiter operator co_await() NOEXCEPT {
+            return Awaiter{*this};
+        }
+#endif
+    private:
+        void prepare(SQInteger nparams);
+        void checkSuspended() const;
+        Object call(SQInteger nparams);
+        Object wakeup();
+        Object result();
+        void fail();
+        void notify();
+
+        void pushArgs() {
+        }
+
+        template <class First, class... Rest>
+        void pushArgs(First&& first, Rest&&... rest) {
+            detail::push(thread.getHandle(), first);
+            pushArgs(std::forward<Rest>(rest)...);
+        }
+
+        VM thread;
+        Function func;
+        Object value;
+        std::exception_ptr error; // Set when the function fails, rethrown to the awaiter
+        State state;
+        SQInteger base;
+        void (*continuation)(void*);
+        void* continuationData;
+    };
+}
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
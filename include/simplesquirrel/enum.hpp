@@ -17,7 +17,7 @@ namespace ssq {
         /**
         * @brief Destructor
         */
-        virtual ~Enum() override = default;
+        ~Enum() = default;
         /**
         * @brief Converts Object to Enum
         * @throws TypeException if the Object is not type of an enum (table)
@@ -40,13 +40,13 @@ namespace ssq {
          */
         template<typename T>
         void addSlot(const char* name, const T& value) {
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
             sq_pushstring(vm, name, strlen(name));
             detail::push<T>(vm, value);
             if(SQ_FAILED(sq_newslot(vm, -3, SQFalse))) {
                 throw RuntimeException(vm, "Failed to add '" + std::string(name) + "' enumerator slot!");
             }
-            sq_pop(vm,1); // pop table
         }
         /**
         * @brief Copy assingment operator
@@ -1,32 +1,95 @@
 #pragma once
 
+#include <cstddef>
+#include <exception>
 #include <string>
-#include <sstream>
+#include <type_traits>
 #include <squirrel.h>
 
+#if !defined(__cpp_exceptions) && !defined(__EXCEPTIONS) && !defined(_CPPUNWIND)
+#error "simplesquirrel requires C++ exceptions, the bindings use them to report errors of C++ functions"
+#endif
+
 namespace ssq {
+    /**
+    * @brief Text which lives for the whole program, such as a string literal
+    * @details Exception messages are copied, unless they are wrapped in StaticText,
+    * in which case only the pointer is kept:
+    * `throw ssq::RuntimeException(vm, ssq::StaticText("Value out of range!"));`
+    * @ingroup simplesquirrel
+    */
+    struct StaticText {
+        explicit StaticText(const char* text):text(text) {
+        }
+        const char* text;
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    namespace detail {
+        // Piece of an exception message, StaticText is kept by pointer and
+        // everything else is copied
+        class ExceptionText {
+        public:
+            ExceptionText():ptr(nullptr) {
+            }
+            ExceptionText(StaticText text):ptr(text.text) {
+            }
+            ExceptionText(const char* text):ptr(nullptr), str(text) {
+            }
+            ExceptionText(const std::string& text):ptr(nullptr), str(text) {
+            }
+            ExceptionText(std::string&& text):ptr(nullptr), str(std::move(text)) {
+            }
+            const char* c_str() const {
+                return ptr ? ptr : str.c_str();
+            }
+        private:
+            const char* ptr;
+            std::string str;
+        };
+    }
+#endif
+
     /**
     * @brief Raw exception
+    * @details Exceptions only keep the pieces of the message and a copy of the last
+    * error of the VM, if it is a string. The message is formatted on the first call
+    * to what(). Exceptions may outlive the VM.
     * @ingroup simplesquirrel
     */
     class Exception: public std::exception {
     public:
         HSQUIRRELVM vm;
 
-        Exception(HSQUIRRELVM v) : vm(v), message() {}
-        Exception(HSQUIRRELVM v, const std::string& msg) : vm(v), message() {
-            generate_message(msg);
+        Exception(HSQUIRRELVM v) : vm(v) {
+            captureLastError();
         }
-
-        virtual const char* what() const throw() override {
-            return message.c_str();
+        Exception(HSQUIRRELVM v, detail::ExceptionText msg) : vm(v), msg(std::move(msg)) {
+            captureLastError();
         }
+        virtual ~Exception() throw() {}
+
+        virtual const char* what() const throw() override;
+        /**
+        * @brief Writes the message into a buffer without allocating memory
+        * @details The output is truncated to size - 1 characters and always null terminated
+        * @returns The length of the full message, same as snprintf
+        */
+        size_t format(char* buffer, size_t size) const;
 
     protected:
-        void generate_message(const std::string& msg);
+        virtual size_t formatBody(char* buffer, size_t size, size_t pos) const;
+        static size_t append(char* buffer, size_t size, size_t pos, const char* str);
+        static size_t append(char* buffer, size_t size, size_t pos, long long value);
+
+        detail::ExceptionText msg;
 
     private:
-        std::string message;
+        void captureLastError();
+
+        std::string lastError;
+        bool hasLastError = false;
+        mutable std::string message;
     };
     /**
     * @brief Not Found exception thrown if object with a given name does not exist
@@ -34,10 +97,12 @@ namespace ssq {
     */
     class NotFoundException: public Exception {
     public:
-        NotFoundException(HSQUIRRELVM v, const std::string& msg) : Exception(v) {
-            std::stringstream ss;
-            ss << "Not found: " << msg;
-            generate_message(ss.str());
+        NotFoundException(HSQUIRRELVM v, detail::ExceptionText msg) : Exception(v, std::move(msg)) {}
+
+    protected:
+        virtual size_t formatBody(char* buffer, size_t size, size_t pos) const override {
+            pos = append(buffer, size, pos, "Not found: ");
+            return append(buffer, size, pos, msg.c_str());
         }
     };
     /**
@@ -46,12 +111,29 @@ namespace ssq {
     */
     class CompileException: public Exception {
     public:
-        CompileException(HSQUIRRELVM v, const std::string& msg) : Exception(v, msg) {}
-        CompileException(HSQUIRRELVM v, const std::string& msg, const char* source, int line, int column) : Exception(v) {
-            std::stringstream ss;
-            ss << "Compile error at " << source << ":" << line << ":" << column << " " << msg;
-            generate_message(ss.str());
+        CompileException(HSQUIRRELVM v, detail::ExceptionText msg) : Exception(v, std::move(msg)) {}
+        CompileException(HSQUIRRELVM v, detail::ExceptionText msg, detail::ExceptionText source, int line, int column) :
+            Exception(v, std::move(msg)), source(std::move(source)), line(line), column(column), hasLocation(true) {}
+
+    protected:
+        virtual size_t formatBody(char* buffer, size_t size, size_t pos) const override {
+            if (hasLocation) {
+                pos = append(buffer, size, pos, "Compile error at ");
+                pos = append(buffer, size, pos, source.c_str());
+                pos = append(buffer, size, pos, ":");
+                pos = append(buffer, size, pos, static_cast<long long>(line));
+                pos = append(buffer, size, pos, ":");
+                pos = append(buffer, size, pos, static_cast<long long>(column));
+                pos = append(buffer, size, pos, " ");
+            }
+            return append(buffer, size, pos, msg.c_str());
         }
+
+    private:
+        detail::ExceptionText source;
+        int line = 0;
+        int column = 0;
+        bool hasLocation = false;
     };
     /**
     * @brief Type exception thrown if casting between squirrel and C++ objects failed
@@ -59,11 +141,22 @@ namespace ssq {
     */
     class TypeException: public Exception {
     public:
-        TypeException(const std::string& msg, const char* expected, const char* got) : Exception(nullptr) {
-            std::stringstream ss;
-            ss << "Type error " << msg << " expected: " << expected << " got: " << got;
-            generate_message(ss.str());
+        TypeException(detail::ExceptionText msg, detail::ExceptionText expected, detail::ExceptionText got) :
+            Exception(nullptr, std::move(msg)), expected(std::move(expected)), got(std::move(got)) {}
+
+    protected:
+        virtual size_t formatBody(char* buffer, size_t size, size_t pos) const override {
+            pos = append(buffer, size, pos, "Type error ");
+            pos = append(buffer, size, pos, msg.c_str());
+            pos = append(buffer, size, pos, " expected: ");
+            pos = append(buffer, size, pos, expected.c_str());
+            pos = append(buffer, size, pos, " got: ");
+            return append(buffer, size, pos, got.c_str());
         }
+
+    private:
+        detail::ExceptionText expected;
+        detail::ExceptionText got;
     };
     /**
     * @brief Runtime exception thrown if something went wrong during execution
@@ -71,11 +164,41 @@ namespace ssq {
     */
     class RuntimeException: public Exception {
     public:
-        RuntimeException(HSQUIRRELVM v, const std::string& msg) : Exception(v, msg) {}
-        RuntimeException(HSQUIRRELVM v, const std::string& msg, const char* source, const char* func, int line) : Exception(v) {
-            std::stringstream ss;
-            ss << "Runtime error at (" << func << ") " << source << ":" << line << ": " << msg;
-            generate_message(ss.str());
+        RuntimeException(HSQUIRRELVM v, detail::ExceptionText msg) : Exception(v, std::move(msg)) {}
+        RuntimeException(HSQUIRRELVM v, detail::ExceptionText msg, detail::ExceptionText source, detail::ExceptionText func, int line) :
+            Exception(v, std::move(msg)), source(std::move(source)), func(std::move(func)), line(line), hasLocation(true) {}
+
+    protected:
+        virtual size_t formatBody(char* buffer, size_t size, size_t pos) const override {
+            if (hasLocation) {
+                pos = append(buffer, size, pos, "Runtime error at (");
+                pos = append(buffer, size, pos, func.c_str());
+                pos = append(buffer, size, pos, ") ");
+                pos = append(buffer, size, pos, source.c_str());
+                pos = append(buffer, size, pos, ":");
+                pos = append(buffer, size, pos, static_cast<long long>(line));
+                pos = append(buffer, size, pos, ": ");
+            }
+            return append(buffer, size, pos, msg.c_str());
+        }
+
+    private:
+        detail::ExceptionText source;
+        detail::ExceptionText func;
+        int line = 0;
+        bool hasLocation = false;
+    };
+    /**
+    * @brief Timeout exception thrown if a script exceeded its execution budget
+    * @details See VM::setInstructionBudget() and VM::setDeadline(). The exception
+    * is thrown once the interrupted script has returned to C++, the VM stays usable
+    * after VM::clearBudget().
+    * @ingroup simplesquirrel
+    */
+    class TimeoutException: public Exception {
+    public:
+        TimeoutException(HSQUIRRELVM v, detail::ExceptionText msg) : Exception(nullptr, std::move(msg)) {
+            vm = v;
         }
     };
 }
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "vm.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning( disable: 4251 )
+#endif
+
+namespace ssq {
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    namespace detail {
+        template<typename R>
+        inline R convertResult(const Object& object) {
+            return object.to<R>();
+        }
+
+        template<>
+        inline void convertResult<void>(const Object&) {
+        }
+    }
+#endif
+
+    /**
+    * @brief Pool of worker threads, each owning an independent main VM
+    * @details Every worker creates its own VM and initializes it with the same setup
+    * callback, so all VMs share the same scripts and bindings, but no state. Jobs are
+    * distributed between the workers round-robin, an idle worker steals jobs queued
+    * on the other workers. The results are returned through futures.
+    * @note A job can run on any of the workers, therefore jobs must not rely on
+    * state kept in a particular VM.
+    * @ingroup simplesquirrel
+    */
+    class SSQ_API VMExecutor {
+    public:
+        /**
+        * @brief Callback initializing the VM of a worker
+        */
+        typedef std::function<void(VM&)> Setup;
+        /**
+        * @brief Creates the workers and initializes their VMs
+        * @param numOfWorkers Number of worker threads, zero for one per hardware thread
+        * @param setup Called once by every worker, from its own thread
+        * @param stackSize The stack size of the VMs
+        * @param flags Standard libraries registered to the VMs
+        * @throws Rethrows the first exception thrown by the setup callback
+        */
+        VMExecutor(size_t numOfWorkers, const Setup& setup, size_t stackSize = 1024, uint32_t flags = Libs::ALL);
+        /**
+        * @brief Finishes all queued jobs, then stops the workers and destroys their VMs
+        */
+        ~VMExecutor();
+        /**
+        * @brief Disabled copy constructor
+        */
+        VMExecutor(const VMExecutor& other) = delete;
+        /**
+        * @brief Disabled copy assingment operator
+        */
+        VMExecutor& operator = (const VMExecutor& other) = delete;
+        /**
+        * @brief Returns a setup callback which runs the script in every VM
+        * @details The script is compiled once and its bytecode is loaded by the workers
+        * @throws CompileException
+        */
+        static Setup runScript(const std::string& source, const std::string& name = "buffer");
+        /**
+        * @brief Queues a callable receiving the VM of the worker that runs it
+        * @returns A future with the result of the callable
+        */
+        template<class F>
+        auto submit(F&& job) -> std::future<decltype(job(std::declval<VM&>()))> {
+            typedef decltype(job(std::declval<VM&>())) R;
+            auto task = std::make_shared<std::packaged_task<R(VM&)>>(std::forward<F>(job));
+            std::future<R> future = task->get_future();
+            push([task](VM& vm) {
+                (*task)(vm);
+            });
+            return future;
+        }
+        /**
+        * @brief Queues a call of a global function
+        * @returns A future with the return value converted to R
+        * @note Squirrel objects belong to the VM of the worker, use plain C++ types for R
+        */
+        template<class R, class... Args>
+        std::future<R> call(const std::string& name, Args... args) {
+            return submit([=](VM& vm) -> R {
+                return detail::convertResult<R>(vm.callFunc(vm.findFunc(name.c_str()), vm, args...));
+            });
+        }
+        /**
+        * @brief Returns the number of workers
+        */
+        size_t getNumOfWorkers() const;
+    private:
+        typedef std::function<void(VM&)> Job;
+
+        struct Worker {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+            std::thread thread;
+        };
+
+        void shutdown();
+        void push(Job job);
+        bool pop(size_t index, Job& job);
+        bool steal(size_t index, Job& job);
+        void workerLoop(size_t index, const Setup& setup, size_t stackSize, uint32_t flags, std::promise<void>& ready);
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<size_t> next;
+        std::atomic<size_t> pending;
+        std::atomic<size_t> sleeping;
+        bool quit;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+}
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <squirrel.h>
+
+namespace ssq {
+    /**
+    * @brief Description of a native function for bulk registration
+    * @details Arrays of FuncDef can be declared as constexpr and applied to any number
+    * of VMs with Table::addFuncs() or Class::addFuncs(). The function receives the
+    * arguments on the Squirrel stack, the same as any other SQFUNCTION.
+    * @ingroup simplesquirrel
+    */
+    struct FuncDef {
+        enum Flags {
+            NONE = 0,
+            /** Adds the function as a static member of a class */
+            STATIC = 1 << 0,
+            /** Adds the function as a getter of a class variable, called with the instance */
+            GETTER = 1 << 1,
+            /** Adds the function as a setter of a class variable, called with the instance and the value */
+            SETTER = 1 << 2
+        };
+        /** Name of the slot */
+        const SQChar* name;
+        /** Native function */
+        SQFUNCTION func;
+        /** Minimum number of parameters including "this", see sq_setparamscheck() */
+        SQInteger nparamsmin;
+        /** Maximum number of parameters including "this", see sq_setparamscheck() */
+        SQInteger nparamsmax;
+        /** Type mask of the parameters, the parameters are not checked if null */
+        const SQChar* typemask;
+        /** Combination of Flags */
+        unsigned int flags;
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    namespace detail {
+        // Pushes the name and the native closure of a FuncDef
+        inline void pushFuncDef(HSQUIRRELVM vm, const FuncDef& def) {
+            sq_pushstring(vm, def.name, -1);
+            sq_newclosure(vm, def.func, 0);
+            if (def.typemask != nullptr) {
+                sq_setparamscheck(vm, def.nparamsmin, def.nparamsmax, def.typemask);
+            }
+            sq_setnativeclosurename(vm, -1, def.name);
+        }
+    }
+#endif
+}
@@ -18,7 +18,7 @@ namespace ssq {
         /**
         * @brief Destructor
         */
-        virtual ~Function() override = default;
+        ~Function() = default;
         /**
         * @brief Converts Object to Function
         * @throws TypeException if the Object is not type of a function
@@ -38,6 +38,11 @@ namespace ssq {
         */
         std::pair<unsigned int, unsigned int> getNumOfParams() const;
         /**
+        * @brief Returns the minimum and maximum number of parameters without throwing
+        * @returns ErrorCode::RUNTIME_ERROR error if the function info can not be read
+        */
+        Result<std::pair<unsigned int, unsigned int>> tryGetNumOfParams() const;
+        /**
         * @brief Copy assingment operator
         */
         Function& operator = (const Function& other);
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <squirrel.h>
+#include <stdint.h>
+
+#include "type.hpp"
+
+namespace ssq {
+    class VM;
+
+    /**
+    * @brief Counters of the cycle collections run through GarbageCollector
+    * @ingroup simplesquirrel
+    */
+    struct GcStats {
+        /**
+        * @brief Number of collections
+        */
+        uint64_t collections = 0;
+        /**
+        * @brief Total number of objects freed by all collections
+        */
+        uint64_t freed = 0;
+        /**
+        * @brief Number of objects freed by the last collection
+        */
+        uint64_t lastFreed = 0;
+        /**
+        * @brief Duration of the last collection, in nanoseconds
+        */
+        uint64_t lastNs = 0;
+        /**
+        * @brief Total time spent in all collections, in nanoseconds
+        */
+        uint64_t totalNs = 0;
+        /**
+        * @brief The longest single collection, in nanoseconds
+        */
+        uint64_t maxNs = 0;
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    namespace detail {
+        struct GcState {
+            unsigned int paused = 0;
+            bool pending = false;
+            bool autoCollect = true;
+            GcStats stats;
+        };
+    }
+#endif
+
+    /**
+    * @brief Controls when the cycle collector of a VM runs
+    * @details Squirrel frees most objects by reference counting, only reference cycles
+    * need a collection. The library collects them on its own when a thread is destroyed,
+    * see VM::destroyThread(). Those collections can be deferred with setAutoCollect() or
+    * with a Pause, and run later at a convenient point with update(), for example at the
+    * end of a frame.
+    * @note The controller is a handle to the state kept by the main VM, it can be created
+    * from the main VM or any of its threads and must not outlive the VM.
+    * @ingroup simplesquirrel
+    */
+    class SSQ_API GarbageCollector {
+    public:
+        /**
+        * @brief Defers the automatic collections for as long as it exists
+        * @details Collections requested while paused are scheduled for the next update()
+        * after the last Pause is gone, they are never run from the destructor.
+        */
+        class SSQ_API Pause {
+        public:
+            /**
+            * @brief Pauses the automatic collections of the VM
+            */
+            explicit Pause(VM& vm);
+            /**
+            * @brief Resumes the automatic collections of the VM
+            */
+            ~Pause();
+            /**
+            * @brief Disabled copy constructor
+            */
+            Pause(const Pause& other) = delete;
+            /**
+            * @brief Disabled copy assingment operator
+            */
+            Pause& operator = (const Pause& other) = delete;
+        private:
+            VM& vm;
+        };
+        /**
+        * @brief Creates a controller for the VM
+        * @param vm The main VM or any of its threads
+        */
+        explicit GarbageCollector(VM& vm);
+        /**
+        * @brief Runs a collection now, even if paused
+        * @returns Number of objects freed
+        */
+        SQInteger collect();
+        /**
+        * @brief Runs a collection now, or schedules it if paused or if automatic
+        * collection is disabled
+        * @details Used by the library wherever it used to collect implicitly
+        */
+        void collectOrSchedule();
+        /**
+        * @brief Schedules a collection for the next update()
+        */
+        void schedule();
+        /**
+        * @brief Runs the scheduled collection, if any and if not paused
+        * @details Meant to be called at frame boundaries or other points where a pause
+        * does not hurt
+        * @returns Number of objects freed, zero if nothing has been collected
+        */
+        SQInteger update();
+        /**
+        * @brief Returns true if a collection is scheduled
+        */
+        bool isPending() const;
+        /**
+        * @brief Returns true if at least one Pause exists
+        */
+        bool isPaused() const;
+        /**
+        * @brief Enables or disables the automatic collections
+        * @details When disabled, the collections the library would run on its own are
+        * only scheduled, see update(). Enabled by default.
+        */
+        void setAutoCollect(bool enable);
+        /**
+        * @brief Returns true if the automatic collections are enabled
+        */
+        bool getAutoCollect() const;
+        /**
+        * @brief Returns the counters of all collections run so far
+        */
+        const GcStats& getStats() const;
+        /**
+        * @brief Resets the counters to zero
+        */
+        void resetStats();
+    private:
+        VM& vm;
+    };
+}
@@ -18,7 +18,7 @@ namespace ssq {
         /**
         * @brief Destructor
         */
-        virtual ~Instance() override = default;
+        ~Instance() = default;
         /**
         * @brief Constructs empty instance
         */
@@ -53,20 +53,55 @@ namespace ssq {
 
     /**
      * @brief Weak reference class that does not extend the life of the instance
+     * @details Holds a Squirrel weakref object created by sq_weakref(). When the
+     * instance is destroyed the reference turns to null instead of dangling,
+     * use lock() to get a strong handle for as long as it is needed. Pushing
+     * the reference to Squirrel pushes the instance, or null if it has expired.
      * @ingroup simplesquirrel
      */
-    class SSQ_API SqWeakRef: public Instance {
+    class SSQ_API SqWeakRef: public Object {
     public:
+        /**
+        * @brief Constructs empty weak reference
+        */
         SqWeakRef();
+        /**
+        * @brief Constructs empty weak reference
+        */
         SqWeakRef(HSQUIRRELVM vm);
+        /**
+        * @brief Copy constructor
+        */
         SqWeakRef(const SqWeakRef& other);
-        SqWeakRef(SqWeakRef&& other);
+        /**
+        * @brief Move constructor
+        */
+        SqWeakRef(SqWeakRef&& other) NOEXCEPT;
+        /**
+        * @brief Creates a weak reference to the instance
+        */
         explicit SqWeakRef(const Instance& instance);
-
-        void swap(SqWeakRef& other);
-
+        /**
+        * @brief Returns a strong handle to the instance
+        * @returns Empty instance if the reference has expired
+        */
+        Instance lock() const;
+        /**
+        * @brief Returns true if the instance has been destroyed
+        */
+        bool expired() const;
+        /**
+        * @brief Swaps two weak references
+        */
+        void swap(SqWeakRef& other) NOEXCEPT;
+        /**
+        * @brief Copy assingment operator
+        */
         SqWeakRef& operator = (const SqWeakRef& other);
-        SqWeakRef& operator = (SqWeakRef&& other);
+        /**
+        * @brief Move assingment operator
+        */
+        SqWeakRef& operator = (SqWeakRef&& other) NOEXCEPT;
     };
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -75,16 +110,33 @@ namespace ssq {
         inline Instance popValue(HSQUIRRELVM vm, SQInteger index){
             checkType(vm, index, OT_INSTANCE);
             Instance val(vm);
-            if (SQ_FAILED(sq_getstackobj(vm, index, &val.getRaw()))) throw RuntimeException(vm, "Could not get Instance from Squirrel stack!");
+            if (SQ_FAILED(sq_getstackobj(vm, index, &val.getRaw()))) throw RuntimeException(vm, StaticText("Could not get Instance from Squirrel stack!"));
             sq_addref(vm, &val.getRaw());
             return val;
         }
 
         template<>
         inline SqWeakRef popValue(HSQUIRRELVM vm, SQInteger index){
-            checkType(vm, index, OT_INSTANCE);
             SqWeakRef val(vm);
-            if (SQ_FAILED(sq_getstackobj(vm, index, &val.getRaw()))) throw RuntimeException(vm, "Could not get Instance from Squirrel stack!");
+            if (sq_gettype(vm, index) == OT_NULL) {
+                return val;
+            } else if (sq_gettype(vm, index) == OT_WEAKREF) {
+                // Only references to instances, expired ones point to null
+                SQObjectType target = OT_NULL;
+                if (SQ_SUCCEEDED(sq_getweakrefval(vm, index))) {
+                    target = sq_gettype(vm, -1);
+                    sq_pop(vm, 1);
+                }
+                if (target != OT_INSTANCE && target != OT_NULL)
+                    throw TypeException(StaticText("bad cast"), StaticText(typeToStr(Type(OT_INSTANCE))), StaticText(typeToStr(Type(target))));
+                sq_getstackobj(vm, index, &val.getRaw());
+            } else {
+                checkType(vm, index, OT_INSTANCE);
+                sq_weakref(vm, index);
+                sq_getstackobj(vm, -1, &val.getRaw());
+                sq_pop(vm, 1);
+            }
+            sq_addref(vm, &val.getRaw());
             return val;
         }
     }
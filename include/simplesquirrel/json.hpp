@@ -0,0 +1,32 @@
+#pragma once
+
+#include "vm.hpp"
+
+namespace ssq {
+    /**
+    * @brief Conversion between Squirrel objects and JSON text
+    * @ingroup simplesquirrel
+    */
+    namespace json {
+        /**
+        * @brief Parses JSON text into Squirrel tables, arrays and values
+        * @details The objects are built directly on the stack of the VM in a single pass
+        * over the text. Numbers without a fraction or exponent become integers.
+        * @throws RuntimeException with the line and column if the text is not valid JSON
+        */
+        SSQ_API Object parse(VM& vm, const std::string& text);
+        /**
+        * @brief Converts an object into JSON text
+        * @param object Null, boolean, number, string, or a table or array of them
+        * @param indent Number of spaces used to indent nested values, zero for compact output
+        * @throws TypeException if the object contains an unsupported value, a table
+        * key which is not a string, or a reference cycle
+        */
+        SSQ_API std::string stringify(const Object& object, int indent = 0);
+        /**
+        * @brief Registers the json table with parse(text) and stringify(value, indent = 0)
+        * functions into the table on top of the stack, used by Libs::JSON
+        */
+        SSQ_API void registerLib(HSQUIRRELVM vm);
+    }
+}
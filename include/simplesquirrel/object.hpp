@@ -26,6 +26,9 @@
 
 #include "exceptions.hpp"
 #include "exposable_class.hpp"
+#include "refs.hpp"
+#include "result.hpp"
+#include "stack.hpp"
 #include "type.hpp"
 
 namespace ssq {
@@ -45,6 +48,10 @@ namespace ssq {
 
     /**
     * @brief Raw Squirrel object
+    * @details The handle is not polymorphic and only holds the VM and the raw
+    * object, the same as ObjectRef. Objects can be stored in large containers
+    * and are moved without touching the reference count. The wrappers derived
+    * from Object must not be deleted through a pointer to Object.
     * @ingroup simplesquirrel
     */
     class SSQ_API Object {
@@ -58,7 +65,7 @@ namespace ssq {
         * @brief Creates an empty object
         */
         Object(HSQUIRRELVM vm);
-        virtual ~Object();
+        ~Object();
         /**
         * @brief Swaps two objects
         */
@@ -88,6 +95,11 @@ namespace ssq {
         */
         Object find(const char* name) const;
         /**
+        * @brief Finds object within this object without throwing
+        * @returns ErrorCode::NOT_FOUND error if the entry does not exist
+        */
+        Result<Object> tryFind(const char* name) const;
+        /**
         * @brief Returns the type of the object
         */
         Type getType() const;
@@ -177,6 +189,12 @@ namespace ssq {
         template<typename T>
         T to() const;
         /**
+        * @brief Returns an arbitary value of this object without throwing
+        * @returns ErrorCode::TYPE_MISMATCH error if this object is not an type of T
+        */
+        template<typename T>
+        Result<T> tryTo() const;
+        /**
         * @brief Unsafe cast this object into any pointer of type T
         * @throws TypeException if this object is not an instance
         */
@@ -185,6 +203,7 @@ namespace ssq {
             if (getType() != Type::INSTANCE) {
                 throw ssq::TypeException("bad cast", "INSTANCE", getTypeStr());
             }
+            SSQ_STACK_CHECK(vm);
             sq_pushobject(vm, obj);
             SQUserPointer val;
             sq_getinstanceup(vm, -1, &val, nullptr, SQTrue);
@@ -201,8 +220,9 @@ namespace ssq {
         Object& operator = (Object&& other) NOEXCEPT;
 
     protected:
+        friend class detail::RefTracker;
+
         HSQUIRRELVM vm;
         HSQOBJECT obj;
-        bool weak;
     };
 }
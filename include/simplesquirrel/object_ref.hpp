@@ -0,0 +1,105 @@
+#pragma once
+
+#include "object.hpp"
+
+namespace ssq {
+    /**
+    * @brief Non-owning view of a Squirrel object
+    * @details Unlike Object, creating, copying and destroying an ObjectRef never touches
+    * the reference count of the object. The view is only valid as long as something
+    * else keeps the object alive, for example an Object, the container it was found in
+    * or the stack slot of a native function argument. Use toObject() to keep the
+    * value beyond that.
+    * @ingroup simplesquirrel
+    */
+    class SSQ_API ObjectRef {
+    public:
+        /**
+        * @brief Creates an empty view with null VM
+        */
+        ObjectRef();
+        /**
+        * @brief Creates a view of a raw Squirrel object
+        */
+        ObjectRef(HSQUIRRELVM vm, const HSQOBJECT& obj);
+        /**
+        * @brief Creates a view of an object
+        * @note The view must not outlive the object
+        */
+        ObjectRef(const Object& object);
+        /**
+        * @brief Checks if the view is empty
+        */
+        bool isEmpty() const;
+        /**
+        * @brief Returns true if the object is nullptr
+        */
+        bool isNull() const;
+        /**
+        * @brief Returns raw Squirrel object reference
+        */
+        const HSQOBJECT& getRaw() const;
+        /**
+        * @brief Returns the Squirrel virtual machine handle associated
+        * with this view
+        */
+        const HSQUIRRELVM& getHandle() const;
+        /**
+        * @brief Returns the type of the object
+        */
+        Type getType() const;
+        /**
+        * @brief Returns the type of the object in string format
+        */
+        const char* getTypeStr() const;
+        /**
+        * @brief Finds object within this object
+        * @details The returned view is valid as long as the entry stays in this object.
+        * Delegates and the _get metamethod are not used, the values they produce have no
+        * owner, look them up through toObject() instead.
+        * @throws NotFoundException if the object itself has no such entry
+        */
+        ObjectRef find(const char* name) const;
+        /**
+        * @brief Returns an owning reference of this object
+        */
+        Object toObject() const;
+        /**
+        * @brief Returns an arbitary value of this object
+        * @throws TypeException if this object is not an type of T
+        */
+        template<typename T>
+        T to() const {
+            if (vm == nullptr) throw RuntimeException(nullptr, "VM is not initialised");
+            StackGuard guard(vm);
+            sq_pushobject(vm, obj);
+            return detail::pop<T>(vm, -1);
+        }
+        /**
+        * @brief Calls func(ObjectRef key, ObjectRef value) for every entry of a table,
+        * array, class or instance
+        * @details The key and value views are only valid during the call
+        */
+        template<typename F>
+        void forEach(F func) const {
+            if (vm == nullptr) throw RuntimeException(nullptr, "VM is not initialised");
+            StackGuard guard(vm);
+            sq_pushobject(vm, obj);
+
+            sq_pushnull(vm); // push iterator
+            while (SQ_SUCCEEDED(sq_next(vm, -2))) {
+                // -1 is the value and -2 is the key
+                HSQOBJECT key, value;
+                sq_getstackobj(vm, -2, &key);
+                sq_getstackobj(vm, -1, &value);
+                func(ObjectRef(vm, key), ObjectRef(vm, value));
+
+                sq_pop(vm, 2); // pop key and value of this iteration
+            }
+        }
+
+    private:
+        HSQUIRRELVM vm;
+        HSQOBJECT obj;
+    };
+}
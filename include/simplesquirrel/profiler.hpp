@@ -0,0 +1,124 @@
+#pragma once
+
+#include "object.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning( disable: 4251 )
+#endif
+
+namespace ssq {
+    class VM;
+
+    /**
+    * @brief Sampling profiler for scripts running in a VM
+    * @details A background thread raises a flag at the configured rate. The next
+    * debug hook event raised by the VM (or any of its threads) consumes the flag
+    * and records the current Squirrel call stack. Identical stacks are aggregated
+    * and can be written in the collapsed format understood by flamegraph.pl.
+    * @note Line events are only raised for scripts compiled while debug info is
+    * enabled, see VM::enableDebugInfo(). Without it the samples are only taken on
+    * function calls and returns.
+    * @ingroup simplesquirrel
+    */
+    class SSQ_API Profiler {
+    public:
+        /**
+        * @brief Default sample rate in samples per second
+        */
+        static const unsigned int DEFAULT_RATE = 1000;
+        /**
+        * @brief Creates a stopped profiler for the given VM
+        * @param vm The main VM or any of its threads, the profiler always samples the
+        * main VM and all of its threads
+        * @param rate Number of samples per second
+        */
+        explicit Profiler(VM& vm, unsigned int rate = DEFAULT_RATE);
+        /**
+        * @brief Stops and detaches the profiler
+        */
+        ~Profiler();
+        /**
+        * @brief Disabled copy constructor
+        */
+        Profiler(const Profiler& other) = delete;
+        /**
+        * @brief Disabled copy assingment operator
+        */
+        Profiler& operator = (const Profiler& other) = delete;
+        /**
+        * @brief Attaches to the VM and starts sampling
+        * @throws RuntimeException if another profiler is already attached to the VM
+        */
+        void start();
+        /**
+        * @brief Stops sampling and detaches from the VM
+        * @details Collected samples are kept until reset() is called.
+        */
+        void stop();
+        /**
+        * @brief Returns true if the profiler is sampling
+        */
+        bool isRunning() const;
+        /**
+        * @brief Changes the sample rate, takes effect immediately
+        */
+        void setRate(unsigned int rate);
+        /**
+        * @brief Returns the sample rate in samples per second
+        */
+        unsigned int getRate() const;
+        /**
+        * @brief Discards all collected samples
+        */
+        void reset();
+        /**
+        * @brief Returns the total number of collected samples
+        */
+        size_t getNumOfSamples() const;
+        /**
+        * @brief Returns the collected samples, keyed by collapsed stack
+        * @details Frames are ordered from the outermost to the innermost call, separated
+        * by a semicolon. Each frame has the form of "function (source:line)".
+        */
+        std::unordered_map<std::string, size_t> getStacks() const;
+        /**
+        * @brief Writes the collected samples in the collapsed stack format
+        * @details One line per unique stack followed by a space and its sample count,
+        * which can be passed directly to flamegraph.pl
+        */
+        void writeCollapsed(std::ostream& out) const;
+    private:
+        friend class VM;
+
+        void sample(HSQUIRRELVM v);
+        void detach();
+        void samplerLoop();
+
+        HSQUIRRELVM vm;
+        std::atomic<unsigned int> rate;
+        std::atomic<bool> pending;
+        bool running;
+        bool quit;
+
+        std::thread sampler;
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+
+        std::unordered_map<std::string, size_t> stacks;
+        size_t samples;
+        std::string scratch;
+    };
+}
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+
+#include "type.hpp"
+
+namespace ssq {
+    class Object;
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    namespace detail {
+        // Call stack that created an Object
+        struct RefSite {
+            static const int MAX_FRAMES = 16;
+            void* frames[MAX_FRAMES];
+            int depth;
+        };
+
+        // Registry of all live Objects, only compiled in with SSQ_TRACK_REFS
+        class SSQ_API RefTracker {
+        public:
+            static void track(const Object* object);
+            static void untrack(const Object* object);
+            // Calls the function for every live Object, no Object may be created
+            // or destroyed from within the function
+            static void forEach(const std::function<void(Object&, const RefSite&)>& func);
+            // Forgets the object and the VM without releasing it
+            static void detach(Object& object);
+            static void writeSite(std::ostream& out, const RefSite& site);
+        };
+    }
+#endif
+}
@@ -0,0 +1,294 @@
+#pragma once
+
+#include "exceptions.hpp"
+#include "type.hpp"
+
+#include <cassert>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace ssq {
+    class Object;
+    class ObjectRef;
+    class Table;
+    class Array;
+    class Function;
+    class Class;
+    class Instance;
+
+    /**
+    * @brief Kind of failure reported by an Error
+    * @ingroup simplesquirrel
+    */
+    enum class ErrorCode {
+        NONE = 0,
+        NOT_FOUND,
+        TYPE_MISMATCH,
+        ARGUMENT_MISMATCH,
+        COMPILE_ERROR,
+        RUNTIME_ERROR,
+        TIMEOUT
+    };
+
+    /**
+    * @brief Failure of a non-throwing operation
+    * @details Messages are copied unless they are wrapped in StaticText.
+    * The detailed error of the Squirrel VM is not copied, use sq_getlasterror()
+    * or raise() to get it.
+    * @ingroup simplesquirrel
+    */
+    class SSQ_API Error {
+    public:
+        /**
+        * @brief Creates an error with ErrorCode::NONE
+        */
+        Error():code(ErrorCode::NONE) {
+        }
+        /**
+        * @brief Creates an error with a code and a message
+        */
+        Error(ErrorCode code, detail::ExceptionText message):code(code), message(std::move(message)) {
+        }
+        /**
+        * @brief Creates an ErrorCode::TYPE_MISMATCH error
+        */
+        Error(detail::ExceptionText message, detail::ExceptionText expected, detail::ExceptionText got):
+            code(ErrorCode::TYPE_MISMATCH), message(std::move(message)), expected(std::move(expected)), got(std::move(got)) {
+        }
+        /**
+        * @brief Returns the kind of the failure
+        */
+        ErrorCode getCode() const {
+            return code;
+        }
+        /**
+        * @brief Returns the message, or the name of the missing entry for ErrorCode::NOT_FOUND
+        */
+        const char* getMessage() const {
+            return message.c_str();
+        }
+        /**
+        * @brief Throws the exception matching the code of this error
+        * @details The last error of the VM is added to the exception message
+        */
+        [[noreturn]] void raise(HSQUIRRELVM vm) const;
+
+    private:
+        ErrorCode code;
+        detail::ExceptionText message;
+        detail::ExceptionText expected;
+        detail::ExceptionText got;
+    };
+
+    /**
+    * @brief Value of a non-throwing operation, or the Error why it failed
+    * @details Returned by the try variants of lookups, conversions, compiling, running
+    * and calling scripts. They avoid the cost of throwing for expected failures, but
+    * do not make the library usable without exceptions: the rest of the API only
+    * reports errors by throwing, and building without exceptions is an error.
+    * @ingroup simplesquirrel
+    */
+    template<typename T>
+    class Result {
+    public:
+        /**
+        * @brief Creates a successful result
+        */
+        Result(T value) {
+            new (&storage) T(std::move(value));
+        }
+        /**
+        * @brief Creates a failed result
+        */
+        Result(Error error):err(std::move(error)) {
+            assert(!isOk());
+        }
+        /**
+        * @brief Copy constructor
+        */
+        Result(const Result& other):err(other.err) {
+            if (other.isOk()) new (&storage) T(other.get());
+        }
+        /**
+        * @brief Move constructor
+        */
+        Result(Result&& other):err(std::move(other.err)) {
+            if (other.isOk()) new (&storage) T(std::move(other.get()));
+        }
+        /**
+        * @brief Disabled copy assingment operator
+        */
+        Result& operator = (const Result& other) = delete;
+        ~Result() {
+            if (isOk()) get().~T();
+        }
+        /**
+        * @brief Returns true if the operation succeeded
+        */
+        bool isOk() const {
+            return err.getCode() == ErrorCode::NONE;
+        }
+        /**
+        * @brief Returns true if the operation succeeded
+        */
+        explicit operator bool() const {
+            return isOk();
+        }
+        /**
+        * @brief Returns the value
+        * @note Must not be called on a failed result
+        */
+        const T& value() const {
+            assert(isOk());
+            return get();
+        }
+        /**
+        * @brief Returns the value
+        * @note Must not be called on a failed result
+        */
+        T& value() {
+            assert(isOk());
+            return get();
+        }
+        /**
+        * @brief Returns the value, or the fallback if the operation failed
+        */
+        T valueOr(T fallback) const {
+            return isOk() ? get() : fallback;
+        }
+        /**
+        * @brief Returns the error, ErrorCode::NONE if the operation succeeded
+        */
+        const Error& getError() const {
+            return err;
+        }
+        /**
+        * @brief Returns the value, or throws the exception matching the error
+        */
+        T unwrap(HSQUIRRELVM vm) {
+            if (!isOk()) err.raise(vm);
+            return std::move(get());
+        }
+
+    private:
+        T& get() {
+            return *reinterpret_cast<T*>(&storage);
+        }
+        const T& get() const {
+            return *reinterpret_cast<const T*>(&storage);
+        }
+
+        typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+        Error err;
+    };
+
+    /**
+    * @brief Result of a non-throwing operation without a value
+    * @ingroup simplesquirrel
+    */
+    template<>
+    class Result<void> {
+    public:
+        /**
+        * @brief Creates a successful result
+        */
+        Result() {
+        }
+        /**
+        * @brief Creates a failed result
+        */
+        Result(Error error):err(std::move(error)) {
+        }
+        /**
+        * @brief Returns true if the operation succeeded
+        */
+        bool isOk() const {
+            return err.getCode() == ErrorCode::NONE;
+        }
+        /**
+        * @brief Returns true if the operation succeeded
+        */
+        explicit operator bool() const {
+            return isOk();
+        }
+        /**
+        * @brief Returns the error, ErrorCode::NONE if the operation succeeded
+        */
+        const Error& getError() const {
+            return err;
+        }
+        /**
+        * @brief Throws the exception matching the error, if any
+        */
+        void unwrap(HSQUIRRELVM vm) const {
+            if (!isOk()) err.raise(vm);
+        }
+
+    private:
+        Error err;
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    namespace detail {
+        // Checks the type of a stack slot before detail::pop<T>, types which can
+        // not be decided up front are accepted and checked by the pop itself
+        template<typename T, typename Enable = void>
+        struct ExpectedType {
+            static bool matches(SQObjectType) { return true; }
+            static const char* name() { return "ANY"; }
+        };
+        template<typename T>
+        struct ExpectedType<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+            static bool matches(SQObjectType type) { return type == OT_INTEGER || type == OT_FLOAT || type == OT_BOOL; }
+            static const char* name() { return "BOOL|INTEGER|FLOAT"; }
+        };
+        template<typename T>
+        struct ExpectedType<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+            static bool matches(SQObjectType type) { return type == OT_INTEGER || type == OT_FLOAT; }
+            static const char* name() { return "INTEGER|FLOAT"; }
+        };
+        template<>
+        struct ExpectedType<std::basic_string<SQChar>> {
+            static bool matches(SQObjectType type) { return type == OT_STRING; }
+            static const char* name() { return "STRING"; }
+        };
+        template<>
+        struct ExpectedType<Table> {
+            static bool matches(SQObjectType type) { return type == OT_TABLE; }
+            static const char* name() { return "TABLE"; }
+        };
+        template<>
+        struct ExpectedType<Array> {
+            static bool matches(SQObjectType type) { return type == OT_ARRAY; }
+            static const char* name() { return "ARRAY"; }
+        };
+        template<>
+        struct ExpectedType<Function> {
+            static bool matches(SQObjectType type) { return type == OT_CLOSURE || type == OT_NATIVECLOSURE; }
+            static const char* name() { return "CLOSURE"; }
+        };
+        template<>
+        struct ExpectedType<Class> {
+            static bool matches(SQObjectType type) { return type == OT_CLASS; }
+            static const char* name() { return "CLASS"; }
+        };
+        template<>
+        struct ExpectedType<Instance> {
+            static bool matches(SQObjectType type) { return type == OT_INSTANCE; }
+            static const char* name() { return "INSTANCE"; }
+        };
+
+        template<typename T>
+        inline Result<void> checkExpectedType(HSQUIRRELVM vm, SQInteger index) {
+            typedef ExpectedType<typename std::remove_cv<T>::type> Expected;
+            const SQObjectType type = sq_gettype(vm, index);
+            if (!Expected::matches(type)) {
+                return Error(StaticText("bad cast"), StaticText(Expected::name()), StaticText(typeToStr(Type(type))));
+            }
+            return Result<void>();
+        }
+    }
+#endif
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "coroutine.hpp"
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning( disable: 4251 )
+#endif
+
+namespace ssq {
+    /**
+    * @brief Cooperative scheduler of Squirrel tasks, each running in its own thread
+    * @details A task runs until it calls suspend() from Squirrel. The suspended value
+    * tells the scheduler when to resume it:
+    * - `suspend()` or `suspend(null)` yields, the task is resumed in the next round
+    * - `suspend(ms)` with a number sleeps for the given number of milliseconds
+    * - `suspend("name")` with a string waits until signal("name", value) is called,
+    * the value becomes the result of the suspend() call
+    *
+    * Ready tasks with a higher priority are always resumed first, tasks with the
+    * same priority are resumed in a round-robin fashion. Threads of finished tasks
+    * are kept and reused by new tasks.
+    * @ingroup simplesquirrel
+    */
+    class SSQ_API Scheduler {
+    public:
+        /**
+        * @brief Handle of a spawned task
+        */
+        typedef uint64_t TaskId;
+        /**
+        * @brief Called when a task throws, instead of rethrowing the exception from run()
+        */
+        typedef std::function<void(TaskId, const std::exception&)> ErrorHandler;
+        /**
+        * @brief Creates an empty scheduler
+        * @param vm The main VM or any of its threads
+        * @param stackSize The stack size of the threads created for the tasks, or zero
+        * to use VM::getSuggestedThreadStackSize() at the time each thread is created
+        */
+        explicit Scheduler(VM& vm, size_t stackSize = 0);
+        /**
+        * @brief Destroys all tasks and their threads
+        */
+        ~Scheduler();
+        /**
+        * @brief Disabled copy constructor
+        */
+        Scheduler(const Scheduler& other) = delete;
+        /**
+        * @brief Disabled copy assingment operator
+        */
+        Scheduler& operator = (const Scheduler& other) = delete;
+        /**
+        * @brief Spawns a new task with the default priority of zero
+        * @details The function is started immediately and runs until the first suspend()
+        * @throws RuntimeException if the function throws and no error handler is set
+        * @throws TimeoutException if the task is interrupted and no error handler is set
+        */
+        template<class... Args>
+        TaskId spawn(const Function& func, Args&&... args) {
+            return spawn(0, func, std::forward<Args>(args)...);
+        }
+        /**
+        * @brief Spawns a new task with a priority
+        * @see spawn(const Function& func, Args&&... args)
+        */
+        template<class... Args>
+        TaskId spawn(int priority, const Function& func, Args&&... args) {
+            const TaskId id = acquire(priority, func);
+            const TaskId previous = current;
+            current = id;
+            Object value;
+            try {
+                value = tasks[slotOf(id)].coroutine.start(std::forward<Args>(args)...);
+            } catch (const Exception& e) {
+                current = previous;
+                fail(id, e);
+                return id;
+            } catch (...) {
+                current = previous;
+                release(id);
+                throw;
+            }
+            current = previous;
+            dispatch(id, value);
+            return id;
+        }
+        /**
+        * @brief Wakes all tasks waiting for the named event
+        * @details The tasks are moved to the ready queue and resumed by the next run(),
+        * the value is returned by their suspend() call
+        * @returns Number of woken tasks
+        */
+        template<class T>
+        size_t signal(const std::string& name, const T& value) {
+            HSQUIRRELVM v = VM::getMain(vm).getHandle();
+            detail::push(v, value);
+            Object obj = detail::pop<Object>(v, -1);
+            sq_pop(v, 1);
+            return wake(name, obj);
+        }
+        /**
+        * @brief Wakes all tasks waiting for the named event with null
+        */
+        size_t signal(const std::string& name);
+        /**
+        * @brief Runs one round, resuming every task that is ready once
+        * @returns Number of resumed tasks
+        */
+        size_t run();
+        /**
+        * @brief Runs rounds until there are no ready tasks or the time slice is used up
+        * @details The time slice is checked after each resumed task, so a single task
+        * which does not suspend can exceed it.
+        * @returns Number of resumed tasks
+        */
+        size_t run(std::chrono::microseconds timeSlice);
+        /**
+        * @brief Cancels a task, its suspend() call never returns
+        * @returns False if the task has already finished
+        * @throws RuntimeException if the task cancels itself
+        */
+        bool cancel(TaskId id);
+        /**
+        * @brief Returns true if the task has not finished yet
+        */
+        bool isAlive(TaskId id) const;
+        /**
+        * @brief Returns the task being resumed, or zero outside of run() and spawn()
+        */
+        TaskId getCurrentTask() const;
+        /**
+        * @brief Returns the thread running the task, or nullptr if the task has finished
+        * @details Use it to limit the task with VM::setInstructionBudget() or VM::setDeadline().
+        * The budget is cleared once the task finishes, before the thread is reused.
+        */
+        VM* getThread(TaskId id);
+        /**
+        * @brief Returns the number of tasks that have not finished yet
+        */
+        size_t getNumOfTasks() const;
+        /**
+        * @brief Returns the number of tasks ready to be resumed
+        */
+        size_t getNumOfReadyTasks() const;
+        /**
+        * @brief Returns the time at which the earliest sleeping task wakes up
+        * @details Returns the maximum time point if no task is sleeping
+        */
+        std::chrono::steady_clock::time_point getNextWakeup() const;
+        /**
+        * @brief Sets a handler for exceptions thrown by the tasks
+        */
+        void setErrorHandler(const ErrorHandler& handler);
+    private:
+        struct Task {
+            Coroutine coroutine;
+            Object pending;
+            int priority;
+            uint32_t generation;
+            bool alive;
+            bool queued; // Counted by numOfReady
+        };
+
+        struct Timer {
+            std::chrono::steady_clock::time_point time;
+            TaskId id;
+
+            bool operator < (const Timer& other) const {
+                return time > other.time; // Earliest timer on the top of the heap
+            }
+        };
+
+        static size_t slotOf(TaskId id) {
+            return static_cast<size_t>(id & 0xFFFFFFFF);
+        }
+
+        TaskId acquire(int priority, const Function& func);
+        void release(TaskId id);
+        void dispatch(TaskId id, const Object& value);
+        void fail(TaskId id, const Exception& e);
+        size_t wake(const std::string& name, const Object& value);
+        void enqueue(TaskId id, Task& task);
+        void wakeTimers(std::chrono::steady_clock::time_point now);
+        size_t runRound(std::chrono::steady_clock::time_point deadline);
+        void resumeTask(TaskId id);
+        Task* find(TaskId id);
+        const Task* find(TaskId id) const;
+
+        HSQUIRRELVM vm;
+        size_t stackSize;
+        bool running;
+        TaskId current;
+        ErrorHandler errorHandler;
+
+        std::deque<Task> tasks;
+        std::vector<size_t> freeSlots;
+        size_t alive;
+
+        std::map<int, std::deque<TaskId>, std::greater<int>> ready;
+        size_t numOfReady;
+        std::vector<Timer> timers;
+        std::unordered_map<std::string, std::vector<TaskId>> waiting;
+    };
+}
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -16,7 +16,7 @@ namespace ssq {
         /**
         * @brief Destructor
         */
-        virtual ~Script() override = default;
+        ~Script() = default;
         /**
         * @brief Swaps two objects
         */
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vm.hpp"
+
+#include <istream>
+#include <ostream>
+
+namespace ssq {
+    /**
+    * @brief Version of the binary format written by serialize()
+    */
+    static const uint8_t SERIALIZER_VERSION = 1;
+    /**
+    * @brief Longest string accepted by deserialize(), in bytes
+    */
+    static const uint32_t SERIALIZER_MAX_STRING_SIZE = 64 * 1024 * 1024;
+    /**
+    * @brief Writes an object in a compact binary format
+    * @details The output starts with a four byte header, the characters "SSQ" followed by
+    * the format version. The rest is a MessagePack document, so any MessagePack library
+    * can read it after skipping the header. Null, booleans, integers, floats, strings,
+    * arrays and tables are supported. Containers are written directly from the VM,
+    * without intermediate copies.
+    * @throws TypeException if the object contains an unsupported value or a reference cycle
+    * @ingroup simplesquirrel
+    */
+    SSQ_API void serialize(const Object& object, std::ostream& out);
+    /**
+    * @brief Writes an object in a compact binary format into a string
+    * @see serialize(const Object& object, std::ostream& out)
+    * @ingroup simplesquirrel
+    */
+    SSQ_API std::string serialize(const Object& object);
+    /**
+    * @brief Reads an object written by serialize() from a stream
+    * @details The object is built directly in the VM while reading the stream. Sizes
+    * stored in the data are not trusted for allocations, memory only grows with the
+    * bytes actually read.
+    * @throws RuntimeException if the data is invalid or truncated, or contains a string
+    * longer than SERIALIZER_MAX_STRING_SIZE
+    * @ingroup simplesquirrel
+    */
+    SSQ_API Object deserialize(VM& vm, std::istream& in);
+    /**
+    * @brief Reads an object written by serialize() from memory
+    * @see deserialize(VM& vm, std::istream& in)
+    * @ingroup simplesquirrel
+    */
+    SSQ_API Object deserialize(VM& vm, const std::string& bytes);
+}
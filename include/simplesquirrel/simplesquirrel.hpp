@@ -8,11 +8,23 @@
 #include "exposable_class.hpp"
 #include "type.hpp"
 #include "exceptions.hpp"
+#include "result.hpp"
 #include "object.hpp"
+#include "object_ref.hpp"
 #include "function.hpp"
 #include "enum.hpp"
 #include "array.hpp"
+#include "buffer.hpp"
 #include "table.hpp"
 #include "instance.hpp"
 #include "script.hpp"
 #include "vm.hpp"
+#include "gc.hpp"
+#include "profiler.hpp"
+#include "coroutine.hpp"
+#include "scheduler.hpp"
+#include "executor.hpp"
+#include "transfer.hpp"
+#include "serializer.hpp"
+#include "json.hpp"
+#include "vecmath.hpp"
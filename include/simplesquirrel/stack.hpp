@@ -0,0 +1,78 @@
+#pragma once
+
+#include <squirrel.h>
+
+#ifdef SSQ_DEBUG_STACK
+#include <cassert>
+#endif
+
+namespace ssq {
+    /**
+    * @brief Restores the top of the stack of a VM when it goes out of scope
+    * @details All values pushed after the guard has been created are popped on every
+    * exit path, including exceptions. Functions which only push and pop a constant
+    * number of values and can not throw in between use plain sq_pop() instead.
+    * @ingroup simplesquirrel
+    */
+    class StackGuard {
+    public:
+        /**
+        * @brief Remembers the current top of the stack
+        */
+        explicit StackGuard(HSQUIRRELVM vm):vm(vm), top(sq_gettop(vm)) {
+        }
+        /**
+        * @brief Pops everything above the remembered top
+        */
+        ~StackGuard() {
+#ifdef SSQ_DEBUG_STACK
+            assert(sq_gettop(vm) >= top && "Popped more values than pushed");
+#endif
+            sq_settop(vm, top);
+        }
+        /**
+        * @brief Disabled copy constructor
+        */
+        StackGuard(const StackGuard& other) = delete;
+        /**
+        * @brief Disabled copy assingment operator
+        */
+        StackGuard& operator = (const StackGuard& other) = delete;
+        /**
+        * @brief Returns the remembered top of the stack
+        */
+        SQInteger getTop() const {
+            return top;
+        }
+    private:
+        HSQUIRRELVM vm;
+        SQInteger top;
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    namespace detail {
+#ifdef SSQ_DEBUG_STACK
+        // Asserts that the stack has the same size when leaving the scope
+        class StackCheck {
+        public:
+            explicit StackCheck(HSQUIRRELVM vm):vm(vm), top(vm ? sq_gettop(vm) : 0) {
+            }
+            ~StackCheck() {
+                assert((vm == nullptr || sq_gettop(vm) == top) && "Unbalanced stack");
+            }
+            StackCheck(const StackCheck& other) = delete;
+            StackCheck& operator = (const StackCheck& other) = delete;
+        private:
+            HSQUIRRELVM vm;
+            SQInteger top;
+        };
+#endif
+    }
+#endif
+}
+
+#ifdef SSQ_DEBUG_STACK
+#define SSQ_STACK_CHECK(vm) const ::ssq::detail::StackCheck ssqStackCheck(vm)
+#else
+#define SSQ_STACK_CHECK(vm) ((void)0)
+#endif
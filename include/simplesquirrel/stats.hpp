@@ -0,0 +1,96 @@
+#pragma once
+
+#include <squirrel.h>
+#include <stdint.h>
+#include <cstddef>
+
+#ifdef SSQ_NATIVE_STATS
+#include <chrono>
+#endif
+
+#include "type.hpp"
+
+namespace ssq {
+    /**
+    * @brief Timing counters of a bound C++ function
+    * @details Only collected when the library is built with SSQ_NATIVE_STATS,
+    * see VM::getNativeStats()
+    * @ingroup simplesquirrel
+    */
+    struct NativeCallStats {
+        /**
+        * @brief Number of calls from Squirrel
+        */
+        uint64_t calls = 0;
+        /**
+        * @brief Total time spent in the function, in nanoseconds
+        */
+        uint64_t totalNs = 0;
+        /**
+        * @brief The longest single call, in nanoseconds
+        */
+        uint64_t maxNs = 0;
+        /**
+        * @brief Number of calls that ended with an exception
+        */
+        uint64_t exceptions = 0;
+    };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    namespace detail {
+        SSQ_API void registerNativeStatsClass(HSQUIRRELVM vm, size_t hashCode, const char* name);
+        SSQ_API NativeCallStats* registerNativeStats(HSQUIRRELVM vm, const char* name, SQInteger classIdx);
+
+#ifdef SSQ_NATIVE_STATS
+        class NativeCallScope {
+        public:
+            template<typename F>
+            explicit NativeCallScope(const F* funcPtr):
+                stats(funcPtr->stats),
+                start(std::chrono::steady_clock::now()) {
+            }
+            ~NativeCallScope() {
+                if (!stats) return;
+                const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                stats->calls++;
+                stats->totalNs += ns;
+                if (ns > stats->maxNs) stats->maxNs = ns;
+            }
+            void fail() {
+                if (stats) stats->exceptions++;
+            }
+        private:
+            NativeCallStats* stats;
+            std::chrono::steady_clock::time_point start;
+        };
+#else
+        class NativeCallScope {
+        public:
+            template<typename F>
+            explicit NativeCallScope(const F*) {
+            }
+            void fail() {
+            }
+        };
+#endif
+
+        inline void attachNativeStatsClass(HSQUIRRELVM vm, size_t hashCode, const char* name) {
+#ifdef SSQ_NATIVE_STATS
+            registerNativeStatsClass(vm, hashCode, name);
+#else
+            (void)vm; (void)hashCode; (void)name;
+#endif
+        }
+
+        template<typename F>
+        inline void attachNativeStats(HSQUIRRELVM vm, F* funcPtr, const char* name, SQInteger classIdx) {
+#ifdef SSQ_NATIVE_STATS
+            funcPtr->stats = registerNativeStats(vm, name, classIdx);
+#else
+            (void)vm; (void)funcPtr; (void)name; (void)classIdx;
+#endif
+        }
+    }
+#endif
+}
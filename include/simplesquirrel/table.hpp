@@ -22,7 +22,7 @@ namespace ssq {
         /**
         * @brief Destructor
         */
-        virtual ~Table() override = default;
+        ~Table() = default;
         /**
         * @brief Converts Object to Table
         * @throws TypeException if the Object is not type of a table
@@ -69,10 +69,9 @@ namespace ssq {
         template<typename T, typename... Args, typename... DefaultArgs>
         Class addClass(const char* name, const std::function<T*(Args...)>& allocator = std::bind(&detail::defaultClassAllocator<T>),
                        DefaultArgumentsImpl<DefaultArgs...> defaultArgs = {}, bool release = true, Class base = Class()) {
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
-            Class cls(detail::addClass(vm, name, allocator, std::move(defaultArgs), base.getRaw(), release));
-            sq_pop(vm, 1);
-            return cls;
+            return Class(detail::addClass(vm, name, allocator, std::move(defaultArgs), base.getRaw(), release));
         }
         /**
         * @brief Adds a new class type, which could inherit another existing one, to this table
@@ -99,10 +98,9 @@ namespace ssq {
         */
         template<typename T>
         Class addAbstractClass(const char* name, Class base = Class()) {
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
-            Class cls(detail::addAbstractClass<T>(vm, name, base.getRaw()));
-            sq_pop(vm, 1);
-            return cls;
+            return Class(detail::addAbstractClass<T>(vm, name, base.getRaw()));
         }
         /**
         * @brief Adds a new function type to this table
@@ -111,39 +109,83 @@ namespace ssq {
         template<typename R, typename... Args, typename... DefaultArgs>
         Function addFunc(const char* name, const std::function<R(Args...)>& func, DefaultArgumentsImpl<DefaultArgs...> defaultArgs = {}){
             Function ret(vm);
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
             detail::addFunc(vm, name, func, std::move(defaultArgs));
-            sq_pop(vm, 1);
             return ret;
         }
         /**
         * @brief Adds a new lambda type to this table
+        * @details Captureless lambdas and function pointers are called directly, capturing
+        * lambdas and other callables are stored in a std::function.
+        * @note Passing default arguments falls back to a std::function for any callable,
+        * and so does every callable when built with SSQ_NATIVE_STATS
         * @returns Function object that references the added function
         */
         template<typename F, typename... DefaultArgs>
         Function addFunc(const char* name, const F& lambda, DefaultArgumentsImpl<DefaultArgs...> defaultArgs = {}) {
-            return addFunc(name, detail::make_function(lambda), std::move(defaultArgs));
+            Function ret(vm);
+            StackGuard guard(vm);
+            sq_pushobject(vm, obj);
+            detail::addCallable(vm, name, lambda, std::move(defaultArgs));
+            return ret;
+        }
+        /**
+        * @brief Adds native functions described by an array of FuncDef
+        * @details The table is pushed only once for the whole array, the flags are ignored
+        * @throws RuntimeException if VM is invalid or a function can not be added
+        */
+        void addFuncs(const FuncDef* defs, size_t count);
+        /**
+        * @brief Adds native functions described by an array of FuncDef
+        * @throws RuntimeException if VM is invalid or a function can not be added
+        */
+        template<size_t N>
+        void addFuncs(const FuncDef (&defs)[N]) {
+            addFuncs(defs, N);
         }
         /**
          * @brief Adds a new key-value pair to this table
+         * @throws RuntimeException if the entry cannot be added
          */
         template<typename T>
         inline void set(const char* name, const T& value) {
+            trySet(name, value).unwrap(vm);
+        }
+        /**
+         * @brief Adds a new key-value pair to this table without throwing
+         * @returns ErrorCode::RUNTIME_ERROR error if the entry cannot be added
+         */
+        template<typename T>
+        inline Result<void> trySet(const char* name, const T& value) {
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
             sq_pushstring(vm, name, strlen(name));
             detail::push<T>(vm, value);
             if (SQ_FAILED(sq_newslot(vm, -3, SQFalse))) {
-                throw RuntimeException(vm, "Cannot add entry '" + std::string(name) + "' to table!");
+                return Error(ErrorCode::RUNTIME_ERROR, "Cannot add entry '" + std::string(name) + "' to table!");
             }
-            sq_pop(vm,1); // pop table
+            return Result<void>();
         }
         /**
          * @brief Returns the value of an entry
          * @throws NotFoundException if an entry with the provided key does not exist
+         * @throws TypeException if the value is not a type of T
          */
         template<typename T>
         inline T get(const char* name) const {
-            return find(name).to<T>();
+            return tryGet<T>(name).unwrap(vm);
+        }
+        /**
+         * @brief Returns the value of an entry without throwing
+         * @returns ErrorCode::NOT_FOUND error if an entry with the provided key does not exist,
+         * or ErrorCode::TYPE_MISMATCH error if the value is not a type of T
+         */
+        template<typename T>
+        inline Result<T> tryGet(const char* name) const {
+            Result<Object> found = tryFind(name);
+            if (!found) return found.getError();
+            return found.value().tryTo<T>();
         }
         /**
          * @brief Provides the value of an entry, if it exists
@@ -151,13 +193,10 @@ namespace ssq {
          */
         template<typename T>
         inline bool get(const char* name, T& value) const {
-            try {
-                value = find(name).to<T>();
-                return true;
-            }
-            catch (const NotFoundException&) {
-                return false;
-            }
+            Result<Object> found = tryFind(name);
+            if (!found) return false;
+            value = found.value().to<T>();
+            return true;
         }
         /**
          * @brief Returns whether an entry with the provided key exists
@@ -197,7 +236,7 @@ namespace ssq {
          */
         template<typename T>
         std::map<std::string, T> convert() const {
-            const SQInteger old_top = sq_gettop(vm);
+            StackGuard guard(vm);
             sq_pushobject(vm, obj);
 
             std::map<std::string, T> map;
@@ -210,18 +249,31 @@ namespace ssq {
                 if (SQ_FAILED(sq_getstring(vm, -2, &key)))
                     throw RuntimeException(vm, "Cannot get string value for table entry key!");
                 else
-                    map.insert(key, detail::pop<T>(vm, -1));
+                    map.insert({ key, detail::pop<T>(vm, -1) });
 
                 sq_pop(vm, 2); // pop key and value of this iteration
             }
 
-            sq_settop(vm, old_top);
             return map;
         }
         /**
          * @brief Adds a new table to this table
          */
         Table addTable(const char* name);
+        /**
+         * @brief Registers an entry which is created on its first lookup
+         * @details The registrar is called with this table the first time the name is
+         * looked up, either by a script or by find(), and must add the entry, for
+         * example with addClass(). The entry is a regular slot afterwards. Lazy entries
+         * are resolved through a delegate with a _get metamethod, so they are not
+         * visible to the "in" operator or to iteration before they are created. The
+         * first call replaces an existing delegate of this table with a copy of its slots,
+         * metamethods included, and names which are not lazy are passed to its _get.
+         * Later changes to the replaced delegate are not seen by this table.
+         * @note Bound classes must be created before instances of them are pushed from C++
+         * @throws RuntimeException if the entry cannot be registered
+         */
+        void addLazy(const char* name, const std::function<void(Table&)>& registrar);
         /**
          * @brief Returns a table from the provided key. If such doesn't exist, it's created
          * @throws TypeException if the entry exists, but the value is not a table
@@ -242,7 +294,7 @@ namespace ssq {
         inline Table popValue(HSQUIRRELVM vm, SQInteger index){
             checkType(vm, index, OT_TABLE);
             Table val(vm);
-            if (SQ_FAILED(sq_getstackobj(vm, index, &val.getRaw()))) throw RuntimeException(vm, "Could not get Table from Squirrel stack!");
+            if (SQ_FAILED(sq_getstackobj(vm, index, &val.getRaw()))) throw RuntimeException(vm, StaticText("Could not get Table from Squirrel stack!"));
             sq_addref(vm, &val.getRaw());
             return val;
         }
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "vm.hpp"
+
+namespace ssq {
+    /**
+    * @brief Deep copies an object into another VM
+    * @details Tables, arrays, strings, numbers, booleans, null and instances of bound
+    * classes are copied. Tables and arrays referenced from several places are copied
+    * only once, so the copy keeps the same structure including reference cycles.
+    * Instances are copied with the copy constructor of their C++ class, which has to be
+    * bound in the destination VM as well. Delegates and instance members defined in
+    * Squirrel are not copied.
+    * @note If both VMs share the same main VM, the object is returned as it is
+    * @param object The object to copy
+    * @param dst The VM which will own the copy
+    * @throws TypeException if the object contains a value which cannot be copied
+    * @ingroup simplesquirrel
+    */
+    SSQ_API Object transfer(const Object& object, VM& dst);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "object.hpp"
+#include "stats.hpp"
 
 #include <functional>
 
@@ -50,18 +51,21 @@ namespace ssq {
         struct function_traits<ReturnType(ClassType::*)(Args...) const> {
             //enum { arity = sizeof...(Args) };
             typedef std::function<ReturnType (Args...)> f_type;
+            typedef ReturnType (*pointer_type)(Args...);
         };
 
         // for pointers to member function
         template <typename ClassType, typename ReturnType, typename... Args>
         struct function_traits<ReturnType(ClassType::*)(Args...) > {
             typedef std::function<ReturnType (Args...)> f_type;
+            typedef ReturnType (*pointer_type)(Args...);
         };
 
         // for function pointers
         template <typename ReturnType, typename... Args>
         struct function_traits<ReturnType (*)(Args...)>  {
             typedef std::function<ReturnType (Args...)> f_type;
+            typedef ReturnType (*pointer_type)(Args...);
         };
 
         template <typename L>
@@ -73,11 +77,17 @@ namespace ssq {
         template<class Ret>
         struct FuncPtr {
             const std::function<Ret()>* ptr;
+#ifdef SSQ_NATIVE_STATS
+            NativeCallStats* stats;
+#endif
         };
 
         template<class Ret, typename... Args>
         struct FuncPtr<Ret(Args...)> {
             const std::function<Ret(Args...)>* ptr;
+#ifdef SSQ_NATIVE_STATS
+            NativeCallStats* stats;
+#endif
         };
 
         template<typename... Args>
@@ -101,5 +111,17 @@ namespace ssq {
             std::rethrow_exception(std::current_exception());
         }
     }
+
+    /**
+     * @ingroup simplesquirrel
+     */
+    template<typename T>
+    inline Result<T> Object::tryTo() const {
+        StackGuard guard(vm);
+        sq_pushobject(vm, obj);
+        Result<void> checked = detail::checkExpectedType<T>(vm, -1);
+        if (!checked) return checked.getError();
+        return detail::pop<T>(vm, -1);
+    }
 #endif
 }
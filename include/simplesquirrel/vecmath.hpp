@@ -0,0 +1,62 @@
+#pragma once
+
+#include "vm.hpp"
+
+namespace ssq {
+    /**
+    * @brief Vectorized numeric kernels over buffers and arrays
+    * @details Float and double buffers are processed with AVX2 or SSE2 instructions,
+    * selected at runtime based on the CPU, with a scalar fallback. Integer buffers and
+    * arrays use scalar loops, arrays are converted to a temporary buffer first.
+    * @ingroup simplesquirrel
+    */
+    namespace vecmath {
+        /**
+        * @brief Instruction set used by the float and double kernels
+        */
+        enum class InstructionSet {
+            SCALAR,
+            SSE2,
+            AVX2
+        };
+        /**
+        * @brief Returns the instruction set detected on this CPU
+        */
+        SSQ_API InstructionSet getInstructionSet();
+        /**
+        * @brief Returns the sum of the elements
+        */
+        SSQ_API float sum(const float* data, size_t size);
+        /**
+        * @brief Returns the sum of the elements
+        */
+        SSQ_API double sum(const double* data, size_t size);
+        /**
+        * @brief Returns the dot product of two arrays of the same size
+        */
+        SSQ_API float dot(const float* a, const float* b, size_t size);
+        /**
+        * @brief Returns the dot product of two arrays of the same size
+        */
+        SSQ_API double dot(const double* a, const double* b, size_t size);
+        /**
+        * @brief Multiplies all elements by the factor in place
+        */
+        SSQ_API void scale(float* data, size_t size, float factor);
+        /**
+        * @brief Multiplies all elements by the factor in place
+        */
+        SSQ_API void scale(double* data, size_t size, double factor);
+        /**
+        * @brief Registers the vecmath table into the table on top of the stack, used
+        * by Libs::VECMATH
+        * @details The table contains the functions sum(x), min(x), max(x), dot(a, b),
+        * scale(x, factor) operating on buffers or arrays of numbers, and
+        * buffer(size, type = "float") creating a zero initialized buffer with elements
+        * of type "int8", "uint8", "int16", "uint16", "int32", "uint32", "int64",
+        * "float" or "double". min() and max() return null for empty inputs, scale()
+        * modifies its argument in place and returns it.
+        */
+        SSQ_API void registerLib(HSQUIRRELVM vm);
+    }
+}
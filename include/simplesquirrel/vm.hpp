@@ -8,8 +8,14 @@
 #include "instance.hpp"
 #include "function.hpp"
 #include "array.hpp"
+#include "buffer.hpp"
+#include "gc.hpp"
 
+#include <chrono>
+#include <map>
 #include <memory>
+#include <ostream>
+#include <tuple>
 
 #ifdef _MSC_VER
 #pragma warning( push )
@@ -17,6 +23,7 @@
 #endif
 
 namespace ssq {
+    class Profiler;
     /**
      * @ingroup simplesquirrel
      */
@@ -44,10 +51,29 @@ namespace ssq {
         MATH = 0x0004,
         SYSTEM = 0x0008,
         STRING = 0x0010,
+        JSON = 0x0020,
+        VECMATH = 0x0040,
         ALL = 0xFFFF
       };
     }
 
+    /**
+    * @brief Stack usage of a VM or a thread, see VM::setStackTracking()
+    * @ingroup simplesquirrel
+    */
+    struct StackStats {
+        /**
+        * @brief Highest number of stack slots used by script functions at once
+        * @details Sum of the frame sizes of all nested script functions, slightly
+        * overestimated because the arguments of a call are shared by two frames
+        */
+        size_t peakSlots = 0;
+        /**
+        * @brief Deepest nesting of script function calls
+        */
+        size_t peakDepth = 0;
+    };
+
     /**
     * @brief Squirrel Virtual Machine object
     * @ingroup simplesquirrel
@@ -80,7 +106,7 @@ namespace ssq {
         /**
         * @brief Destructor
         */
-        virtual ~VM() override;
+        ~VM();
         /**
         * @brief Swaps the contents of this VM with another one
         */
@@ -145,6 +171,80 @@ namespace ssq {
         */
         SQInteger getTop() const;
         /**
+        * @brief Enables or disables debug info for scripts compiled afterwards
+        * @details Debug info is required for line events, used by the Profiler
+        * to attribute samples to individual lines.
+        */
+        void enableDebugInfo(bool enable);
+        /**
+        * @brief Interrupts this VM at its next call into C++ once it has executed a
+        * number of instructions
+        * @details Instructions are counted as executed lines, function calls and
+        * returns. Once the budget is exhausted, the VM is interrupted: the next call
+        * of a bound C++ function raises a Squirrel error instead of running, and the
+        * call from C++ that ran the script throws TimeoutException once it returns.
+        * The VM stays interrupted, failing every call, until clearBudget() is called
+        * or a new budget is set. The budget is shared by all calls made through this
+        * VM until it is cleared.
+        * @note This is not a hard limit. Squirrel offers no way to abort a script from
+        * the debug hook, so the interrupt is only delivered at the boundaries above,
+        * and a script keeps running until it reaches one. Lines are only counted
+        * in scripts compiled with debug info, see enableDebugInfo(), and a line event
+        * is only emitted when the executed line changes, so a loop written on a single
+        * line is counted once per call. A loop which never calls a bound C++ function,
+        * such as while (true) {}, or catches the error and keeps looping, is not
+        * stopped at all.
+        */
+        void setInstructionBudget(uint64_t instructions);
+        /**
+        * @brief Interrupts this VM at its next call into C++ once the deadline has passed
+        * @details The clock is checked every 1024 instructions, the same rules as for
+        * setInstructionBudget() apply.
+        */
+        void setDeadline(std::chrono::steady_clock::time_point deadline);
+        /**
+        * @brief Sets a deadline relative to the current time
+        * @see setDeadline()
+        */
+        void setTimeLimit(std::chrono::milliseconds limit);
+        /**
+        * @brief Removes both the instruction budget and the deadline, and clears the interrupt
+        */
+        void clearBudget();
+        /**
+        * @brief Returns true if an instruction budget or a deadline is set
+        * @details Returns false once the budget has been exhausted, see isInterrupted()
+        */
+        bool hasBudget() const;
+        /**
+        * @brief Returns true if the budget or the deadline has been exceeded
+        */
+        bool isInterrupted() const;
+        /**
+        * @brief Returns the number of instructions left in the budget
+        */
+        uint64_t getRemainingInstructions() const;
+        /**
+        * @brief Enables collecting the stack usage of this VM and all of its threads
+        * @details Every script function call and return is observed through the debug
+        * hook, which slows down calls slightly. Enabling resets the collected stats.
+        * @note Can only be called on the main VM
+        */
+        void setStackTracking(bool enable);
+        /**
+        * @brief Returns the stack usage of this VM or thread collected so far
+        */
+        const StackStats& getStackStats() const;
+        /**
+        * @brief Resets the collected stack usage of this VM or thread
+        */
+        void resetStackStats();
+        /**
+        * @brief Returns the controller of the cycle collector of this VM
+        * @details Threads share the collector of their main VM
+        */
+        GarbageCollector gc();
+        /**
         * @brief Returns the last compilation exception
         */
         /*
@@ -168,6 +268,11 @@ namespace ssq {
         */
         Script compileSource(const char* source, const char* name = "buffer");
         /**
+        * @brief Compiles a script from memory without throwing
+        * @returns ErrorCode::COMPILE_ERROR error if the source cannot be compiled
+        */
+        Result<Script> tryCompileSource(const char* source, const char* name = "buffer");
+        /**
         * @brief Compiles a script from an input stream
         * @details The script can be associated with a name as a second parameter.
         * This name is used during runtime error information.
@@ -175,41 +280,75 @@ namespace ssq {
         */
         Script compileSource(std::istream& source, const char* name = "buffer");
         /**
+        * @brief Compiles a script from an input stream without throwing
+        * @returns ErrorCode::COMPILE_ERROR error if the source cannot be compiled
+        */
+        Result<Script> tryCompileSource(std::istream& source, const char* name = "buffer");
+        /**
         * @brief Compiles a script from a source file
         * @throws CompileException
         */
         Script compileFile(const char* path);
         /**
+        * @brief Compiles a script from a source file without throwing
+        * @returns ErrorCode::COMPILE_ERROR error if the file cannot be read or compiled
+        */
+        Result<Script> tryCompileFile(const char* path);
+        /**
         * @brief Runs a script
         * @details When the script runs for the first time, the contens such as
         * class definitions are assigned to the root table (global table).
         * @throws RuntimeException
+        * @throws TimeoutException if the VM has been interrupted, see setInstructionBudget()
         */
         void run(const Script& script, bool printCallstack = false);
         /**
+        * @brief Runs a script without throwing
+        * @returns ErrorCode::RUNTIME_ERROR error if the script is empty or fails, or
+        * ErrorCode::TIMEOUT error if the VM has been interrupted
+        */
+        Result<void> tryRun(const Script& script, bool printCallstack = false);
+        /**
         * @brief Runs a script and returns its return value as an Object
         * @details When the script runs for the first time, the contens such as
         * class definitions are assigned to the root table (global table).
         * @returns A return value as an Object
         * @throws RuntimeException
+        * @throws TimeoutException if the VM has been interrupted, see setInstructionBudget()
         */
         Object runAndReturn(const Script& script, bool printCallstack = false);
         /**
+        * @brief Runs a script and returns its return value without throwing
+        * @returns ErrorCode::RUNTIME_ERROR error if the script is empty or fails, or
+        * ErrorCode::TIMEOUT error if the VM has been interrupted
+        */
+        Result<Object> tryRunAndReturn(const Script& script, bool printCallstack = false);
+        /**
         * @brief Calls a global function
         * @param func The instance of a function
         * @param args Any number of arguments
         * @throws RuntimeException if an exception is thrown or number of arguments
         * do not match
         * @throws TypeException if casting from Squirrel objects to C++ objects failed
+        * @throws TimeoutException if the VM has been interrupted, see setInstructionBudget()
         */
         template<class... Args>
         Object callFunc(const Function& func, const Object& env, Args&&... args) const {
+            return tryCallFunc(func, env, std::forward<Args>(args)...).unwrap(vm);
+        }
+        /**
+        * @brief Calls a global function without throwing
+        * @param func The instance of a function
+        * @param args Any number of arguments
+        * @returns ErrorCode::ARGUMENT_MISMATCH error if number of arguments do not
+        * match, ErrorCode::RUNTIME_ERROR error if the call fails, or ErrorCode::TIMEOUT
+        * error if the VM has been interrupted
+        */
+        template<class... Args>
+        Result<Object> tryCallFunc(const Function& func, const Object& env, Args&&... args) const {
             static const std::size_t params = sizeof...(Args);
-
-            const auto funcParams = func.getNumOfParams();
-            if(params < funcParams.first || params > funcParams.second) {
-                throw RuntimeException(nullptr, "Number of arguments does not match");
-            }
+            Result<void> checked = checkNumOfParams(func, params);
+            if (!checked) return checked.getError();
 
             auto top = sq_gettop(vm);
             sq_pushobject(vm, func.getRaw());
@@ -220,6 +359,69 @@ namespace ssq {
             return callAndReturn(params, top);
         }
         /**
+        * @brief Calls a function once for every tuple of arguments and collects the results
+        * @details The number of arguments is checked and the function is pushed only once
+        * for the whole batch. Each call pushes the environment and its arguments, and the
+        * return value is converted to R directly from the stack, without creating an
+        * intermediate Object.
+        * @param func The instance of a function
+        * @param env The environment passed to every call
+        * @param tuples Range of std::tuple, each holding the arguments of one call
+        * @param out Output iterator receiving one R per call
+        * @returns The output iterator past the last result
+        * @throws RuntimeException if the number of arguments does not match or a call
+        * fails, the results of the previous calls have already been written to out
+        * @throws TypeException if a return value can not be converted to R
+        * @throws TimeoutException if the VM has been interrupted, see setInstructionBudget()
+        */
+        template<class R, class Range, class OutputIt>
+        OutputIt callBatch(const Function& func, const Object& env, const Range& tuples, OutputIt out) const {
+            typedef typename std::decay<decltype(*std::begin(tuples))>::type Tuple;
+            static const std::size_t params = std::tuple_size<Tuple>::value;
+            checkNumOfParams(func, params).unwrap(vm);
+            checkInterrupt().unwrap(vm);
+
+            StackGuard guard(vm);
+            sq_pushobject(vm, func.getRaw());
+            for (const auto& args : tuples) {
+                sq_pushobject(vm, env.getRaw());
+                pushTuple(args, detail::index_range<0, params>());
+                // The closure stays on the stack, only the arguments are popped
+                if (SQ_FAILED(sq_call(vm, 1 + params, SQTrue, SQTrue))) {
+                    checkInterrupt().unwrap(vm);
+                    throw RuntimeException(vm, "Error running script!");
+                }
+                checkInterrupt().unwrap(vm);
+                *out = detail::pop<R>(vm, -1);
+                ++out;
+                sq_pop(vm, 1);
+            }
+            return out;
+        }
+        /**
+        * @brief Calls a function once for every tuple of arguments, discarding the results
+        * @see callBatch(const Function&, const Object&, const Range&, OutputIt)
+        */
+        template<class Range>
+        void callBatch(const Function& func, const Object& env, const Range& tuples) const {
+            typedef typename std::decay<decltype(*std::begin(tuples))>::type Tuple;
+            static const std::size_t params = std::tuple_size<Tuple>::value;
+            checkNumOfParams(func, params).unwrap(vm);
+            checkInterrupt().unwrap(vm);
+
+            StackGuard guard(vm);
+            sq_pushobject(vm, func.getRaw());
+            for (const auto& args : tuples) {
+                sq_pushobject(vm, env.getRaw());
+                pushTuple(args, detail::index_range<0, params>());
+                if (SQ_FAILED(sq_call(vm, 1 + params, SQFalse, SQTrue))) {
+                    checkInterrupt().unwrap(vm);
+                    throw RuntimeException(vm, "Error running script!");
+                }
+                checkInterrupt().unwrap(vm);
+            }
+        }
+        /**
         * @brief Creates a new instance of class and call constructor with given arguments
         * @param cls The object of a class
         * @param args Any number of arguments
@@ -239,13 +441,12 @@ namespace ssq {
         */
         Instance newInstanceNoCtor(const Class& cls) const {
             Instance inst(vm);
+            StackGuard guard(vm);
             sq_pushobject(vm, cls.getRaw());
             if (SQ_FAILED(sq_createinstance(vm, -1)))
               throw RuntimeException(vm, "Cannot create instance.");
-            sq_remove(vm, -2);
             sq_getstackobj(vm, -1, &inst.getRaw());
             sq_addref(vm, &inst.getRaw());
-            sq_pop(vm, 1);
             return inst;
         }
         /**
@@ -257,7 +458,7 @@ namespace ssq {
         * @throws RuntimeException
         */
         Instance newInstancePtr(Table& table, const Class& cls, const char* name, ExposableClass* ptr) const {
-            const SQInteger old_top = sq_gettop(vm);
+            StackGuard guard(vm);
             sq_pushobject(vm, table.getRaw());
 
             Instance inst(vm);
@@ -272,7 +473,6 @@ namespace ssq {
             if (SQ_FAILED(sq_createslot(vm, -3)))
               throw RuntimeException(vm, "Couldn't create table slot for instance.");
 
-            sq_settop(vm, old_top);
             return inst;
         }
         /**
@@ -281,10 +481,25 @@ namespace ssq {
         */
         VM newThread(size_t stackSize);
         /**
+        * @brief Creates a new thread sized by getSuggestedThreadStackSize()
+        */
+        VM newThread();
+        /**
+        * @brief Returns a stack size covering the deepest thread observed so far
+        * @details Based on the peaks of all threads collected while stack tracking is
+        * enabled, with some headroom. Squirrel grows a stack that turns out too small,
+        * at the cost of a reallocation. Returns 1024 until a thread has been observed.
+        * @note Can only be called on the main VM
+        */
+        size_t getSuggestedThreadStackSize() const;
+        /**
         * @brief Destroy a thread created from this main VM
         * @param threadVM Reference to the thread VM object to be destroyed
+        * @param collectGarbage Runs the garbage collector afterwards, disable
+        * it when destroying many threads at once and collect once at the end.
+        * The collection is only scheduled while paused, see GarbageCollector.
         */
-        void destroyThread(VM& threadVM);
+        void destroyThread(VM& threadVM, bool collectGarbage = true);
         /**
         * @brief Creates a new empty table
         */
@@ -304,6 +519,29 @@ namespace ssq {
         Array newArray(const std::vector<T>& vector) const {
             return Array(vm, vector);
         }
+        /**
+        * @brief Creates a new buffer of zero initialized elements owned by the VM
+        * @details The elements are stored in the same allocation as the userdata
+        * itself, they are released once no script or C++ object references it.
+        */
+        template<typename T>
+        Buffer<T> newBuffer(size_t size) const {
+            detail::pushBuffer(vm, detail::BufferTraits<T>::type, sizeof(T), size, nullptr);
+            Buffer<T> buffer(detail::popValue<Object>(vm, -1));
+            sq_pop(vm, 1);
+            return buffer;
+        }
+        /**
+        * @brief Creates a new buffer pointing at existing memory
+        * @note The memory is not copied, it must outlive all references to the buffer
+        */
+        template<typename T>
+        Buffer<T> newBufferView(T* data, size_t size) const {
+            detail::pushBuffer(vm, detail::BufferTraits<T>::type, sizeof(T), size, data);
+            Buffer<T> buffer(detail::popValue<Object>(vm, -1));
+            sq_pop(vm, 1);
+            return buffer;
+        }
         /**
          * @brief Adds a new enum to this table
          */
@@ -313,26 +551,55 @@ namespace ssq {
          */
         template<typename T>
         inline void setConst(const char* name, const T& value) {
+            StackGuard guard(vm);
             sq_pushconsttable(vm);
             sq_pushstring(vm, name, strlen(name));
             detail::push<T>(vm, value);
             if(SQ_FAILED(sq_newslot(vm, -3, SQFalse))) {
                 throw RuntimeException(vm, "Failed to add value '" + std::string(name) + "' to constant table!");
             }
-            sq_pop(vm,1); // pop table
         }
         /**
         * @brief Prints stack objects
         */
         void debugStack() const;
         /**
+        * @brief Returns the number of live C++ handles to objects of this VM and its threads
+        * @details Only handles to reference counted objects are counted, the VM itself is not.
+        * @note Only available when built with SSQ_TRACK_REFS, otherwise returns zero
+        */
+        size_t countLiveRefs() const;
+        /**
+        * @brief Writes every live C++ handle to objects of this VM and its threads
+        * @details The report starts with the number of handles per type, followed by
+        * the call stack that created each handle. When the main VM is destroyed, the
+        * same report is written to std::cerr for the handles which outlive it, and
+        * those handles are emptied so they do not release into the closed VM.
+        * @note Only available when built with SSQ_TRACK_REFS, otherwise writes a note
+        */
+        void dumpLiveRefs(std::ostream& out) const;
+        /**
+        * @brief Returns timing counters of all bound C++ functions
+        * @details The functions are keyed by their bound name, methods and constructors
+        * are prefixed by the name of their class, for example "Foo.bar".
+        * @note Counters are only collected when built with SSQ_NATIVE_STATS, otherwise
+        * the returned map is empty
+        */
+        const std::map<std::string, NativeCallStats>& getNativeStats() const;
+        /**
+        * @brief Resets timing counters of all bound C++ functions to zero
+        */
+        void resetNativeStats();
+        /**
         * @brief Add registered class object into the table of known classes
+        * @details Every main VM has its own table, shared with its threads
         */
-        static void addClassObj(size_t hashCode, const HSQOBJECT& obj);
+        void addClassObj(size_t hashCode, const HSQOBJECT& obj);
         /**
         * @brief Get registered class object from hash code
+        * @throws std::out_of_range if the class has not been registered
         */
-        static const HSQOBJECT& getClassObj(size_t hashCode);
+        const HSQOBJECT& getClassObj(size_t hashCode) const;
         /**
         * @brief Copy assingment operator
         */
@@ -342,18 +609,60 @@ namespace ssq {
         */
         VM& operator = (VM&& other) NOEXCEPT;
     private:
-        static std::unordered_map<size_t, HSQOBJECT> classMap;
+        friend class Profiler;
+        friend class GarbageCollector;
+        friend class GarbageCollector::Pause;
+        friend NativeCallStats* detail::registerNativeStats(HSQUIRRELVM vm, const char* name, SQInteger classIdx);
+        friend void detail::registerNativeStatsClass(HSQUIRRELVM vm, size_t hashCode, const char* name);
+        friend bool detail::raiseInterrupt(HSQUIRRELVM vm);
+        friend void detail::addClassCopier(HSQUIRRELVM vm, size_t hashCode, const detail::ClassCopier& copier);
+        friend const detail::ClassCopier* detail::getClassCopier(HSQUIRRELVM vm, size_t hashCode);
 
-        std::vector<HSQOBJECT> threads; // Only used in the main VM
+
+        std::unordered_map<size_t, HSQOBJECT> classMap; // Only used in the main VM
+        std::unordered_map<size_t, detail::ClassCopier> classCopiers; // Only used in the main VM
+        std::unordered_map<HSQUIRRELVM, HSQOBJECT> threads; // Only used in the main VM
         //std::unique_ptr<CompileException> compileException;
         //std::unique_ptr<RuntimeException> runtimeException;
         void* foreignPtr;
+        Profiler* profiler; // Only used in the main VM
+        std::map<std::string, NativeCallStats> nativeStats; // Only used in the main VM
+        std::unordered_map<size_t, std::string> nativeStatsClassNames; // Only used in the main VM
+        bool hasInstructionBudget;
+        uint64_t instructionBudget;
+        bool hasDeadline;
+        uint32_t deadlineCounter;
+        std::chrono::steady_clock::time_point deadline;
+        const char* interruptReason; // Set by the debug hook once the budget is exceeded
+        bool stackTracking; // Only used in the main VM
+        size_t threadStackPeak; // Only used in the main VM
+        std::vector<SQInteger> stackFrames; // Sizes of the active script frames
+        size_t stackSlots;
+        StackStats stackStats;
+        detail::GcState gcState; // Only used in the main VM
 
         /**
         * @brief Creates a VM object for a thread
         */
         VM(const HSQOBJECT& threadObj);
 
+        /**
+        * @brief Installs or removes the native debug hook on the VM and its threads
+        * @details The hook is only installed while something consumes its events,
+        * so there is no cost otherwise.
+        */
+        void updateDebugHook();
+        bool needsDebugHook(HSQUIRRELVM handle) const;
+#ifdef SSQ_TRACK_REFS
+        bool holdsLiveRef(const Object& object) const;
+        void writeLiveRefs(std::ostream& out) const;
+        void detachLiveRefs();
+#endif
+        void consumeBudget();
+        Result<void> checkInterrupt() const;
+        void trackStack(SQInteger type);
+        static void debugHook(HSQUIRRELVM vm, SQInteger type, const SQChar*, SQInteger, const SQChar*);
+
         static void pushArgs();
 
         template <class First, class... Rest> 
@@ -362,7 +671,14 @@ namespace ssq {
             pushArgs(std::forward<Rest>(rest)...);
         }
 
-        Object callAndReturn(SQUnsignedInteger nparams, SQInteger top) const;
+        template<class Tuple, int... Is>
+        void pushTuple(const Tuple& args, detail::index_list<Is...>) const {
+            pushArgs(std::get<Is>(args)...);
+        }
+
+        static Result<void> checkNumOfParams(const Function& func, std::size_t params);
+
+        Result<Object> callAndReturn(SQUnsignedInteger nparams, SQInteger top) const;
 
         static void defaultPrintFunc(HSQUIRRELVM vm, const SQChar *s, ...);
         static void defaultErrorFunc(HSQUIRRELVM vm, const SQChar *s, ...);
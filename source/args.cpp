@@ -32,7 +32,17 @@ namespace ssq {
             sq_pushobject(vm, value.getRaw());
         }
         void pushRaw(HSQUIRRELVM vm, const SqWeakRef& value) {
-            sq_pushobject(vm, value.getRaw());
+            if (value.isEmpty()) {
+                sq_pushnull(vm);
+                return;
+            }
+            sq_pushobject(vm, value.getRaw());
+            if (SQ_FAILED(sq_getweakrefval(vm, -1))) {
+                sq_pop(vm, 1);
+                sq_pushnull(vm);
+                return;
+            }
+            sq_remove(vm, -2);
         }
     }
 }
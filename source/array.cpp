@@ -24,6 +24,7 @@ namespace ssq {
     }
 
     size_t Array::size() {
+        SSQ_STACK_CHECK(vm);
         sq_pushobject(vm, obj);
         SQInteger s = sq_getsize(vm, -1);
         sq_pop(vm, 1);
@@ -35,21 +36,20 @@ namespace ssq {
     }
 
     void Array::pop() {
+        StackGuard guard(vm);
         sq_pushobject(vm, obj);
         const size_t s = static_cast<size_t>(sq_getsize(vm, -1));
         if(s == 0) {
-            sq_pop(vm, 1);
             throw RuntimeException(vm, "Failed to pop empty array!");
         }
 
         if(SQ_FAILED(sq_arraypop(vm, -1, SQFalse))) {
-            sq_pop(vm, 1);
             throw RuntimeException(vm, "Failed to pop value from the back of array!");
         }
-        sq_pop(vm, 1);
     }
 
     void Array::clear() {
+        SSQ_STACK_CHECK(vm);
         sq_pushobject(vm, obj);
         sq_clear(vm, -1);
         sq_pop(vm, 1);
@@ -0,0 +1,200 @@
+#include <squirrel.h>
+#include <sqstdblob.h>
+#include <cstring>
+
+#include "simplesquirrel/buffer.hpp"
+
+namespace ssq {
+    namespace {
+        // Its address is used as the type tag of buffers and as the registry key of their delegate
+        const char bufferTag = 0;
+
+        struct Header {
+            void* data;
+            size_t size;
+            detail::BufferType type;
+        };
+
+        // Elements stored in the userdata follow the header
+        const size_t HEADER_SIZE = (sizeof(Header) + 15) & ~static_cast<size_t>(15);
+
+        Header* getHeader(HSQUIRRELVM vm, SQInteger index) {
+            SQUserPointer ptr;
+            SQUserPointer typeTag;
+            if (sq_gettype(vm, index) != OT_USERDATA || SQ_FAILED(sq_getuserdata(vm, index, &ptr, &typeTag)))
+                return nullptr;
+            if (typeTag != &bufferTag) return nullptr;
+            return static_cast<Header*>(ptr);
+        }
+
+        template<typename T>
+        T* element(const Header* header, SQInteger index) {
+            return static_cast<T*>(header->data) + index;
+        }
+
+        void pushElement(HSQUIRRELVM vm, const Header* header, SQInteger index) {
+            switch (header->type) {
+                case detail::BufferType::INT8: sq_pushinteger(vm, *element<int8_t>(header, index)); break;
+                case detail::BufferType::UINT8: sq_pushinteger(vm, *element<uint8_t>(header, index)); break;
+                case detail::BufferType::INT16: sq_pushinteger(vm, *element<int16_t>(header, index)); break;
+                case detail::BufferType::UINT16: sq_pushinteger(vm, *element<uint16_t>(header, index)); break;
+                case detail::BufferType::INT32: sq_pushinteger(vm, *element<int32_t>(header, index)); break;
+                case detail::BufferType::UINT32: sq_pushinteger(vm, static_cast<SQInteger>(*element<uint32_t>(header, index))); break;
+                case detail::BufferType::INT64: sq_pushinteger(vm, static_cast<SQInteger>(*element<int64_t>(header, index))); break;
+                case detail::BufferType::FLOAT: sq_pushfloat(vm, static_cast<SQFloat>(*element<float>(header, index))); break;
+                case detail::BufferType::DOUBLE: sq_pushfloat(vm, static_cast<SQFloat>(*element<double>(header, index))); break;
+                default: sq_pushnull(vm); break;
+            }
+        }
+
+        void setElement(HSQUIRRELVM vm, Header* header, SQInteger index, SQInteger value) {
+            SQInteger integer = 0;
+            SQFloat number = 0;
+            sq_getinteger(vm, value, &integer);
+            sq_getfloat(vm, value, &number);
+            switch (header->type) {
+                case detail::BufferType::INT8: *element<int8_t>(header, index) = static_cast<int8_t>(integer); break;
+                case detail::BufferType::UINT8: *element<uint8_t>(header, index) = static_cast<uint8_t>(integer); break;
+                case detail::BufferType::INT16: *element<int16_t>(header, index) = static_cast<int16_t>(integer); break;
+                case detail::BufferType::UINT16: *element<uint16_t>(header, index) = static_cast<uint16_t>(integer); break;
+                case detail::BufferType::INT32: *element<int32_t>(header, index) = static_cast<int32_t>(integer); break;
+                case detail::BufferType::UINT32: *element<uint32_t>(header, index) = static_cast<uint32_t>(integer); break;
+                case detail::BufferType::INT64: *element<int64_t>(header, index) = static_cast<int64_t>(integer); break;
+                case detail::BufferType::FLOAT: *element<float>(header, index) = static_cast<float>(number); break;
+                case detail::BufferType::DOUBLE: *element<double>(header, index) = static_cast<double>(number); break;
+                default: break;
+            }
+        }
+
+        // Returns the header, or null if the index is not valid and the error has been thrown
+        Header* checkIndex(HSQUIRRELVM vm, SQInteger& index) {
+            Header* header = getHeader(vm, 1);
+            if (header == nullptr) {
+                sq_throwerror(vm, "not a buffer");
+                return nullptr;
+            }
+            if (sq_gettype(vm, 2) != OT_INTEGER) {
+                // Throwing null reports a missing member
+                sq_pushnull(vm);
+                sq_throwobject(vm);
+                return nullptr;
+            }
+            sq_getinteger(vm, 2, &index);
+            if (index < 0 || static_cast<size_t>(index) >= header->size) {
+                sq_throwerror(vm, "index out of range");
+                return nullptr;
+            }
+            return header;
+        }
+
+        SQInteger bufferGet(HSQUIRRELVM vm) {
+            SQInteger index;
+            Header* header = checkIndex(vm, index);
+            if (header == nullptr) return SQ_ERROR;
+            pushElement(vm, header, index);
+            return 1;
+        }
+
+        SQInteger bufferSet(HSQUIRRELVM vm) {
+            SQInteger index;
+            Header* header = checkIndex(vm, index);
+            if (header == nullptr) return SQ_ERROR;
+            setElement(vm, header, index, 3);
+            return 0;
+        }
+
+        SQInteger bufferNexti(HSQUIRRELVM vm) {
+            Header* header = getHeader(vm, 1);
+            if (header == nullptr) return sq_throwerror(vm, "not a buffer");
+
+            SQInteger next = 0;
+            if (sq_gettype(vm, 2) == OT_INTEGER) {
+                sq_getinteger(vm, 2, &next);
+                next++;
+            }
+            if (static_cast<size_t>(next) >= header->size) {
+                sq_pushnull(vm);
+            } else {
+                sq_pushinteger(vm, next);
+            }
+            return 1;
+        }
+
+        SQInteger bufferLen(HSQUIRRELVM vm) {
+            Header* header = getHeader(vm, 1);
+            if (header == nullptr) return sq_throwerror(vm, "not a buffer");
+            sq_pushinteger(vm, static_cast<SQInteger>(header->size));
+            return 1;
+        }
+
+        SQInteger bufferTypeof(HSQUIRRELVM vm) {
+            sq_pushstring(vm, "buffer", -1);
+            return 1;
+        }
+
+        void addMethod(HSQUIRRELVM vm, const char* name, SQFUNCTION func, SQInteger nparams, const char* mask) {
+            sq_pushstring(vm, name, -1);
+            sq_newclosure(vm, func, 0);
+            sq_setparamscheck(vm, nparams, nparams, mask);
+            sq_setnativeclosurename(vm, -1, name);
+            sq_newslot(vm, -3, SQFalse);
+        }
+
+        // The delegate is created once per VM and kept in the registry table
+        void pushDelegate(HSQUIRRELVM vm) {
+            sq_pushregistrytable(vm);
+            sq_pushuserpointer(vm, const_cast<char*>(&bufferTag));
+            if (SQ_SUCCEEDED(sq_rawget(vm, -2))) {
+                sq_remove(vm, -2);
+                return;
+            }
+
+            sq_pushuserpointer(vm, const_cast<char*>(&bufferTag));
+            sq_newtable(vm);
+            addMethod(vm, "_get", &bufferGet, 2, "u.");
+            addMethod(vm, "_set", &bufferSet, 3, "u.n");
+            addMethod(vm, "_nexti", &bufferNexti, 2, "u.");
+            addMethod(vm, "_typeof", &bufferTypeof, 1, "u");
+            addMethod(vm, "len", &bufferLen, 1, "u");
+            // Stays alive, referenced by the registry table
+            HSQOBJECT delegate;
+            sq_getstackobj(vm, -1, &delegate);
+            sq_newslot(vm, -3, SQFalse);
+            sq_pop(vm, 1);
+            sq_pushobject(vm, delegate);
+        }
+    }
+
+    namespace detail {
+        void pushBuffer(HSQUIRRELVM vm, BufferType type, size_t elementSize, size_t size, void* data) {
+            const size_t storage = data ? 0 : elementSize * size;
+            Header* header = static_cast<Header*>(sq_newuserdata(vm, HEADER_SIZE + storage));
+            header->data = data ? data : reinterpret_cast<char*>(header) + HEADER_SIZE;
+            header->size = size;
+            header->type = type;
+            if (storage) std::memset(header->data, 0, storage);
+
+            sq_settypetag(vm, -1, const_cast<char*>(&bufferTag));
+            pushDelegate(vm);
+            sq_setdelegate(vm, -2);
+        }
+
+        bool getBuffer(HSQUIRRELVM vm, SQInteger index, BufferInfo& info) {
+            if (const Header* header = getHeader(vm, index)) {
+                info.data = header->data;
+                info.size = header->size;
+                info.type = header->type;
+                return true;
+            }
+
+            SQUserPointer ptr;
+            if (sq_gettype(vm, index) == OT_INSTANCE && SQ_SUCCEEDED(sqstd_getblob(vm, index, &ptr))) {
+                info.data = ptr;
+                info.size = static_cast<size_t>(sqstd_getblobsize(vm, index));
+                info.type = BufferType::BYTES;
+                return true;
+            }
+            return false;
+        }
+    }
+}
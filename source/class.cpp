@@ -41,8 +41,13 @@ namespace ssq {
     }
 
     Function Class::findFunc(const char* name) const {
-        Object object = Object::find(name);
-        return Function(object);
+        return tryFindFunc(name).unwrap(vm);
+    }
+
+    Result<Function> Class::tryFindFunc(const char* name) const {
+        Result<Object> found = tryFind(name);
+        if (!found) return found.getError();
+        return found.value().tryTo<Function>();
     }
 
     Class& Class::operator = (const Class& other) {
@@ -60,6 +65,35 @@ namespace ssq {
         return *this;
     }
 
+    void Class::addFuncs(const FuncDef* defs, size_t count) {
+        if (vm == nullptr) throw RuntimeException(nullptr, "VM is not initialised");
+
+        for (size_t i = 0; i < count; i++) {
+            if (defs[i].flags & FuncDef::GETTER) findTable("_get", tableGet, dlgGetStub);
+            if (defs[i].flags & FuncDef::SETTER) findTable("_set", tableSet, dlgSetStub);
+        }
+
+        StackGuard guard(vm);
+        sq_pushobject(vm, obj);
+        const SQInteger clsIdx = sq_gettop(vm);
+        sq_pushobject(vm, tableGet.getRaw());
+        const SQInteger getIdx = sq_gettop(vm);
+        sq_pushobject(vm, tableSet.getRaw());
+        const SQInteger setIdx = sq_gettop(vm);
+
+        for (size_t i = 0; i < count; i++) {
+            const FuncDef& def = defs[i];
+            SQInteger idx = clsIdx;
+            if (def.flags & FuncDef::GETTER) idx = getIdx;
+            else if (def.flags & FuncDef::SETTER) idx = setIdx;
+
+            detail::pushFuncDef(vm, def);
+            if (SQ_FAILED(sq_newslot(vm, idx, (def.flags & FuncDef::STATIC) ? SQTrue : SQFalse))) {
+                throw RuntimeException(vm, "Failed to bind function '" + std::string(def.name) + "' to class!");
+            }
+        }
+    }
+
     void Class::findTable(const char* name, Object& table, SQFUNCTION dlg) const {
         // Check if the table has been referenced
         if(!table.isEmpty()) {
@@ -67,6 +101,7 @@ namespace ssq {
         }
             
         // Find the table
+        StackGuard guard(vm);
         sq_pushobject(vm, obj);
         sq_pushstring(vm, name, strlen(name));
 
@@ -83,7 +118,6 @@ namespace ssq {
             // Set the root table as a delegate
             sq_pushroottable(vm);
             if (SQ_FAILED(sq_setdelegate(vm, -2))) {
-                sq_pop(vm, 1); // Pop table
                 throw ssq::RuntimeException(vm, "Cannot set root table as class table delegate!");
             }
 
@@ -97,15 +131,11 @@ namespace ssq {
             if(SQ_FAILED(sq_newslot(vm, -3, false))) {
                 throw RuntimeException(vm, "Failed to create table '" + std::string(name) + "'!");
             }
-
-            sq_pop(vm, 1); // Pop class obj
-
         } else {
             // Return one
             table = Object(vm);
             sq_getstackobj(vm, -1, &table.getRaw());
             sq_addref(vm, &table.getRaw());
-            sq_pop(vm, 2);
         }
     }
 
@@ -0,0 +1,180 @@
+#include <squirrel.h>
+#include <cassert>
+#include <exception>
+
+#include "simplesquirrel/coroutine.hpp"
+
+namespace ssq {
+    Coroutine::Coroutine():
+        thread(),
+        func(nullptr),
+        value(),
+        error(),
+        state(State::IDLE),
+        base(0),
+        continuation(nullptr),
+        continuationData(nullptr) {
+
+    }
+
+    Coroutine::Coroutine(VM& vm, const Function& func, size_t stackSize):
+        thread(stackSize ? VM::getMain(vm.getHandle()).newThread(stackSize) : VM::getMain(vm.getHandle()).newThread()),
+        func(func),
+        value(),
+        error(),
+        state(State::IDLE),
+        base(0),
+        continuation(nullptr),
+        continuationData(nullptr) {
+
+    }
+
+    Coroutine::~Coroutine() {
+        thread.destroy();
+    }
+
+    Coroutine::Coroutine(Coroutine&& other) NOEXCEPT : Coroutine() {
+        swap(other);
+    }
+
+    void Coroutine::swap(Coroutine& other) NOEXCEPT {
+        using std::swap;
+        thread.swap(other.thread);
+        func.swap(other.func);
+        value.swap(other.value);
+        swap(error, other.error);
+        swap(state, other.state);
+        swap(base, other.base);
+        swap(continuation, other.continuation);
+        swap(continuationData, other.continuationData);
+    }
+
+    Object Coroutine::resume() {
+        return resume(nullptr);
+    }
+
+    void Coroutine::reset(const Function& func) {
+        if (state == State::SUSPENDED)
+            throw RuntimeException(thread.getHandle(), "Cannot reset a suspended coroutine!");
+
+        this->func = func;
+        value = Object();
+        error = nullptr;
+        state = State::IDLE;
+        continuation = nullptr;
+        continuationData = nullptr;
+    }
+
+    const Object& Coroutine::getValue() const {
+        return value;
+    }
+
+    Coroutine::State Coroutine::getState() const {
+        return state;
+    }
+
+    bool Coroutine::isSuspended() const {
+        return state == State::SUSPENDED;
+    }
+
+    bool Coroutine::isFinished() const {
+        return state == State::FINISHED;
+    }
+
+    VM& Coroutine::getThread() {
+        return thread;
+    }
+
+    const Function& Coroutine::getFunc() const {
+        return func;
+    }
+
+    Coroutine& Coroutine::operator = (Coroutine&& other) NOEXCEPT {
+        if (this != &other) {
+            swap(other);
+        }
+        return *this;
+    }
+
+    void Coroutine::prepare(SQInteger nparams) {
+        HSQUIRRELVM v = thread.getHandle();
+        if (v == nullptr) throw RuntimeException(nullptr, "Coroutine has no thread!");
+        if (state == State::SUSPENDED) throw RuntimeException(v, "Coroutine is already running!");
+        if (func.isEmpty()) throw RuntimeException(v, "Coroutine has no function!");
+        if (thread.isInterrupted()) throw TimeoutException(v, "Coroutine has been interrupted!");
+
+        const auto funcParams = func.getNumOfParams();
+        if (nparams < funcParams.first || nparams > funcParams.second) {
+            throw RuntimeException(nullptr, "Number of arguments does not match");
+        }
+
+        error = nullptr;
+        base = sq_gettop(v);
+        sq_pushobject(v, func.getRaw());
+        sq_pushroottable(v);
+    }
+
+    void Coroutine::checkSuspended() const {
+        if (state != State::SUSPENDED)
+            throw RuntimeException(thread.getHandle(), "Coroutine is not suspended!");
+        if (thread.isInterrupted())
+            throw TimeoutException(thread.getHandle(), "Coroutine has been interrupted!");
+    }
+
+    Object Coroutine::call(SQInteger nparams) {
+        HSQUIRRELVM v = thread.getHandle();
+        if (SQ_FAILED(sq_call(v, 1 + nparams, SQTrue, SQTrue)) || thread.isInterrupted()) {
+            fail();
+        }
+        return result();
+    }
+
+    Object Coroutine::wakeup() {
+        HSQUIRRELVM v = thread.getHandle();
+        if (SQ_FAILED(sq_wakeupvm(v, SQTrue, SQTrue, SQTrue, SQFalse)) || thread.isInterrupted()) {
+            fail();
+        }
+        return result();
+    }
+
+    Object Coroutine::result() {
+        HSQUIRRELVM v = thread.getHandle();
+        value = detail::pop<Object>(v, -1);
+        sq_pop(v, 1);
+
+        if (sq_getvmstate(v) == SQ_VMSTATE_SUSPENDED) {
+            state = State::SUSPENDED;
+            return value;
+        }
+
+        // The function has returned, drop its frame
+        state = State::FINISHED;
+        sq_settop(v, base);
+        // The continuation may destroy or move this coroutine
+        Object ret = value;
+        notify();
+        return ret;
+    }
+
+    void Coroutine::fail() {
+        HSQUIRRELVM v = thread.getHandle();
+        // Created before the stack is dropped to capture the last error
+        std::exception_ptr err = thread.isInterrupted() ?
+            std::make_exception_ptr(TimeoutException(v, "Coroutine has been interrupted!")) :
+            std::make_exception_ptr(RuntimeException(v, "Error running coroutine!"));
+        state = State::FINISHED;
+        value = Object();
+        error = err;
+        sq_settop(v, base);
+        notify();
+        std::rethrow_exception(err);
+    }
+
+    void Coroutine::notify() {
+        if (continuation) {
+            auto func = continuation;
+            continuation = nullptr;
+            func(continuationData);
+        }
+    }
+}
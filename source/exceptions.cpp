@@ -1,24 +1,67 @@
 #include "simplesquirrel/exceptions.hpp"
 
+#include <vector>
+
 namespace ssq {
-    void Exception::generate_message(const std::string& msg) {
-        std::ostringstream out;
-        out << "Squirrel exception: " << msg << " (";
+    void Exception::captureLastError() {
+        if (!vm) return;
+        // Copied right away, a native may run more script before the message is
+        // formatted, and the exception may outlive the VM. Only strings have a text,
+        // so there is nothing to copy for the null error of a fresh native call.
+        sq_getlasterror(vm);
+        const SQChar* lasterr;
+        if (sq_gettype(vm, -1) == OT_STRING && SQ_SUCCEEDED(sq_getstring(vm, -1, &lasterr))) {
+            lastError = lasterr;
+            hasLastError = true;
+        }
+        sq_pop(vm, 1);
+    }
 
-        const char* lasterr;
-        if (vm) {
-            sq_getlasterror(vm);
-            if (sq_gettype(vm, -1) != OT_STRING)
-              lasterr = "no detailed info";
-            else
-              sq_getstring(vm, -1, &lasterr);
-            sq_pop(vm, 1);
+    const char* Exception::what() const throw() {
+        if (message.empty()) {
+            try {
+                const size_t length = format(nullptr, 0);
+                std::vector<char> buffer(length + 1);
+                format(buffer.data(), buffer.size());
+                message.assign(buffer.data(), length);
+            } catch (...) {
+                return "Squirrel exception";
+            }
         }
-        else {
-            lasterr = "no detailed info";
+        return message.c_str();
+    }
+
+    size_t Exception::format(char* buffer, size_t size) const {
+        size_t pos = append(buffer, size, 0, "Squirrel exception: ");
+        pos = formatBody(buffer, size, pos);
+        pos = append(buffer, size, pos, " (");
+        pos = append(buffer, size, pos, hasLastError ? lastError.c_str() : "no detailed info");
+        pos = append(buffer, size, pos, ")");
+        if (size > 0) buffer[pos < size ? pos : size - 1] = '\0';
+        return pos;
+    }
+
+    size_t Exception::formatBody(char* buffer, size_t size, size_t pos) const {
+        return append(buffer, size, pos, msg.c_str());
+    }
+
+    size_t Exception::append(char* buffer, size_t size, size_t pos, const char* str) {
+        for (; *str != '\0'; str++, pos++) {
+            if (pos + 1 < size) buffer[pos] = *str;
         }
-        out << lasterr << ")";
+        return pos;
+    }
 
-        message = out.str();
+    size_t Exception::append(char* buffer, size_t size, size_t pos, long long value) {
+        char digits[24];
+        int i = sizeof(digits) - 1;
+        digits[i] = '\0';
+        unsigned long long abs = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+        do {
+            digits[--i] = static_cast<char>('0' + abs % 10);
+            abs /= 10;
+        } while (abs != 0);
+        if (value < 0) digits[--i] = '-';
+        return append(buffer, size, pos, digits + i);
     }
 }
@@ -0,0 +1,185 @@
+#include <squirrel.h>
+#include <cstring>
+
+#include "simplesquirrel/executor.hpp"
+
+namespace ssq {
+    namespace {
+        // Index of the worker running on the current thread, used to queue nested jobs locally
+        thread_local const void* currentExecutor = nullptr;
+        thread_local size_t currentWorker = 0;
+
+        struct BytecodeReader {
+            const std::string* bytes;
+            size_t offset;
+        };
+
+        SQInteger writeBytecode(SQUserPointer up, SQUserPointer data, SQInteger size) {
+            static_cast<std::string*>(up)->append(static_cast<const char*>(data), static_cast<size_t>(size));
+            return size;
+        }
+
+        SQInteger readBytecode(SQUserPointer up, SQUserPointer data, SQInteger size) {
+            BytecodeReader* reader = static_cast<BytecodeReader*>(up);
+            const size_t left = reader->bytes->size() - reader->offset;
+            const size_t count = std::min(left, static_cast<size_t>(size));
+            std::memcpy(data, reader->bytes->data() + reader->offset, count);
+            reader->offset += count;
+            return static_cast<SQInteger>(count);
+        }
+    }
+
+    VMExecutor::VMExecutor(size_t numOfWorkers, const Setup& setup, size_t stackSize, uint32_t flags):
+        next(0),
+        pending(0),
+        sleeping(0),
+        quit(false) {
+
+        if (numOfWorkers == 0) {
+            numOfWorkers = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        std::vector<std::promise<void>> ready(numOfWorkers);
+        for (size_t i = 0; i < numOfWorkers; i++) {
+            workers.emplace_back(new Worker());
+        }
+        for (size_t i = 0; i < numOfWorkers; i++) {
+            workers[i]->thread = std::thread(&VMExecutor::workerLoop, this, i, std::cref(setup), stackSize, flags, std::ref(ready[i]));
+        }
+
+        // Wait for all VMs to be initialized
+        std::exception_ptr error;
+        for (auto& promise : ready) {
+            try {
+                promise.get_future().get();
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+        }
+
+        if (error) {
+            shutdown();
+            std::rethrow_exception(error);
+        }
+    }
+
+    VMExecutor::~VMExecutor() {
+        shutdown();
+    }
+
+    void VMExecutor::shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        cv.notify_all();
+        for (auto& worker : workers) {
+            if (worker->thread.joinable()) worker->thread.join();
+        }
+        workers.clear();
+    }
+
+    VMExecutor::Setup VMExecutor::runScript(const std::string& source, const std::string& name) {
+        auto bytes = std::make_shared<std::string>();
+        {
+            VM compiler(1024, Libs::NONE);
+            Script script = compiler.compileSource(source.c_str(), name.c_str());
+            HSQUIRRELVM v = compiler.getHandle();
+            sq_pushobject(v, script.getRaw());
+            const SQRESULT result = sq_writeclosure(v, &writeBytecode, bytes.get());
+            sq_pop(v, 1);
+            if (SQ_FAILED(result))
+                throw CompileException(v, "Cannot serialize compiled script!");
+        }
+
+        return [bytes](VM& vm) {
+            HSQUIRRELVM v = vm.getHandle();
+            BytecodeReader reader = { bytes.get(), 0 };
+            if (SQ_FAILED(sq_readclosure(v, &readBytecode, &reader)))
+                throw CompileException(v, "Cannot load compiled script!");
+
+            Script script(v);
+            sq_getstackobj(v, -1, &script.getRaw());
+            sq_addref(v, &script.getRaw());
+            sq_pop(v, 1);
+            vm.run(script);
+        };
+    }
+
+    size_t VMExecutor::getNumOfWorkers() const {
+        return workers.size();
+    }
+
+    void VMExecutor::push(Job job) {
+        // Nested jobs stay on the worker which queued them
+        const size_t index = currentExecutor == this ?
+            currentWorker : next.fetch_add(1, std::memory_order_relaxed) % workers.size();
+
+        Worker& worker = *workers[index];
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.jobs.push_back(std::move(job));
+        }
+        pending.fetch_add(1);
+
+        if (sleeping.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cv.notify_one();
+        }
+    }
+
+    bool VMExecutor::pop(size_t index, Job& job) {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.jobs.empty()) return false;
+        job = std::move(worker.jobs.front());
+        worker.jobs.pop_front();
+        return true;
+    }
+
+    bool VMExecutor::steal(size_t index, Job& job) {
+        // Steal from the back, the owner takes jobs from the front
+        for (size_t i = 1; i < workers.size(); i++) {
+            Worker& victim = *workers[(index + i) % workers.size()];
+            std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+            if (!lock.owns_lock() || victim.jobs.empty()) continue;
+            job = std::move(victim.jobs.back());
+            victim.jobs.pop_back();
+            return true;
+        }
+        return false;
+    }
+
+    void VMExecutor::workerLoop(size_t index, const Setup& setup, size_t stackSize, uint32_t flags, std::promise<void>& ready) {
+        currentExecutor = this;
+        currentWorker = index;
+
+        VM vm(stackSize, flags);
+        try {
+            setup(vm);
+            ready.set_value();
+        } catch (...) {
+            ready.set_exception(std::current_exception());
+            return;
+        }
+
+        Job job;
+        while (true) {
+            if (pop(index, job) || steal(index, job)) {
+                pending.fetch_sub(1);
+                job(vm);
+                job = nullptr;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (quit && pending.load() == 0) break;
+
+            sleeping.fetch_add(1);
+            cv.wait(lock, [this]() {
+                return quit || pending.load() > 0;
+            });
+            sleeping.fetch_sub(1);
+        }
+    }
+}
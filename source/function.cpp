@@ -21,16 +21,19 @@ namespace ssq {
     }
 
     std::pair<unsigned int, unsigned int> Function::getNumOfParams() const {
+        return tryGetNumOfParams().unwrap(vm);
+    }
+
+    Result<std::pair<unsigned int, unsigned int>> Function::tryGetNumOfParams() const {
         SQInteger nparamsmin;
         SQInteger nparamsmax;
         SQInteger nfreevars;
+        StackGuard guard(vm);
         sq_pushobject(vm, obj);
         if (SQ_FAILED(sq_getclosureinfo(vm, -1, &nparamsmin, &nparamsmax, &nfreevars))) {
-            sq_pop(vm, 1);
-            throw RuntimeException(vm, "Getting function info failed!");
+            return Error(ErrorCode::RUNTIME_ERROR, "Getting function info failed!");
         }
-        sq_pop(vm, 1);
-        return { nparamsmin - 1, nparamsmax - 1 };
+        return std::make_pair(static_cast<unsigned int>(nparamsmin - 1), static_cast<unsigned int>(nparamsmax - 1));
     }
 
     Function& Function::operator = (const Function& other){
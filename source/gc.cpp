@@ -0,0 +1,81 @@
+#include <squirrel.h>
+#include <chrono>
+
+#include "simplesquirrel/gc.hpp"
+#include "simplesquirrel/vm.hpp"
+
+namespace ssq {
+    GarbageCollector::Pause::Pause(VM& vm):vm(VM::getMain(vm.getHandle())) {
+        this->vm.gcState.paused++;
+    }
+
+    GarbageCollector::Pause::~Pause() {
+        vm.gcState.paused--;
+    }
+
+    GarbageCollector::GarbageCollector(VM& vm):vm(VM::getMain(vm.getHandle())) {
+
+    }
+
+    SQInteger GarbageCollector::collect() {
+        detail::GcState& state = vm.gcState;
+        state.pending = false;
+
+        const auto start = std::chrono::steady_clock::now();
+        SQInteger freed = sq_collectgarbage(vm.getHandle());
+        const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        // Negative if Squirrel was built without the cycle collector
+        if (freed < 0) freed = 0;
+
+        GcStats& stats = state.stats;
+        stats.collections++;
+        stats.freed += freed;
+        stats.lastFreed = freed;
+        stats.lastNs = ns;
+        stats.totalNs += ns;
+        if (ns > stats.maxNs) stats.maxNs = ns;
+        return freed;
+    }
+
+    void GarbageCollector::collectOrSchedule() {
+        if (isPaused() || !getAutoCollect()) {
+            schedule();
+        } else {
+            collect();
+        }
+    }
+
+    void GarbageCollector::schedule() {
+        vm.gcState.pending = true;
+    }
+
+    SQInteger GarbageCollector::update() {
+        if (!isPending() || isPaused()) return 0;
+        return collect();
+    }
+
+    bool GarbageCollector::isPending() const {
+        return vm.gcState.pending;
+    }
+
+    bool GarbageCollector::isPaused() const {
+        return vm.gcState.paused > 0;
+    }
+
+    void GarbageCollector::setAutoCollect(bool enable) {
+        vm.gcState.autoCollect = enable;
+    }
+
+    bool GarbageCollector::getAutoCollect() const {
+        return vm.gcState.autoCollect;
+    }
+
+    const GcStats& GarbageCollector::getStats() const {
+        return vm.gcState.stats;
+    }
+
+    void GarbageCollector::resetStats() {
+        vm.gcState.stats = GcStats();
+    }
+}
@@ -27,13 +27,13 @@ namespace ssq {
 
     Class Instance::getClass() {
         Class cls(vm);
+        StackGuard guard(vm);
         sq_pushobject(vm, obj);
         if(SQ_FAILED(sq_getclass(vm, -1))) {
             throw RuntimeException(vm, "Failed to get class from instance!");
         }
         sq_getstackobj(vm, -1, &cls.getRaw());
         sq_addref(vm, &cls.getRaw());
-        sq_pop(vm, 1);
         return cls;
     }
 
@@ -47,37 +47,57 @@ namespace ssq {
         return *this;
     }
 
-    SqWeakRef::SqWeakRef():Instance() {
-        weak = true;
+    SqWeakRef::SqWeakRef():Object() {
     }
 
-    SqWeakRef::SqWeakRef(HSQUIRRELVM vm):Instance(vm) {
-        weak = true;
+    SqWeakRef::SqWeakRef(HSQUIRRELVM vm):Object(vm) {
     }
 
-    SqWeakRef::SqWeakRef(const SqWeakRef& other):Instance(other) {
+    SqWeakRef::SqWeakRef(const SqWeakRef& other):Object(other) {
     }
 
-    SqWeakRef::SqWeakRef(const Instance& instance): Instance(instance.getHandle()) {
-        weak = true;
-        obj = instance.getRaw();
+    SqWeakRef::SqWeakRef(SqWeakRef&& other) NOEXCEPT :Object(std::forward<SqWeakRef>(other)) {
     }
 
-    SqWeakRef::SqWeakRef(SqWeakRef&& other):Instance() {
-        Instance::swap(other);
+    SqWeakRef::SqWeakRef(const Instance& instance): Object(instance.getHandle()) {
+        if (instance.isEmpty()) return;
+        SSQ_STACK_CHECK(vm);
+        sq_pushobject(vm, instance.getRaw());
+        sq_weakref(vm, -1);
+        sq_getstackobj(vm, -1, &obj);
+        sq_addref(vm, &obj);
+        sq_pop(vm, 2);
     }
 
-    void SqWeakRef::swap(SqWeakRef& other) {
-        Instance::swap(other);
+    Instance SqWeakRef::lock() const {
+        if (vm == nullptr || isEmpty()) return Instance();
+
+        Instance inst(vm);
+        StackGuard guard(vm);
+        sq_pushobject(vm, obj);
+        if (SQ_FAILED(sq_getweakrefval(vm, -1)) || sq_gettype(vm, -1) != OT_INSTANCE) {
+            return Instance();
+        }
+        sq_getstackobj(vm, -1, &inst.getRaw());
+        sq_addref(vm, &inst.getRaw());
+        return inst;
+    }
+
+    bool SqWeakRef::expired() const {
+        return lock().isEmpty();
+    }
+
+    void SqWeakRef::swap(SqWeakRef& other) NOEXCEPT {
+        Object::swap(other);
     }
 
     SqWeakRef& SqWeakRef::operator = (const SqWeakRef& other){
-        Instance::operator= (other);
+        Object::operator = (other);
         return *this;
     }
 
-    SqWeakRef& SqWeakRef::operator = (SqWeakRef&& other){
-        Instance::operator= (std::forward<SqWeakRef>(other));
+    SqWeakRef& SqWeakRef::operator = (SqWeakRef&& other) NOEXCEPT {
+        Object::operator = (std::forward<SqWeakRef>(other));
         return *this;
     }
 }
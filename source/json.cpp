@@ -0,0 +1,521 @@
+#include <squirrel.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <unordered_set>
+#include <vector>
+
+#include "simplesquirrel/json.hpp"
+
+namespace ssq {
+    namespace json {
+        namespace {
+            class Parser {
+            public:
+                Parser(HSQUIRRELVM vm, const char* begin, const char* end):
+                    vm(vm),
+                    begin(begin),
+                    pos(begin),
+                    end(end) {
+
+                }
+
+                // Leaves the parsed value on top of the stack
+                void parse() {
+                    bool complete = value();
+                    while (true) {
+                        if (!complete) {
+                            // Container was just opened
+                            skipWhitespace();
+                            if (pos < end && *pos == closing()) {
+                                pos++;
+                                frames.pop_back();
+                                complete = true;
+                            } else {
+                                complete = item();
+                            }
+                            continue;
+                        }
+
+                        if (frames.empty()) break;
+
+                        const bool isObject = frames.back();
+                        if (isObject) {
+                            if (SQ_FAILED(sq_newslot(vm, -3, SQFalse))) fail("cannot add key");
+                        } else {
+                            sq_arrayappend(vm, -2);
+                        }
+
+                        skipWhitespace();
+                        if (pos < end && *pos == ',') {
+                            pos++;
+                            complete = item();
+                        } else if (pos < end && *pos == closing()) {
+                            pos++;
+                            frames.pop_back();
+                        } else {
+                            fail(isObject ? "expected ',' or '}'" : "expected ',' or ']'");
+                        }
+                    }
+
+                    skipWhitespace();
+                    if (pos != end) fail("unexpected trailing characters");
+                }
+
+            private:
+                char closing() const {
+                    return frames.back() ? '}' : ']';
+                }
+
+                // Parses the next array item, or the key and the value of the next object member
+                bool item() {
+                    if (frames.back()) {
+                        skipWhitespace();
+                        if (pos >= end || *pos != '"') fail("expected string key");
+                        pos++;
+                        string();
+                        skipWhitespace();
+                        if (pos >= end || *pos != ':') fail("expected ':'");
+                        pos++;
+                    }
+                    return value();
+                }
+
+                // Pushes the next value, returns false if it is a container waiting for its items
+                bool value() {
+                    skipWhitespace();
+                    if (pos >= end) fail("unexpected end of text");
+
+                    switch (*pos) {
+                        case '{':
+                            pos++;
+                            sq_reservestack(vm, 4);
+                            sq_newtable(vm);
+                            frames.push_back(true);
+                            return false;
+                        case '[':
+                            pos++;
+                            sq_reservestack(vm, 4);
+                            sq_newarray(vm, 0);
+                            frames.push_back(false);
+                            return false;
+                        case '"':
+                            pos++;
+                            string();
+                            return true;
+                        case 't':
+                            literal("true");
+                            sq_pushbool(vm, SQTrue);
+                            return true;
+                        case 'f':
+                            literal("false");
+                            sq_pushbool(vm, SQFalse);
+                            return true;
+                        case 'n':
+                            literal("null");
+                            sq_pushnull(vm);
+                            return true;
+                        default:
+                            number();
+                            return true;
+                    }
+                }
+
+                void literal(const char* text) {
+                    const size_t length = std::strlen(text);
+                    if (static_cast<size_t>(end - pos) < length || std::memcmp(pos, text, length) != 0)
+                        fail("unexpected character");
+                    pos += length;
+                }
+
+                void number() {
+                    const char* start = pos;
+                    bool negative = false;
+                    if (pos < end && *pos == '-') {
+                        negative = true;
+                        pos++;
+                    }
+                    if (pos >= end || *pos < '0' || *pos > '9') fail("unexpected character");
+
+                    // Integers are accumulated directly, floats and overflows use strtod
+                    uint64_t integer = 0;
+                    bool overflow = false;
+                    while (pos < end && *pos >= '0' && *pos <= '9') {
+                        const uint64_t digit = static_cast<uint64_t>(*pos - '0');
+                        if (integer > (UINT64_MAX - digit) / 10) overflow = true;
+                        integer = integer * 10 + digit;
+                        pos++;
+                    }
+
+                    bool isFloat = false;
+                    if (pos < end && *pos == '.') {
+                        isFloat = true;
+                        pos++;
+                        if (pos >= end || *pos < '0' || *pos > '9') fail("expected digit");
+                        while (pos < end && *pos >= '0' && *pos <= '9') pos++;
+                    }
+                    if (pos < end && (*pos == 'e' || *pos == 'E')) {
+                        isFloat = true;
+                        pos++;
+                        if (pos < end && (*pos == '+' || *pos == '-')) pos++;
+                        if (pos >= end || *pos < '0' || *pos > '9') fail("expected digit");
+                        while (pos < end && *pos >= '0' && *pos <= '9') pos++;
+                    }
+
+                    const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<SQInteger>::max()) + (negative ? 1 : 0);
+                    if (!isFloat && !overflow && integer <= limit) {
+                        sq_pushinteger(vm, negative ? static_cast<SQInteger>(0 - integer) : static_cast<SQInteger>(integer));
+                    } else {
+                        const std::string text(start, pos);
+                        sq_pushfloat(vm, static_cast<SQFloat>(std::strtod(text.c_str(), nullptr)));
+                    }
+                }
+
+                void string() {
+                    // Strings without escapes are pushed straight from the text
+                    const char* start = pos;
+                    while (pos < end && *pos != '"' && *pos != '\\') {
+                        if (static_cast<unsigned char>(*pos) < 0x20) fail("control character in string");
+                        pos++;
+                    }
+                    if (pos >= end) fail("unterminated string");
+                    if (*pos == '"') {
+                        sq_pushstring(vm, start, pos - start);
+                        pos++;
+                        return;
+                    }
+
+                    scratch.assign(start, pos);
+                    while (true) {
+                        if (pos >= end) fail("unterminated string");
+                        const char c = *pos++;
+                        if (c == '"') break;
+                        if (static_cast<unsigned char>(c) < 0x20) fail("control character in string");
+                        if (c != '\\') {
+                            scratch.push_back(c);
+                            continue;
+                        }
+
+                        if (pos >= end) fail("unterminated string");
+                        switch (*pos++) {
+                            case '"': scratch.push_back('"'); break;
+                            case '\\': scratch.push_back('\\'); break;
+                            case '/': scratch.push_back('/'); break;
+                            case 'b': scratch.push_back('\b'); break;
+                            case 'f': scratch.push_back('\f'); break;
+                            case 'n': scratch.push_back('\n'); break;
+                            case 'r': scratch.push_back('\r'); break;
+                            case 't': scratch.push_back('\t'); break;
+                            case 'u': unicode(); break;
+                            default: fail("invalid escape sequence");
+                        }
+                    }
+                    sq_pushstring(vm, scratch.data(), static_cast<SQInteger>(scratch.size()));
+                }
+
+                void unicode() {
+                    uint32_t code = hex();
+                    if (code >= 0xD800 && code <= 0xDBFF) {
+                        // Surrogate pair
+                        if (end - pos < 2 || pos[0] != '\\' || pos[1] != 'u') fail("invalid surrogate pair");
+                        pos += 2;
+                        const uint32_t low = hex();
+                        if (low < 0xDC00 || low > 0xDFFF) fail("invalid surrogate pair");
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+
+                    // Encode as UTF-8
+                    if (code < 0x80) {
+                        scratch.push_back(static_cast<char>(code));
+                    } else if (code < 0x800) {
+                        scratch.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                        scratch.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    } else if (code < 0x10000) {
+                        scratch.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                        scratch.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                        scratch.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    } else {
+                        scratch.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                        scratch.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                        scratch.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                        scratch.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                }
+
+                uint32_t hex() {
+                    if (end - pos < 4) fail("invalid unicode escape");
+                    uint32_t code = 0;
+                    for (int i = 0; i < 4; i++) {
+                        const char c = *pos++;
+                        code <<= 4;
+                        if (c >= '0' && c <= '9') code |= static_cast<uint32_t>(c - '0');
+                        else if (c >= 'a' && c <= 'f') code |= static_cast<uint32_t>(c - 'a' + 10);
+                        else if (c >= 'A' && c <= 'F') code |= static_cast<uint32_t>(c - 'A' + 10);
+                        else fail("invalid unicode escape");
+                    }
+                    return code;
+                }
+
+                void skipWhitespace() {
+                    while (pos < end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) pos++;
+                }
+
+                void fail(const char* message) {
+                    int line = 1;
+                    int column = 1;
+                    for (const char* c = begin; c < pos && c < end; c++) {
+                        if (*c == '\n') {
+                            line++;
+                            column = 1;
+                        } else {
+                            column++;
+                        }
+                    }
+                    throw RuntimeException(vm, "JSON parse error at line " + std::to_string(line) +
+                        ", column " + std::to_string(column) + ": " + message);
+                }
+
+                HSQUIRRELVM vm;
+                const char* begin;
+                const char* pos;
+                const char* end;
+                std::vector<bool> frames; // True for objects, false for arrays
+                std::string scratch;
+            };
+
+            class Writer {
+            public:
+                Writer(HSQUIRRELVM vm, int indent):
+                    vm(vm),
+                    indent(indent) {
+
+                }
+
+                std::string write(const HSQOBJECT& root) {
+                    value(root);
+
+                    // Containers being written keep their iterator on the stack
+                    while (!frames.empty()) {
+                        Frame& frame = frames.back();
+                        if (SQ_SUCCEEDED(sq_next(vm, -2))) {
+                            HSQOBJECT key, item;
+                            sq_getstackobj(vm, -2, &key);
+                            sq_getstackobj(vm, -1, &item);
+                            sq_pop(vm, 2);
+
+                            if (!frame.empty) out.push_back(',');
+                            frame.empty = false;
+                            newline(frames.size());
+
+                            if (frame.isTable) {
+                                if (sq_type(key) != OT_STRING)
+                                    throw TypeException("cannot stringify table key", "string", typeToStr(Type(sq_type(key))));
+                                value(key);
+                                out.push_back(':');
+                                if (indent > 0) out.push_back(' ');
+                            }
+                            value(item);
+                        } else {
+                            sq_pop(vm, 2);
+                            const bool empty = frame.empty;
+                            const bool isTable = frame.isTable;
+                            active.erase(frame.container._unVal.pRefCounted);
+                            frames.pop_back();
+
+                            if (!empty) newline(frames.size());
+                            out.push_back(isTable ? '}' : ']');
+                        }
+                    }
+                    return std::move(out);
+                }
+
+            private:
+                struct Frame {
+                    HSQOBJECT container;
+                    bool isTable;
+                    bool empty;
+                };
+
+                void newline(size_t depth) {
+                    if (indent <= 0) return;
+                    out.push_back('\n');
+                    out.append(depth * static_cast<size_t>(indent), ' ');
+                }
+
+                void value(const HSQOBJECT& value) {
+                    char buffer[32];
+                    switch (sq_type(value)) {
+                        case OT_NULL:
+                            out.append("null");
+                            break;
+                        case OT_BOOL:
+                            out.append(sq_objtobool(&value) ? "true" : "false");
+                            break;
+                        case OT_INTEGER:
+                            std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(sq_objtointeger(&value)));
+                            out.append(buffer);
+                            break;
+                        case OT_FLOAT: {
+                            const double number = sq_objtofloat(&value);
+                            if (!std::isfinite(number)) {
+                                out.append("null");
+                                break;
+                            }
+                            // Shortest precision which reads back as the same value
+                            const int digits = std::numeric_limits<SQFloat>::max_digits10;
+                            for (int precision = digits - 3; precision <= digits; precision++) {
+                                std::snprintf(buffer, sizeof(buffer), "%.*g", precision, number);
+                                if (static_cast<SQFloat>(std::strtod(buffer, nullptr)) == static_cast<SQFloat>(number)) break;
+                            }
+                            out.append(buffer);
+                            // Keep floats distinguishable from integers
+                            if (std::strpbrk(buffer, ".eEn") == nullptr) out.append(".0");
+                            break;
+                        }
+                        case OT_STRING: {
+                            const SQChar* str;
+                            SQInteger size;
+                            sq_pushobject(vm, value);
+                            sq_getstringandsize(vm, -1, &str, &size);
+                            sq_pop(vm, 1);
+                            string(str, static_cast<size_t>(size));
+                            break;
+                        }
+                        case OT_TABLE:
+                        case OT_ARRAY:
+                            if (!active.insert(value._unVal.pRefCounted).second)
+                                throw TypeException("cannot stringify reference cycle", "tree", "cycle");
+                            sq_reservestack(vm, 4);
+                            sq_pushobject(vm, value);
+                            sq_pushnull(vm);
+                            frames.push_back({value, sq_type(value) == OT_TABLE, true});
+                            out.push_back(sq_type(value) == OT_TABLE ? '{' : '[');
+                            break;
+                        default:
+                            throw TypeException("cannot stringify value", "table, array or primitive", typeToStr(Type(sq_type(value))));
+                    }
+                }
+
+                void string(const char* str, size_t size) {
+                    static const char* hexDigits = "0123456789abcdef";
+                    out.push_back('"');
+                    const char* run = str;
+                    for (size_t i = 0; i < size; i++) {
+                        const unsigned char c = static_cast<unsigned char>(str[i]);
+                        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+                        out.append(run, str + i);
+                        run = str + i + 1;
+                        out.push_back('\\');
+                        switch (c) {
+                            case '"': out.push_back('"'); break;
+                            case '\\': out.push_back('\\'); break;
+                            case '\b': out.push_back('b'); break;
+                            case '\f': out.push_back('f'); break;
+                            case '\n': out.push_back('n'); break;
+                            case '\r': out.push_back('r'); break;
+                            case '\t': out.push_back('t'); break;
+                            default:
+                                out.append("u00");
+                                out.push_back(hexDigits[c >> 4]);
+                                out.push_back(hexDigits[c & 0xF]);
+                                break;
+                        }
+                    }
+                    out.append(run, str + size);
+                    out.push_back('"');
+                }
+
+                HSQUIRRELVM vm;
+                int indent;
+                std::string out;
+                std::vector<Frame> frames;
+                std::unordered_set<const void*> active;
+            };
+
+            void parseOnStack(HSQUIRRELVM vm, const char* text, size_t size) {
+                const SQInteger top = sq_gettop(vm);
+                try {
+                    Parser parser(vm, text, text + size);
+                    parser.parse();
+                } catch (...) {
+                    sq_settop(vm, top);
+                    throw;
+                }
+            }
+
+            std::string stringifyRaw(HSQUIRRELVM vm, const HSQOBJECT& object, int indent) {
+                const SQInteger top = sq_gettop(vm);
+                try {
+                    Writer writer(vm, indent);
+                    return writer.write(object);
+                } catch (...) {
+                    sq_settop(vm, top);
+                    throw;
+                }
+            }
+
+            SQInteger scriptParse(HSQUIRRELVM vm) {
+                const SQChar* text;
+                SQInteger size;
+                sq_getstringandsize(vm, 2, &text, &size);
+                try {
+                    parseOnStack(vm, text, static_cast<size_t>(size));
+                } catch (const std::exception& e) {
+                    return sq_throwerror(vm, e.what());
+                }
+                return 1;
+            }
+
+            SQInteger scriptStringify(HSQUIRRELVM vm) {
+                SQInteger indent = 0;
+                if (sq_gettop(vm) > 2) sq_getinteger(vm, 3, &indent);
+
+                HSQOBJECT object;
+                sq_getstackobj(vm, 2, &object);
+                try {
+                    const std::string text = stringifyRaw(vm, object, static_cast<int>(indent));
+                    sq_pushstring(vm, text.data(), static_cast<SQInteger>(text.size()));
+                } catch (const std::exception& e) {
+                    return sq_throwerror(vm, e.what());
+                }
+                return 1;
+            }
+        }
+
+        Object parse(VM& vm, const std::string& text) {
+            HSQUIRRELVM v = vm.getHandle();
+            parseOnStack(v, text.data(), text.size());
+            Object result = detail::pop<Object>(v, -1);
+            sq_pop(v, 1);
+            return result;
+        }
+
+        std::string stringify(const Object& object, int indent) {
+            if (object.getHandle() == nullptr) return "null";
+            return stringifyRaw(object.getHandle(), object.getRaw(), indent);
+        }
+
+        void registerLib(HSQUIRRELVM vm) {
+            sq_pushstring(vm, "json", -1);
+            sq_newtable(vm);
+
+            sq_pushstring(vm, "parse", -1);
+            sq_newclosure(vm, &scriptParse, 0);
+            sq_setparamscheck(vm, 2, 2, ".s");
+            sq_setnativeclosurename(vm, -1, "parse");
+            sq_newslot(vm, -3, SQFalse);
+
+            sq_pushstring(vm, "stringify", -1);
+            sq_newclosure(vm, &scriptStringify, 0);
+            sq_setparamscheck(vm, 2, 3, "..n");
+            sq_setnativeclosurename(vm, -1, "stringify");
+            sq_newslot(vm, -3, SQFalse);
+
+            sq_newslot(vm, -3, SQFalse);
+        }
+    }
+}
@@ -34,44 +34,57 @@ namespace ssq {
         }
     }
 
-    Object::Object() :vm(nullptr), weak(false) {
+    Object::Object() :vm(nullptr) {
         sq_resetobject(&obj);
+#ifdef SSQ_TRACK_REFS
+        detail::RefTracker::track(this);
+#endif
     }
 
-    Object::Object(HSQUIRRELVM vm) : vm(vm), weak(false) {
+    Object::Object(HSQUIRRELVM vm) : vm(vm) {
         if (vm == nullptr) throw RuntimeException(nullptr, "VM is not initialised");
         sq_resetobject(&obj);
+#ifdef SSQ_TRACK_REFS
+        detail::RefTracker::track(this);
+#endif
     }
 
     Object::~Object() {
         reset();
+#ifdef SSQ_TRACK_REFS
+        detail::RefTracker::untrack(this);
+#endif
     }
 
     void Object::reset() {
-        if (vm != nullptr && !sq_isnull(obj) && !weak) {
+        if (vm != nullptr && !sq_isnull(obj)) {
             sq_release(vm, &obj);
         }
         sq_resetobject(&obj);
-        weak = false;
     }
 
     void Object::swap(Object& other) NOEXCEPT {
         using std::swap;
         swap(obj, other.obj);
         swap(vm, other.vm);
-        swap(weak, other.weak);
     }
 
-    Object::Object(const Object& other) :vm(other.vm), obj(other.obj), weak(other.weak) {
-        if (vm != nullptr && !other.isEmpty() && !weak) {
+    Object::Object(const Object& other) :vm(other.vm), obj(other.obj) {
+        if (vm != nullptr && !other.isEmpty()) {
             sq_addref(vm, &obj);
         }
+#ifdef SSQ_TRACK_REFS
+        detail::RefTracker::track(this);
+#endif
     }
 
     Object::Object(Object&& other) NOEXCEPT :vm(nullptr) {
         vm = nullptr;
         sq_resetobject(&obj);
         swap(other);
+#ifdef SSQ_TRACK_REFS
+        detail::RefTracker::track(this);
+#endif
     }
 
     bool Object::isEmpty() const {
@@ -91,21 +104,24 @@ namespace ssq {
     }
 
     Object Object::find(const char* name) const {
-        if (vm == nullptr) throw RuntimeException(nullptr, "VM is not initialised");
+        return tryFind(name).unwrap(vm);
+    }
+
+    Result<Object> Object::tryFind(const char* name) const {
+        if (vm == nullptr) return Error(ErrorCode::RUNTIME_ERROR, "VM is not initialised");
 
         Object ret(vm);
+        StackGuard guard(vm);
 
         sq_pushobject(vm, obj);
         sq_pushstring(vm, name, strlen(name));
 
         if (SQ_FAILED(sq_get(vm, -2))) {
-            sq_pop(vm, 1);
-            throw NotFoundException(vm, name);
+            return Error(ErrorCode::NOT_FOUND, name);
         }
 
         sq_getstackobj(vm, -1, &ret.getRaw());
         sq_addref(vm, &ret.getRaw());
-        sq_pop(vm, 2);
 
         return ret;
     }
@@ -123,6 +139,7 @@ namespace ssq {
     size_t Object::getTypeTag() const {
         if (isEmpty()) return 0;
         SQUserPointer typetag;
+        SSQ_STACK_CHECK(vm);
         sq_pushobject(vm, obj);
         sq_gettypetag(vm, -1, &typetag);
         sq_pop(vm, 1);
@@ -0,0 +1,67 @@
+#include "simplesquirrel/object_ref.hpp"
+#include <squirrel.h>
+#include <cstring>
+
+namespace ssq {
+    ObjectRef::ObjectRef() :vm(nullptr) {
+        sq_resetobject(&obj);
+    }
+
+    ObjectRef::ObjectRef(HSQUIRRELVM vm, const HSQOBJECT& obj) :vm(vm), obj(obj) {
+    }
+
+    ObjectRef::ObjectRef(const Object& object) :vm(object.getHandle()), obj(object.getRaw()) {
+    }
+
+    bool ObjectRef::isEmpty() const {
+        return sq_isnull(obj);
+    }
+
+    bool ObjectRef::isNull() const {
+        return getType() == Type::NULLPTR;
+    }
+
+    const HSQOBJECT& ObjectRef::getRaw() const {
+        return obj;
+    }
+
+    const HSQUIRRELVM& ObjectRef::getHandle() const {
+        return vm;
+    }
+
+    Type ObjectRef::getType() const {
+        if (isEmpty()) return Type::NULLPTR;
+        return Type(obj._type);
+    }
+
+    const char* ObjectRef::getTypeStr() const {
+        return typeToStr(getType());
+    }
+
+    ObjectRef ObjectRef::find(const char* name) const {
+        if (vm == nullptr) throw RuntimeException(nullptr, "VM is not initialised");
+
+        HSQOBJECT ret;
+        StackGuard guard(vm);
+
+        sq_pushobject(vm, obj);
+        sq_pushstring(vm, name, strlen(name));
+
+        // The entry must be owned by the object, see the documentation
+        if (SQ_FAILED(sq_rawget(vm, -2))) {
+            throw NotFoundException(vm, name);
+        }
+
+        sq_getstackobj(vm, -1, &ret);
+        return ObjectRef(vm, ret);
+    }
+
+    Object ObjectRef::toObject() const {
+        if (vm == nullptr) return Object();
+
+        Object ret(vm);
+        ret.getRaw() = obj;
+        sq_addref(vm, &ret.getRaw());
+        return ret;
+    }
+}
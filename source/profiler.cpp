@@ -0,0 +1,150 @@
+#include <squirrel.h>
+#include <chrono>
+#include <vector>
+
+#include "simplesquirrel/profiler.hpp"
+#include "simplesquirrel/vm.hpp"
+
+namespace ssq {
+    const unsigned int Profiler::DEFAULT_RATE;
+
+    Profiler::Profiler(VM& vm, unsigned int rate):
+        // Threads may be destroyed while profiling, only the main VM detaches it
+        vm(VM::getMain(vm.getHandle()).getHandle()),
+        rate(rate ? rate : DEFAULT_RATE),
+        pending(false),
+        running(false),
+        quit(false),
+        samples(0) {
+
+    }
+
+    Profiler::~Profiler() {
+        stop();
+    }
+
+    void Profiler::start() {
+        if (running) return;
+        if (!vm) throw RuntimeException(nullptr, "Cannot profile a destroyed VM!");
+
+        VM& mainVM = VM::getMain(vm);
+        if (mainVM.profiler)
+            throw RuntimeException(vm, "A profiler is already attached to this VM!");
+
+        mainVM.profiler = this;
+        mainVM.updateDebugHook();
+
+        pending = false;
+        quit = false;
+        running = true;
+        sampler = std::thread(&Profiler::samplerLoop, this);
+    }
+
+    void Profiler::stop() {
+        if (!running) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        cv.notify_all();
+        sampler.join();
+        running = false;
+        pending = false;
+
+        if (vm) {
+            VM& mainVM = VM::getMain(vm);
+            mainVM.profiler = nullptr;
+            mainVM.updateDebugHook();
+        }
+    }
+
+    void Profiler::detach() {
+        // Called by the VM when it is being destroyed
+        vm = nullptr;
+        stop();
+    }
+
+    bool Profiler::isRunning() const {
+        return running;
+    }
+
+    void Profiler::setRate(unsigned int rate) {
+        this->rate = rate ? rate : DEFAULT_RATE;
+        cv.notify_all();
+    }
+
+    unsigned int Profiler::getRate() const {
+        return rate;
+    }
+
+    void Profiler::reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        stacks.clear();
+        samples = 0;
+    }
+
+    size_t Profiler::getNumOfSamples() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return samples;
+    }
+
+    std::unordered_map<std::string, size_t> Profiler::getStacks() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stacks;
+    }
+
+    void Profiler::writeCollapsed(std::ostream& out) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& pair : stacks) {
+            out << pair.first << " " << pair.second << "\n";
+        }
+    }
+
+    void Profiler::samplerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!quit) {
+            const auto interval = std::chrono::microseconds(1000000 / rate.load());
+            cv.wait_for(lock, interval);
+            if (!quit) pending.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    static void appendFrame(std::string& out, const SQStackInfos& si) {
+        // Semicolons separate frames in the collapsed format
+        for (const char* c = si.funcname ? si.funcname : "unknown"; *c; c++) {
+            out += *c == ';' ? ':' : *c;
+        }
+        out += " (";
+        for (const char* c = si.source ? si.source : "unknown"; *c; c++) {
+            out += *c == ';' ? ':' : *c;
+        }
+        out += ':';
+        out += std::to_string(si.line);
+        out += ')';
+    }
+
+    void Profiler::sample(HSQUIRRELVM v) {
+        if (!pending.load(std::memory_order_relaxed)) return;
+        pending.store(false, std::memory_order_relaxed);
+
+        SQInteger depth = 0;
+        SQStackInfos si;
+        while (SQ_SUCCEEDED(sq_stackinfos(v, depth, &si))) {
+            depth++;
+        }
+        if (depth == 0) return;
+
+        // Stack infos are reported from the innermost frame, collapsed stacks
+        // start from the outermost one
+        scratch.clear();
+        for (SQInteger level = depth - 1; level >= 0; level--) {
+            sq_stackinfos(v, level, &si);
+            appendFrame(scratch, si);
+            if (level) scratch += ';';
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stacks[scratch]++;
+        samples++;
+    }
+}
@@ -0,0 +1,76 @@
+#include "simplesquirrel/refs.hpp"
+
+#ifdef SSQ_TRACK_REFS
+#include "simplesquirrel/object.hpp"
+#include <squirrel.h>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define SSQ_HAS_BACKTRACE
+#endif
+
+namespace ssq {
+    namespace {
+        struct Registry {
+            std::mutex mutex;
+            std::unordered_map<const Object*, detail::RefSite> sites;
+        };
+
+        Registry& registry() {
+            // Never destroyed, Objects with static storage may outlive it otherwise
+            static Registry* instance = new Registry();
+            return *instance;
+        }
+    }
+
+    namespace detail {
+        void RefTracker::track(const Object* object) {
+            RefSite site;
+#ifdef SSQ_HAS_BACKTRACE
+            site.depth = backtrace(site.frames, RefSite::MAX_FRAMES);
+#else
+            site.depth = 0;
+#endif
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.sites[object] = site;
+        }
+
+        void RefTracker::untrack(const Object* object) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.sites.erase(object);
+        }
+
+        void RefTracker::forEach(const std::function<void(Object&, const RefSite&)>& func) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            for (auto& pair : reg.sites) {
+                func(const_cast<Object&>(*pair.first), pair.second);
+            }
+        }
+
+        void RefTracker::detach(Object& object) {
+            object.vm = nullptr;
+            sq_resetobject(&object.obj);
+        }
+
+        void RefTracker::writeSite(std::ostream& out, const RefSite& site) {
+#ifdef SSQ_HAS_BACKTRACE
+            char** symbols = backtrace_symbols(site.frames, site.depth);
+            // Skip the tracker itself and the constructor of Object
+            for (int i = 2; i < site.depth; i++) {
+                out << "    " << (symbols ? symbols[i] : "?") << "\n";
+            }
+            free(symbols);
+#else
+            (void)site;
+            out << "    (call stack not available on this platform)\n";
+#endif
+        }
+    }
+}
+#endif
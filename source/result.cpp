@@ -0,0 +1,23 @@
+#include "simplesquirrel/result.hpp"
+#include <stdexcept>
+
+namespace ssq {
+    void Error::raise(HSQUIRRELVM vm) const {
+        switch (code) {
+        case ErrorCode::NOT_FOUND:
+            throw NotFoundException(vm, message);
+        case ErrorCode::TYPE_MISMATCH:
+            throw TypeException(message, expected, got);
+        case ErrorCode::ARGUMENT_MISMATCH:
+            throw RuntimeException(nullptr, message);
+        case ErrorCode::COMPILE_ERROR:
+            throw CompileException(vm, message);
+        case ErrorCode::RUNTIME_ERROR:
+            throw RuntimeException(vm, message);
+        case ErrorCode::TIMEOUT:
+            throw TimeoutException(vm, message);
+        default:
+            throw std::logic_error("Raising an error which is not set");
+        }
+    }
+}
@@ -0,0 +1,279 @@
+#include <squirrel.h>
+#include <algorithm>
+
+#include "simplesquirrel/scheduler.hpp"
+
+namespace ssq {
+    Scheduler::Scheduler(VM& vm, size_t stackSize):
+        vm(vm.getHandle()),
+        stackSize(stackSize),
+        running(false),
+        current(0),
+        alive(0),
+        numOfReady(0) {
+
+    }
+
+    Scheduler::~Scheduler() {
+        // Destroy all threads at once, with a single garbage collection
+        VM& mainVM = VM::getMain(vm);
+        for (Task& task : tasks) {
+            VM& thread = task.coroutine.getThread();
+            if (thread.getHandle()) {
+                mainVM.destroyThread(thread, false);
+            }
+        }
+        tasks.clear();
+        mainVM.gc().collectOrSchedule();
+    }
+
+    size_t Scheduler::signal(const std::string& name) {
+        return wake(name, Object());
+    }
+
+    size_t Scheduler::run() {
+        return runRound(std::chrono::steady_clock::time_point::max());
+    }
+
+    size_t Scheduler::run(std::chrono::microseconds timeSlice) {
+        const auto deadline = std::chrono::steady_clock::now() + timeSlice;
+        size_t resumed = 0;
+        do {
+            resumed += runRound(deadline);
+        } while (numOfReady > 0 && std::chrono::steady_clock::now() < deadline);
+        return resumed;
+    }
+
+    bool Scheduler::cancel(TaskId id) {
+        Task* task = find(id);
+        if (!task) return false;
+        if (id == current)
+            throw RuntimeException(vm, "A task cannot cancel itself!");
+
+        release(id);
+        return true;
+    }
+
+    bool Scheduler::isAlive(TaskId id) const {
+        return find(id) != nullptr;
+    }
+
+    Scheduler::TaskId Scheduler::getCurrentTask() const {
+        return current;
+    }
+
+    VM* Scheduler::getThread(TaskId id) {
+        Task* task = find(id);
+        if (!task) return nullptr;
+        return &task->coroutine.getThread();
+    }
+
+    size_t Scheduler::getNumOfTasks() const {
+        return alive;
+    }
+
+    size_t Scheduler::getNumOfReadyTasks() const {
+        return numOfReady;
+    }
+
+    std::chrono::steady_clock::time_point Scheduler::getNextWakeup() const {
+        if (timers.empty()) return std::chrono::steady_clock::time_point::max();
+        return timers.front().time;
+    }
+
+    void Scheduler::setErrorHandler(const ErrorHandler& handler) {
+        errorHandler = handler;
+    }
+
+    Scheduler::TaskId Scheduler::acquire(int priority, const Function& func) {
+        size_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = tasks.size();
+            tasks.emplace_back();
+        }
+
+        Task& task = tasks[slot];
+        if (task.coroutine.getThread().getHandle()) {
+            // The budget belonged to the previous task
+            task.coroutine.getThread().clearBudget();
+            task.coroutine.reset(func);
+        } else {
+            // A stack size of zero lets the coroutine use VM::newThread(), sized by the
+            // stack peaks observed so far
+            task.coroutine = Coroutine(VM::getMain(vm), func, stackSize);
+        }
+        task.priority = priority;
+        task.generation++;
+        task.alive = true;
+        task.queued = false;
+        alive++;
+
+        return (static_cast<TaskId>(task.generation) << 32) | slot;
+    }
+
+    void Scheduler::release(TaskId id) {
+        Task& task = tasks[slotOf(id)];
+        VM& thread = task.coroutine.getThread();
+        if (thread.getHandle() && (task.coroutine.isSuspended() || thread.getState() == SQ_VMSTATE_SUSPENDED)) {
+            // A suspended thread cannot be reused, this includes a task interrupted
+            // while suspended
+            VM::getMain(vm).destroyThread(thread, false);
+            task.coroutine = Coroutine();
+        }
+        if (task.queued) {
+            // Its entry in the ready queue is skipped by find()
+            task.queued = false;
+            numOfReady--;
+        }
+        task.alive = false;
+        task.pending.reset();
+        freeSlots.push_back(slotOf(id));
+        alive--;
+    }
+
+    void Scheduler::dispatch(TaskId id, const Object& value) {
+        Task& task = tasks[slotOf(id)];
+        if (!task.coroutine.isSuspended()) {
+            release(id);
+            return;
+        }
+
+        switch (value.getType()) {
+            case Type::INTEGER:
+            case Type::FLOAT: {
+                const auto delay = std::chrono::duration<float, std::milli>(value.to<float>());
+                timers.push_back({
+                    std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay),
+                    id
+                });
+                std::push_heap(timers.begin(), timers.end());
+                break;
+            }
+            case Type::STRING:
+                waiting[value.to<std::string>()].push_back(id);
+                break;
+            default:
+                enqueue(id, task);
+                break;
+        }
+    }
+
+    void Scheduler::fail(TaskId id, const Exception& e) {
+        release(id);
+        // Called from a catch block, rethrows the exception without slicing it
+        if (!errorHandler) throw;
+        errorHandler(id, e);
+    }
+
+    size_t Scheduler::wake(const std::string& name, const Object& value) {
+        auto it = waiting.find(name);
+        if (it == waiting.end()) return 0;
+
+        std::vector<TaskId> ids;
+        ids.swap(it->second);
+        waiting.erase(it);
+
+        size_t woken = 0;
+        for (TaskId id : ids) {
+            Task* task = find(id);
+            if (!task) continue;
+            task->pending = value;
+            enqueue(id, *task);
+            woken++;
+        }
+        return woken;
+    }
+
+    void Scheduler::enqueue(TaskId id, Task& task) {
+        ready[task.priority].push_back(id);
+        task.queued = true;
+        numOfReady++;
+    }
+
+    void Scheduler::wakeTimers(std::chrono::steady_clock::time_point now) {
+        while (!timers.empty() && timers.front().time <= now) {
+            std::pop_heap(timers.begin(), timers.end());
+            const TaskId id = timers.back().id;
+            timers.pop_back();
+
+            Task* task = find(id);
+            if (!task) continue;
+            enqueue(id, *task);
+        }
+    }
+
+    size_t Scheduler::runRound(std::chrono::steady_clock::time_point deadline) {
+        if (running)
+            throw RuntimeException(vm, "Scheduler is already running!");
+
+        struct RunningGuard {
+            bool& running;
+            ~RunningGuard() {
+                running = false;
+            }
+        } guard{running};
+        running = true;
+
+        const bool timed = deadline != std::chrono::steady_clock::time_point::max();
+        wakeTimers(std::chrono::steady_clock::now());
+
+        size_t resumed = 0;
+        for (auto& level : ready) {
+            // Tasks which yield during this round are resumed in the next one
+            size_t count = level.second.size();
+            while (count-- > 0 && !level.second.empty()) {
+                const TaskId id = level.second.front();
+                level.second.pop_front();
+
+                Task* task = find(id);
+                if (!task) continue;
+                task->queued = false;
+                numOfReady--;
+                resumeTask(id);
+                resumed++;
+
+                if (timed && std::chrono::steady_clock::now() >= deadline) {
+                    return resumed;
+                }
+            }
+        }
+        return resumed;
+    }
+
+    void Scheduler::resumeTask(TaskId id) {
+        Task& task = tasks[slotOf(id)];
+        Object pending;
+        pending.swap(task.pending);
+
+        current = id;
+        Object value;
+        try {
+            value = task.coroutine.resume(pending);
+        } catch (const Exception& e) {
+            current = 0;
+            fail(id, e);
+            return;
+        } catch (...) {
+            current = 0;
+            release(id);
+            throw;
+        }
+        current = 0;
+        dispatch(id, value);
+    }
+
+    Scheduler::Task* Scheduler::find(TaskId id) {
+        const size_t slot = slotOf(id);
+        if (slot >= tasks.size()) return nullptr;
+        Task& task = tasks[slot];
+        if (!task.alive || task.generation != static_cast<uint32_t>(id >> 32)) return nullptr;
+        return &task;
+    }
+
+    const Scheduler::Task* Scheduler::find(TaskId id) const {
+        return const_cast<Scheduler*>(this)->find(id);
+    }
+}
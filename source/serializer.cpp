@@ -0,0 +1,464 @@
+#include <squirrel.h>
+#include <cstring>
+#include <limits>
+#include <unordered_set>
+#include <vector>
+
+#include "simplesquirrel/serializer.hpp"
+
+namespace ssq {
+    namespace {
+        const char MAGIC[3] = {'S', 'S', 'Q'};
+        const size_t CHUNK_SIZE = 64 * 1024;
+
+        class Output {
+        public:
+            Output(std::string& buffer, std::ostream* stream):
+                buffer(buffer),
+                stream(stream) {
+
+            }
+
+            void put(uint8_t byte) {
+                buffer.push_back(static_cast<char>(byte));
+            }
+
+            void write(const void* data, size_t size) {
+                buffer.append(static_cast<const char*>(data), size);
+            }
+
+            template<typename T>
+            void put(uint8_t tag, T value) {
+                // MessagePack stores numbers in big endian
+                char bytes[sizeof(T)];
+                uint64_t bits = static_cast<uint64_t>(value);
+                for (size_t i = sizeof(T); i-- > 0; bits >>= 8) {
+                    bytes[i] = static_cast<char>(bits & 0xFF);
+                }
+                put(tag);
+                write(bytes, sizeof(T));
+            }
+
+            void flush(bool force = false) {
+                if (stream && (force || buffer.size() >= CHUNK_SIZE)) {
+                    stream->write(buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+            }
+
+        private:
+            std::string& buffer;
+            std::ostream* stream;
+        };
+
+        class Writer {
+        public:
+            Writer(HSQUIRRELVM vm, Output& out):
+                vm(vm),
+                out(out) {
+
+            }
+
+            void write(const HSQOBJECT& root) {
+                writeValue(root);
+
+                // Containers being written keep their iterator on the stack
+                while (!frames.empty()) {
+                    if (SQ_SUCCEEDED(sq_next(vm, -2))) {
+                        HSQOBJECT key, value;
+                        sq_getstackobj(vm, -2, &key);
+                        sq_getstackobj(vm, -1, &value);
+                        sq_pop(vm, 2);
+
+                        if (frames.back().isTable) {
+                            if (isContainer(key))
+                                throw TypeException("cannot serialize table key", "primitive", typeToStr(Type(sq_type(key))));
+                            writeValue(key);
+                        }
+                        writeValue(value);
+                    } else {
+                        sq_pop(vm, 2);
+                        active.erase(frames.back().container._unVal.pRefCounted);
+                        frames.pop_back();
+                    }
+                    out.flush();
+                }
+                out.flush(true);
+            }
+
+        private:
+            struct Frame {
+                HSQOBJECT container;
+                bool isTable;
+            };
+
+            static bool isContainer(const HSQOBJECT& value) {
+                return sq_type(value) == OT_TABLE || sq_type(value) == OT_ARRAY;
+            }
+
+            void writeValue(const HSQOBJECT& value) {
+                switch (sq_type(value)) {
+                    case OT_NULL:
+                        out.put(0xc0);
+                        break;
+                    case OT_BOOL:
+                        out.put(sq_objtobool(&value) ? 0xc3 : 0xc2);
+                        break;
+                    case OT_INTEGER:
+                        writeInteger(sq_objtointeger(&value));
+                        break;
+                    case OT_FLOAT:
+                        writeFloat(sq_objtofloat(&value));
+                        break;
+                    case OT_STRING: {
+                        const SQChar* str;
+                        SQInteger size;
+                        sq_pushobject(vm, value);
+                        sq_getstringandsize(vm, -1, &str, &size);
+                        sq_pop(vm, 1);
+                        writeHeader(static_cast<uint32_t>(size), 0xa0, 32, 0xd9, 0xda, 0xdb);
+                        out.write(str, static_cast<size_t>(size));
+                        break;
+                    }
+                    case OT_TABLE:
+                    case OT_ARRAY:
+                        openContainer(value);
+                        break;
+                    default:
+                        throw TypeException("cannot serialize value", "table, array or primitive", typeToStr(Type(sq_type(value))));
+                }
+            }
+
+            void openContainer(const HSQOBJECT& value) {
+                if (!active.insert(value._unVal.pRefCounted).second)
+                    throw TypeException("cannot serialize reference cycle", "tree", "cycle");
+
+                const bool isTable = sq_type(value) == OT_TABLE;
+                sq_reservestack(vm, 4);
+                sq_pushobject(vm, value);
+                const uint32_t size = static_cast<uint32_t>(sq_getsize(vm, -1));
+                if (isTable) {
+                    writeHeader(size, 0x80, 16, 0, 0xde, 0xdf);
+                } else {
+                    writeHeader(size, 0x90, 16, 0, 0xdc, 0xdd);
+                }
+                sq_pushnull(vm);
+                frames.push_back({value, isTable});
+            }
+
+            void writeHeader(uint32_t size, uint8_t fixTag, uint32_t fixLimit, uint8_t tag8, uint8_t tag16, uint8_t tag32) {
+                if (size < fixLimit) {
+                    out.put(static_cast<uint8_t>(fixTag | size));
+                } else if (tag8 && size <= 0xFF) {
+                    out.put(tag8, static_cast<uint8_t>(size));
+                } else if (size <= 0xFFFF) {
+                    out.put(tag16, static_cast<uint16_t>(size));
+                } else {
+                    out.put(tag32, size);
+                }
+            }
+
+            void writeInteger(int64_t value) {
+                if (value >= 0) {
+                    if (value < 128) out.put(static_cast<uint8_t>(value));
+                    else if (value <= 0xFF) out.put(0xcc, static_cast<uint8_t>(value));
+                    else if (value <= 0xFFFF) out.put(0xcd, static_cast<uint16_t>(value));
+                    else if (value <= 0xFFFFFFFFLL) out.put(0xce, static_cast<uint32_t>(value));
+                    else out.put(0xcf, static_cast<uint64_t>(value));
+                } else {
+                    if (value >= -32) out.put(static_cast<uint8_t>(value));
+                    else if (value >= -128) out.put(0xd0, static_cast<uint8_t>(value));
+                    else if (value >= -32768) out.put(0xd1, static_cast<uint16_t>(value));
+                    else if (value >= std::numeric_limits<int32_t>::min()) out.put(0xd2, static_cast<uint32_t>(value));
+                    else out.put(0xd3, static_cast<uint64_t>(value));
+                }
+            }
+
+            void writeFloat(float value) {
+                uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                out.put(0xca, bits);
+            }
+
+            void writeFloat(double value) {
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                out.put(0xcb, bits);
+            }
+
+            HSQUIRRELVM vm;
+            Output& out;
+            std::vector<Frame> frames;
+            std::unordered_set<const void*> active;
+        };
+
+        class Input {
+        public:
+            Input(HSQUIRRELVM vm, const char* data, size_t size):
+                vm(vm),
+                pos(data),
+                end(data + size),
+                stream(nullptr) {
+
+            }
+
+            Input(HSQUIRRELVM vm, std::istream& stream):
+                vm(vm),
+                pos(nullptr),
+                end(nullptr),
+                stream(&stream) {
+
+            }
+
+            // Returns a pointer to the next n bytes, which stays valid until the next call
+            const char* take(size_t n) {
+                if (static_cast<size_t>(end - pos) < n) refill(n);
+                const char* p = pos;
+                pos += n;
+                return p;
+            }
+
+            uint8_t byte() {
+                return static_cast<uint8_t>(*take(1));
+            }
+
+            template<typename T>
+            T get() {
+                const char* bytes = take(sizeof(T));
+                uint64_t bits = 0;
+                for (size_t i = 0; i < sizeof(T); i++) {
+                    bits = (bits << 8) | static_cast<uint8_t>(bytes[i]);
+                }
+                return static_cast<T>(bits);
+            }
+
+            // Returns bytes read ahead to a seekable stream, so the next object can follow
+            void finish() {
+                if (stream && end > pos) {
+                    stream->clear();
+                    stream->seekg(-static_cast<std::streamoff>(end - pos), std::ios::cur);
+                }
+            }
+
+        private:
+            void refill(size_t n) {
+                if (!stream)
+                    throw RuntimeException(vm, "Cannot deserialize truncated data!");
+
+                size_t size = static_cast<size_t>(end - pos);
+                if (size) std::memmove(buffer.data(), pos, size);
+                if (buffer.size() < CHUNK_SIZE) buffer.resize(CHUNK_SIZE);
+
+                while (true) {
+                    stream->read(buffer.data() + size, static_cast<std::streamsize>(buffer.size() - size));
+                    size += static_cast<size_t>(stream->gcount());
+                    if (size >= n) break;
+                    if (size < buffer.size())
+                        throw RuntimeException(vm, "Cannot deserialize truncated data!");
+                    // The length comes from the data, grow only as far as the stream delivers
+                    buffer.resize(std::min(n, buffer.size() * 2));
+                }
+                pos = buffer.data();
+                end = pos + size;
+            }
+
+            HSQUIRRELVM vm;
+            const char* pos;
+            const char* end;
+            std::istream* stream;
+            std::vector<char> buffer;
+        };
+
+        class Reader {
+        public:
+            Reader(HSQUIRRELVM vm, Input& in):
+                vm(vm),
+                in(in) {
+
+            }
+
+            void read() {
+                const char* header = in.take(4);
+                if (std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0)
+                    throw RuntimeException(vm, "Cannot deserialize data without a header!");
+                if (static_cast<uint8_t>(header[3]) > SERIALIZER_VERSION)
+                    throw RuntimeException(vm, "Cannot deserialize data of a newer format version!");
+
+                while (true) {
+                    if (!readValue()) continue; // Opened a container, read its first item
+                    if (insert()) break;
+                }
+            }
+
+        private:
+            struct Frame {
+                uint32_t remaining;
+                bool isMap;
+                bool hasKey;
+            };
+
+            // Inserts finished values into their containers, returns true once the root is done
+            bool insert() {
+                while (!frames.empty()) {
+                    Frame& frame = frames.back();
+                    if (frame.isMap) {
+                        if (!frame.hasKey) {
+                            frame.hasKey = true;
+                            return false;
+                        }
+                        if (SQ_FAILED(sq_newslot(vm, -3, SQFalse)))
+                            throw RuntimeException(vm, "Cannot deserialize table with an invalid key!");
+                        frame.hasKey = false;
+                    } else {
+                        sq_arrayappend(vm, -2);
+                    }
+
+                    if (--frame.remaining > 0) return false;
+                    frames.pop_back();
+                }
+                return true;
+            }
+
+            // Pushes the next value, returns false if it is a container waiting for its items
+            bool readValue() {
+                const uint8_t tag = in.byte();
+                if (tag <= 0x7f) {
+                    sq_pushinteger(vm, tag);
+                } else if (tag >= 0xe0) {
+                    sq_pushinteger(vm, static_cast<int8_t>(tag));
+                } else if ((tag & 0xe0) == 0xa0) {
+                    readString(tag & 0x1f);
+                } else if ((tag & 0xf0) == 0x90) {
+                    return openArray(tag & 0x0f);
+                } else if ((tag & 0xf0) == 0x80) {
+                    return openMap(tag & 0x0f);
+                } else {
+                    switch (tag) {
+                        case 0xc0: sq_pushnull(vm); break;
+                        case 0xc2: sq_pushbool(vm, SQFalse); break;
+                        case 0xc3: sq_pushbool(vm, SQTrue); break;
+                        case 0xcc: sq_pushinteger(vm, in.get<uint8_t>()); break;
+                        case 0xcd: sq_pushinteger(vm, in.get<uint16_t>()); break;
+                        case 0xce: sq_pushinteger(vm, static_cast<SQInteger>(in.get<uint32_t>())); break;
+                        case 0xcf: sq_pushinteger(vm, static_cast<SQInteger>(in.get<uint64_t>())); break;
+                        case 0xd0: sq_pushinteger(vm, in.get<int8_t>()); break;
+                        case 0xd1: sq_pushinteger(vm, in.get<int16_t>()); break;
+                        case 0xd2: sq_pushinteger(vm, in.get<int32_t>()); break;
+                        case 0xd3: sq_pushinteger(vm, static_cast<SQInteger>(in.get<int64_t>())); break;
+                        case 0xca: {
+                            const uint32_t bits = in.get<uint32_t>();
+                            float value;
+                            std::memcpy(&value, &bits, sizeof(value));
+                            sq_pushfloat(vm, static_cast<SQFloat>(value));
+                            break;
+                        }
+                        case 0xcb: {
+                            const uint64_t bits = in.get<uint64_t>();
+                            double value;
+                            std::memcpy(&value, &bits, sizeof(value));
+                            sq_pushfloat(vm, static_cast<SQFloat>(value));
+                            break;
+                        }
+                        case 0xd9: readString(in.get<uint8_t>()); break;
+                        case 0xda: readString(in.get<uint16_t>()); break;
+                        case 0xdb: readString(in.get<uint32_t>()); break;
+                        case 0xdc: return openArray(in.get<uint16_t>());
+                        case 0xdd: return openArray(in.get<uint32_t>());
+                        case 0xde: return openMap(in.get<uint16_t>());
+                        case 0xdf: return openMap(in.get<uint32_t>());
+                        default:
+                            throw RuntimeException(vm, "Cannot deserialize unsupported type " + std::to_string(tag) + "!");
+                    }
+                }
+                return true;
+            }
+
+            void readString(uint32_t size) {
+                if (size > SERIALIZER_MAX_STRING_SIZE)
+                    throw RuntimeException(vm, "Cannot deserialize string of " + std::to_string(size) + " bytes!");
+                const char* str = in.take(size);
+                sq_pushstring(vm, str, static_cast<SQInteger>(size));
+            }
+
+            bool openArray(uint32_t size) {
+                sq_reservestack(vm, 4);
+                sq_newarray(vm, 0);
+                if (size == 0) return true;
+                frames.push_back({size, false, false});
+                return false;
+            }
+
+            bool openMap(uint32_t size) {
+                sq_reservestack(vm, 4);
+                // The size comes from the data, don't trust it for the allocation
+                sq_newtableex(vm, std::min<uint32_t>(size, 1024));
+                if (size == 0) return true;
+                frames.push_back({size, true, false});
+                return false;
+            }
+
+            HSQUIRRELVM vm;
+            Input& in;
+            std::vector<Frame> frames;
+        };
+
+        void serialize(const Object& object, Output& out) {
+            out.write(MAGIC, sizeof(MAGIC));
+            out.put(SERIALIZER_VERSION);
+
+            HSQUIRRELVM vm = object.getHandle();
+            if (vm == nullptr) {
+                out.put(0xc0);
+                out.flush(true);
+                return;
+            }
+
+            const SQInteger top = sq_gettop(vm);
+            try {
+                Writer writer(vm, out);
+                writer.write(object.getRaw());
+            } catch (...) {
+                sq_settop(vm, top);
+                throw;
+            }
+        }
+
+        Object deserialize(HSQUIRRELVM vm, Input& in) {
+            const SQInteger top = sq_gettop(vm);
+            try {
+                Reader reader(vm, in);
+                reader.read();
+                in.finish();
+                Object result = detail::pop<Object>(vm, -1);
+                sq_settop(vm, top);
+                return result;
+            } catch (...) {
+                sq_settop(vm, top);
+                throw;
+            }
+        }
+    }
+
+    void serialize(const Object& object, std::ostream& out) {
+        std::string buffer;
+        Output output(buffer, &out);
+        serialize(object, output);
+    }
+
+    std::string serialize(const Object& object) {
+        std::string buffer;
+        Output output(buffer, nullptr);
+        serialize(object, output);
+        return buffer;
+    }
+
+    Object deserialize(VM& vm, std::istream& in) {
+        Input input(vm.getHandle(), in);
+        return deserialize(vm.getHandle(), input);
+    }
+
+    Object deserialize(VM& vm, const std::string& bytes) {
+        Input input(vm.getHandle(), bytes.data(), bytes.size());
+        return deserialize(vm.getHandle(), input);
+    }
+}
@@ -6,9 +6,63 @@
 #include <squirrel.h>
 #include <forward_list>
 #include <cassert>
+#include <cstring>
 #include <limits>
 
 namespace ssq {
+    namespace {
+        // Its address is the key of the pending lazy entries in the delegate of a table
+        const char lazyTag = 0;
+
+        typedef std::function<void(Table&)> LazyRegistrar;
+
+        SQInteger lazyRelease(SQUserPointer ptr, SQInteger size) {
+            (void)size;
+            delete *static_cast<LazyRegistrar**>(ptr);
+            return 0;
+        }
+
+        SQInteger lazyGet(HSQUIRRELVM vm) {
+            // 1 is the table, 2 is the key, 3 is the table of pending entries and
+            // 4 is the _get metamethod of the replaced delegate or null
+            sq_push(vm, 2);
+            if (SQ_FAILED(sq_rawget(vm, 3))) {
+                if (sq_gettype(vm, 4) != OT_NULL) {
+                    sq_push(vm, 4);
+                    sq_push(vm, 1);
+                    sq_push(vm, 2);
+                    // Its error, including null for a missing index, is passed on
+                    if (SQ_FAILED(sq_call(vm, 2, SQTrue, SQFalse))) return SQ_ERROR;
+                    return 1;
+                }
+                // A null error tells the VM that the index does not exist
+                sq_pushnull(vm);
+                return sq_throwobject(vm);
+            }
+
+            LazyRegistrar** registrar;
+            sq_getuserdata(vm, -1, reinterpret_cast<SQUserPointer*>(&registrar), nullptr);
+
+            // Remove the entry before creating it, the registrar may look the name up.
+            // The userdata stays alive on the stack until the call returns.
+            sq_push(vm, 2);
+            sq_rawdeleteslot(vm, 3, SQFalse);
+
+            try {
+                Table table = detail::pop<Table>(vm, 1);
+                (**registrar)(table);
+            } catch (const std::exception& e) {
+                return detail::throwError(vm, e);
+            }
+
+            sq_push(vm, 2);
+            if (SQ_FAILED(sq_rawget(vm, 1))) {
+                return sq_throwerror(vm, "Lazy entry has not been created by its registrar!");
+            }
+            return 1;
+        }
+    }
+
     Table::Table():Object() {
             
     }
@@ -33,30 +87,126 @@ namespace ssq {
     }
 
     Function Table::findFunc(const char* name) const {
-        Object object = Object::find(name);
-        return Function(object);
+        return tryGet<Function>(name).unwrap(vm);
     }
 
     Class Table::findClass(const char* name) const {
-        Object object = Object::find(name);
-        return Class(object);
+        return tryGet<Class>(name).unwrap(vm);
     }
 
     Table Table::findTable(const char* name) const {
-        Object object = Object::find(name);
-        return Table(object);
+        return tryGet<Table>(name).unwrap(vm);
+    }
+
+    void Table::addFuncs(const FuncDef* defs, size_t count) {
+        if (vm == nullptr) throw RuntimeException(nullptr, "VM is not initialised");
+
+        StackGuard guard(vm);
+        sq_pushobject(vm, obj);
+        for (size_t i = 0; i < count; i++) {
+            detail::pushFuncDef(vm, defs[i]);
+            if (SQ_FAILED(sq_newslot(vm, -3, SQFalse))) {
+                throw RuntimeException(vm, "Failed to bind function '" + std::string(defs[i].name) + "'!");
+            }
+        }
+    }
+
+    void Table::addLazy(const char* name, const std::function<void(Table&)>& registrar) {
+        if (vm == nullptr) throw RuntimeException(nullptr, "VM is not initialised");
+
+        StackGuard guard(vm);
+        sq_pushobject(vm, obj);
+        const SQInteger tableIdx = sq_gettop(vm);
+
+        // Find the pending entries of a previous call
+        sq_getdelegate(vm, tableIdx);
+        const SQInteger delegateIdx = sq_gettop(vm);
+        bool found = false;
+        if (sq_gettype(vm, delegateIdx) == OT_TABLE) {
+            sq_pushuserpointer(vm, const_cast<char*>(&lazyTag));
+            found = SQ_SUCCEEDED(sq_rawget(vm, delegateIdx));
+        }
+
+        if (!found) {
+            // Create a delegate which resolves the pending entries. Squirrel only looks
+            // metamethods up in the direct delegate, so the slots of a previous delegate
+            // are copied into the new one, and its _get is called for other names.
+            sq_newtable(vm);
+            const SQInteger lazyIdx = sq_gettop(vm);
+            const bool hasDelegate = sq_gettype(vm, delegateIdx) == OT_TABLE;
+
+            sq_pushstring(vm, "_get", -1);
+            if (!hasDelegate || SQ_FAILED(sq_rawget(vm, delegateIdx))) {
+                sq_pushnull(vm);
+            }
+            const SQInteger previousGetIdx = sq_gettop(vm);
+
+            if (hasDelegate) {
+                sq_pushnull(vm);
+                while (SQ_SUCCEEDED(sq_next(vm, delegateIdx))) {
+                    const SQChar* key;
+                    const bool isGet = sq_gettype(vm, -2) == OT_STRING &&
+                        SQ_SUCCEEDED(sq_getstring(vm, -2, &key)) && strcmp(key, "_get") == 0;
+                    if (!isGet) {
+                        sq_push(vm, -2);
+                        sq_push(vm, -2);
+                        sq_newslot(vm, lazyIdx, SQFalse);
+                    }
+                    sq_pop(vm, 2);
+                }
+                sq_pop(vm, 1);
+            }
+
+            sq_newtable(vm);
+            const SQInteger pendingIdx = sq_gettop(vm);
+
+            sq_pushstring(vm, "_get", -1);
+            sq_push(vm, pendingIdx);
+            sq_push(vm, previousGetIdx);
+            sq_newclosure(vm, &lazyGet, 2);
+            sq_setnativeclosurename(vm, -1, "_get");
+            sq_newslot(vm, lazyIdx, SQFalse);
+
+            sq_pushuserpointer(vm, const_cast<char*>(&lazyTag));
+            sq_push(vm, pendingIdx);
+            sq_newslot(vm, lazyIdx, SQFalse);
+
+            // Set last, so that filling the new delegate does not run metamethods
+            if (hasDelegate) {
+                sq_getdelegate(vm, delegateIdx);
+                if (sq_gettype(vm, -1) == OT_TABLE) {
+                    sq_setdelegate(vm, lazyIdx);
+                } else {
+                    sq_pop(vm, 1);
+                }
+            }
+
+            sq_push(vm, lazyIdx);
+            if (SQ_FAILED(sq_setdelegate(vm, tableIdx))) {
+                throw RuntimeException(vm, "Cannot set lazy delegate of table!");
+            }
+        }
+
+        // The pending entries are on the top of the stack
+        sq_pushstring(vm, name, strlen(name));
+        auto data = reinterpret_cast<LazyRegistrar**>(sq_newuserdata(vm, sizeof(LazyRegistrar*)));
+        *data = new LazyRegistrar(registrar);
+        sq_setreleasehook(vm, -1, &lazyRelease);
+        if (SQ_FAILED(sq_newslot(vm, -3, SQFalse))) {
+            throw RuntimeException(vm, "Failed to add lazy entry '" + std::string(name) + "'!");
+        }
     }
 
     Table Table::addTable(const char* name) {
         assert(sizeof(name) < static_cast<size_t>(std::numeric_limits<SQInteger>::max()));
         Table table(vm);
+        StackGuard guard(vm);
         sq_pushobject(vm, obj);
         sq_pushstring(vm, name, strlen(name));
         detail::push<Object>(vm, table);
         if(SQ_FAILED(sq_newslot(vm, -3, SQFalse))) {
             throw RuntimeException(vm, "Failed to add table '" + std::string(name) + "'!");
         }
-        sq_pop(vm,1); // pop table
         return table;
     }
 
@@ -75,6 +225,7 @@ namespace ssq {
 
     bool Table::hasEntry(const char* name) const {
         assert(sizeof(name) < static_cast<size_t>(std::numeric_limits<SQInteger>::max()));
+        SSQ_STACK_CHECK(vm);
         sq_pushobject(vm, obj);
         sq_pushstring(vm, name, static_cast<SQInteger>(strlen(name)));
         if(SQ_FAILED(sq_get(vm, -2))) {
@@ -89,25 +240,22 @@ namespace ssq {
         assert(sizeof(old_name) < static_cast<size_t>(std::numeric_limits<SQInteger>::max()));
         assert(sizeof(new_name) < static_cast<size_t>(std::numeric_limits<SQInteger>::max()));
 
-        const SQInteger old_top = sq_gettop(vm);
+        StackGuard guard(vm);
         sq_pushobject(vm, obj);
 
         sq_pushstring(vm, new_name, -1);
         sq_pushstring(vm, old_name, -1);
         if (SQ_FAILED(sq_deleteslot(vm, -3, SQTrue))) {
-            sq_settop(vm, old_top);
             throw RuntimeException(vm, "Cannot delete table entry for rename!");
         }
         if(SQ_FAILED(sq_newslot(vm, -3, SQFalse))) {
-            sq_settop(vm, old_top);
             throw RuntimeException(vm, "Cannot create renamed table entry!");
         }
-
-        sq_settop(vm, old_top);
     }
 
     void Table::remove(const char* name) {
         assert(sizeof(name) < static_cast<size_t>(std::numeric_limits<SQInteger>::max()));
+        SSQ_STACK_CHECK(vm);
         sq_pushobject(vm, obj);
         sq_pushstring(vm, name, static_cast<SQInteger>(strlen(name)));
         sq_deleteslot(vm, -2, SQFalse);
@@ -115,23 +263,23 @@ namespace ssq {
     }
 
     void Table::clear() {
+        SSQ_STACK_CHECK(vm);
         sq_pushobject(vm, obj);
         sq_clear(vm, -1);
         sq_pop(vm, 1); // pop table
     }
 
     void Table::setDelegate(Table& table) {
-        const SQInteger old_top = sq_gettop(vm);
+        StackGuard guard(vm);
         sq_pushobject(vm, obj);
         sq_pushobject(vm, table.getRaw());
         if (SQ_FAILED(sq_setdelegate(vm, -2))) {
-            sq_settop(vm, old_top);
             throw ssq::RuntimeException(vm, "Cannot set table as table delegate!");
         }
-        sq_settop(vm, old_top);
     }
 
     size_t Table::size() const {
+        SSQ_STACK_CHECK(vm);
         sq_pushobject(vm, obj);
         SQInteger s = sq_getsize(vm, -1);
         sq_pop(vm, 1);
@@ -139,7 +287,7 @@ namespace ssq {
     }
 
     std::vector<std::string> Table::getKeys() const {
-        const SQInteger old_top = sq_gettop(vm);
+        StackGuard guard(vm);
         sq_pushobject(vm, obj);
 
         std::vector<std::string> keys;
@@ -157,12 +305,11 @@ namespace ssq {
             sq_pop(vm, 2); // pop key and value of this iteration
         }
 
-        sq_settop(vm, old_top);
         return keys;
     }
 
     std::map<std::string, ssq::Object> Table::convertRaw() const {
-        const SQInteger old_top = sq_gettop(vm);
+        StackGuard guard(vm);
         sq_pushobject(vm, obj);
 
         std::map<std::string, ssq::Object> map;
@@ -180,7 +327,6 @@ namespace ssq {
             sq_pop(vm, 2); // pop key and value of this iteration
         }
 
-        sq_settop(vm, old_top);
         return map;
     }
 
@@ -0,0 +1,185 @@
+#include <squirrel.h>
+#include <unordered_map>
+#include <vector>
+
+#include "simplesquirrel/transfer.hpp"
+
+namespace ssq {
+    namespace {
+        class Transfer {
+        public:
+            Transfer(HSQUIRRELVM src, HSQUIRRELVM dst):
+                src(src),
+                dst(dst),
+                copies(0) {
+
+                // Every copied table, array and instance is kept in this array of the
+                // destination VM, so they don't need to be referenced one by one
+                sq_newarray(dst, 0);
+                memo = sq_gettop(dst);
+            }
+
+            void copy(const HSQOBJECT& root) {
+                pushCopy(root);
+
+                // Fill the copied containers one by one, without recursion
+                while (!pending.empty()) {
+                    const Pending next = pending.back();
+                    pending.pop_back();
+                    fill(next);
+                }
+            }
+
+        private:
+            struct Pending {
+                HSQOBJECT source; // Kept alive by the container it was found in
+                SQInteger index;
+            };
+
+            void fill(const Pending& next) {
+                sq_pushinteger(dst, next.index);
+                sq_rawget(dst, memo);
+
+                const bool isTable = sq_type(next.source) == OT_TABLE;
+                sq_pushobject(src, next.source);
+                sq_pushnull(src);
+                while (SQ_SUCCEEDED(sq_next(src, -2))) {
+                    HSQOBJECT key, value;
+                    sq_getstackobj(src, -2, &key);
+                    sq_getstackobj(src, -1, &value);
+
+                    if (isTable) {
+                        pushCopy(key);
+                        pushCopy(value);
+                        sq_newslot(dst, -3, SQFalse);
+                    } else {
+                        pushCopy(value);
+                        sq_arrayappend(dst, -2);
+                    }
+                    sq_pop(src, 2);
+                }
+                sq_pop(src, 2);
+                sq_pop(dst, 1);
+            }
+
+            void pushCopy(const HSQOBJECT& value) {
+                switch (sq_type(value)) {
+                    case OT_NULL:
+                        sq_pushnull(dst);
+                        break;
+                    case OT_BOOL:
+                        sq_pushbool(dst, sq_objtobool(&value));
+                        break;
+                    case OT_INTEGER:
+                        sq_pushinteger(dst, sq_objtointeger(&value));
+                        break;
+                    case OT_FLOAT:
+                        sq_pushfloat(dst, sq_objtofloat(&value));
+                        break;
+                    case OT_USERPOINTER:
+                        sq_pushuserpointer(dst, sq_objtouserpointer(&value));
+                        break;
+                    case OT_STRING: {
+                        const SQChar* str;
+                        SQInteger size;
+                        sq_pushobject(src, value);
+                        sq_getstringandsize(src, -1, &str, &size);
+                        sq_pushstring(dst, str, size);
+                        sq_pop(src, 1);
+                        break;
+                    }
+                    case OT_TABLE:
+                    case OT_ARRAY:
+                    case OT_INSTANCE:
+                        pushShared(value);
+                        break;
+                    default:
+                        throw TypeException("cannot transfer value", "table, array, instance or primitive", typeToStr(Type(sq_type(value))));
+                }
+            }
+
+            void pushShared(const HSQOBJECT& value) {
+                auto it = indices.find(value._unVal.pRefCounted);
+                if (it != indices.end()) {
+                    sq_pushinteger(dst, it->second);
+                    sq_rawget(dst, memo);
+                    return;
+                }
+
+                switch (sq_type(value)) {
+                    case OT_TABLE:
+                        sq_pushobject(src, value);
+                        sq_newtableex(dst, sq_getsize(src, -1));
+                        sq_pop(src, 1);
+                        pending.push_back({value, copies});
+                        break;
+                    case OT_ARRAY:
+                        sq_newarray(dst, 0);
+                        pending.push_back({value, copies});
+                        break;
+                    default:
+                        pushInstance(value);
+                        break;
+                }
+
+                indices[value._unVal.pRefCounted] = copies++;
+                sq_push(dst, -1);
+                sq_arrayappend(dst, memo);
+            }
+
+            void pushInstance(const HSQOBJECT& value) {
+                SQUserPointer typeTag = nullptr;
+                sq_getobjtypetag(&value, &typeTag);
+                const size_t hashCode = reinterpret_cast<size_t>(typeTag);
+
+                const detail::ClassCopier* copier = detail::getClassCopier(dst, hashCode);
+                SQUserPointer ptr = nullptr;
+                sq_pushobject(src, value);
+                sq_getinstanceup(src, -1, &ptr, nullptr, SQFalse);
+                sq_pop(src, 1);
+                if (copier == nullptr || ptr == nullptr)
+                    throw TypeException("cannot transfer instance", "copyable bound class", "instance");
+
+                sq_pushobject(dst, detail::getClassObj(dst, hashCode));
+                sq_createinstance(dst, -1);
+                sq_remove(dst, -2);
+                sq_setinstanceup(dst, -1, copier->copy(ptr));
+                sq_setreleasehook(dst, -1, copier->release);
+            }
+
+            HSQUIRRELVM src;
+            HSQUIRRELVM dst;
+            SQInteger memo;
+            SQInteger copies;
+            std::unordered_map<const void*, SQInteger> indices;
+            std::vector<Pending> pending;
+        };
+    }
+
+    Object transfer(const Object& object, VM& dst) {
+        HSQUIRRELVM src = object.getHandle();
+        HSQUIRRELVM dv = dst.getHandle();
+        if (src == nullptr || VM::getMain(src).getHandle() == VM::getMain(dv).getHandle()) {
+            // Threads of the same VM share their objects
+            sq_pushobject(dv, object.getRaw());
+            Object result = detail::pop<Object>(dv, -1);
+            sq_pop(dv, 1);
+            return result;
+        }
+
+        const SQInteger srcTop = sq_gettop(src);
+        const SQInteger dstTop = sq_gettop(dv);
+        try {
+            Transfer transfer(src, dv);
+            transfer.copy(object.getRaw());
+            Object result = detail::pop<Object>(dv, -1);
+            sq_settop(src, srcTop);
+            sq_settop(dv, dstTop);
+            return result;
+        } catch (...) {
+            sq_settop(src, srcTop);
+            sq_settop(dv, dstTop);
+            throw;
+        }
+    }
+}
@@ -0,0 +1,714 @@
+#include <squirrel.h>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "simplesquirrel/vecmath.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SSQ_VECMATH_SSE2 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SSQ_TARGET_AVX2
+#else
+#define SSQ_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace ssq {
+    namespace vecmath {
+        namespace {
+            template<typename T>
+            struct Kernels {
+                InstructionSet isa;
+                T (*sum)(const T*, size_t);
+                T (*dot)(const T*, const T*, size_t);
+                // The minimum and maximum require at least one element
+                T (*min)(const T*, size_t);
+                T (*max)(const T*, size_t);
+                void (*scale)(T*, size_t, T);
+            };
+
+            template<typename T, typename R>
+            R scalarSum(const T* data, size_t size) {
+                R total = 0;
+                for (size_t i = 0; i < size; i++) total += data[i];
+                return total;
+            }
+
+            template<typename T, typename R>
+            R scalarDot(const T* a, const T* b, size_t size) {
+                R total = 0;
+                for (size_t i = 0; i < size; i++) total += static_cast<R>(a[i]) * b[i];
+                return total;
+            }
+
+            template<typename T>
+            T scalarMin(const T* data, size_t size) {
+                T result = data[0];
+                for (size_t i = 1; i < size; i++) if (data[i] < result) result = data[i];
+                return result;
+            }
+
+            template<typename T>
+            T scalarMax(const T* data, size_t size) {
+                T result = data[0];
+                for (size_t i = 1; i < size; i++) if (data[i] > result) result = data[i];
+                return result;
+            }
+
+            template<typename T, typename F>
+            void scalarScale(T* data, size_t size, F factor) {
+                for (size_t i = 0; i < size; i++) data[i] = static_cast<T>(data[i] * factor);
+            }
+
+#ifdef SSQ_VECMATH_SSE2
+            inline float reduceAdd(__m128 v) {
+                __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+                __m128 sums = _mm_add_ps(v, shuffled);
+                shuffled = _mm_movehl_ps(shuffled, sums);
+                return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+            }
+
+            inline double reduceAdd(__m128d v) {
+                return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+            }
+
+            inline float reduceMin(__m128 v) {
+                v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+                return _mm_cvtss_f32(_mm_min_ss(v, _mm_movehl_ps(v, v)));
+            }
+
+            inline float reduceMax(__m128 v) {
+                v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+                return _mm_cvtss_f32(_mm_max_ss(v, _mm_movehl_ps(v, v)));
+            }
+
+            inline double reduceMin(__m128d v) {
+                return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v)));
+            }
+
+            inline double reduceMax(__m128d v) {
+                return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v)));
+            }
+
+            float sse2Sum(const float* data, size_t size) {
+                __m128 a = _mm_setzero_ps();
+                __m128 b = _mm_setzero_ps();
+                size_t i = 0;
+                for (; i + 8 <= size; i += 8) {
+                    a = _mm_add_ps(a, _mm_loadu_ps(data + i));
+                    b = _mm_add_ps(b, _mm_loadu_ps(data + i + 4));
+                }
+                float total = reduceAdd(_mm_add_ps(a, b));
+                for (; i < size; i++) total += data[i];
+                return total;
+            }
+
+            double sse2Sum(const double* data, size_t size) {
+                __m128d a = _mm_setzero_pd();
+                __m128d b = _mm_setzero_pd();
+                size_t i = 0;
+                for (; i + 4 <= size; i += 4) {
+                    a = _mm_add_pd(a, _mm_loadu_pd(data + i));
+                    b = _mm_add_pd(b, _mm_loadu_pd(data + i + 2));
+                }
+                double total = reduceAdd(_mm_add_pd(a, b));
+                for (; i < size; i++) total += data[i];
+                return total;
+            }
+
+            float sse2Dot(const float* x, const float* y, size_t size) {
+                __m128 a = _mm_setzero_ps();
+                __m128 b = _mm_setzero_ps();
+                size_t i = 0;
+                for (; i + 8 <= size; i += 8) {
+                    a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+                    b = _mm_add_ps(b, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(y + i + 4)));
+                }
+                float total = reduceAdd(_mm_add_ps(a, b));
+                for (; i < size; i++) total += x[i] * y[i];
+                return total;
+            }
+
+            double sse2Dot(const double* x, const double* y, size_t size) {
+                __m128d a = _mm_setzero_pd();
+                __m128d b = _mm_setzero_pd();
+                size_t i = 0;
+                for (; i + 4 <= size; i += 4) {
+                    a = _mm_add_pd(a, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+                    b = _mm_add_pd(b, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+                }
+                double total = reduceAdd(_mm_add_pd(a, b));
+                for (; i < size; i++) total += x[i] * y[i];
+                return total;
+            }
+
+            float sse2Min(const float* data, size_t size) {
+                if (size < 4) return scalarMin(data, size);
+                __m128 m = _mm_loadu_ps(data);
+                size_t i = 4;
+                for (; i + 4 <= size; i += 4) m = _mm_min_ps(m, _mm_loadu_ps(data + i));
+                float result = reduceMin(m);
+                for (; i < size; i++) if (data[i] < result) result = data[i];
+                return result;
+            }
+
+            double sse2Min(const double* data, size_t size) {
+                if (size < 2) return scalarMin(data, size);
+                __m128d m = _mm_loadu_pd(data);
+                size_t i = 2;
+                for (; i + 2 <= size; i += 2) m = _mm_min_pd(m, _mm_loadu_pd(data + i));
+                double result = reduceMin(m);
+                for (; i < size; i++) if (data[i] < result) result = data[i];
+                return result;
+            }
+
+            float sse2Max(const float* data, size_t size) {
+                if (size < 4) return scalarMax(data, size);
+                __m128 m = _mm_loadu_ps(data);
+                size_t i = 4;
+                for (; i + 4 <= size; i += 4) m = _mm_max_ps(m, _mm_loadu_ps(data + i));
+                float result = reduceMax(m);
+                for (; i < size; i++) if (data[i] > result) result = data[i];
+                return result;
+            }
+
+            double sse2Max(const double* data, size_t size) {
+                if (size < 2) return scalarMax(data, size);
+                __m128d m = _mm_loadu_pd(data);
+                size_t i = 2;
+                for (; i + 2 <= size; i += 2) m = _mm_max_pd(m, _mm_loadu_pd(data + i));
+                double result = reduceMax(m);
+                for (; i < size; i++) if (data[i] > result) result = data[i];
+                return result;
+            }
+
+            void sse2Scale(float* data, size_t size, float factor) {
+                const __m128 f = _mm_set1_ps(factor);
+                size_t i = 0;
+                for (; i + 4 <= size; i += 4) _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), f));
+                for (; i < size; i++) data[i] *= factor;
+            }
+
+            void sse2Scale(double* data, size_t size, double factor) {
+                const __m128d f = _mm_set1_pd(factor);
+                size_t i = 0;
+                for (; i + 2 <= size; i += 2) _mm_storeu_pd(data + i, _mm_mul_pd(_mm_loadu_pd(data + i), f));
+                for (; i < size; i++) data[i] *= factor;
+            }
+
+            SSQ_TARGET_AVX2 float avx2Sum(const float* data, size_t size) {
+                __m256 a = _mm256_setzero_ps();
+                __m256 b = _mm256_setzero_ps();
+                size_t i = 0;
+                for (; i + 16 <= size; i += 16) {
+                    a = _mm256_add_ps(a, _mm256_loadu_ps(data + i));
+                    b = _mm256_add_ps(b, _mm256_loadu_ps(data + i + 8));
+                }
+                a = _mm256_add_ps(a, b);
+                float total = reduceAdd(_mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+                for (; i < size; i++) total += data[i];
+                return total;
+            }
+
+            SSQ_TARGET_AVX2 double avx2Sum(const double* data, size_t size) {
+                __m256d a = _mm256_setzero_pd();
+                __m256d b = _mm256_setzero_pd();
+                size_t i = 0;
+                for (; i + 8 <= size; i += 8) {
+                    a = _mm256_add_pd(a, _mm256_loadu_pd(data + i));
+                    b = _mm256_add_pd(b, _mm256_loadu_pd(data + i + 4));
+                }
+                a = _mm256_add_pd(a, b);
+                double total = reduceAdd(_mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1)));
+                for (; i < size; i++) total += data[i];
+                return total;
+            }
+
+            SSQ_TARGET_AVX2 float avx2Dot(const float* x, const float* y, size_t size) {
+                __m256 a = _mm256_setzero_ps();
+                __m256 b = _mm256_setzero_ps();
+                size_t i = 0;
+                for (; i + 16 <= size; i += 16) {
+                    a = _mm256_add_ps(a, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+                    b = _mm256_add_ps(b, _mm256_mul_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8)));
+                }
+                a = _mm256_add_ps(a, b);
+                float total = reduceAdd(_mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+                for (; i < size; i++) total += x[i] * y[i];
+                return total;
+            }
+
+            SSQ_TARGET_AVX2 double avx2Dot(const double* x, const double* y, size_t size) {
+                __m256d a = _mm256_setzero_pd();
+                __m256d b = _mm256_setzero_pd();
+                size_t i = 0;
+                for (; i + 8 <= size; i += 8) {
+                    a = _mm256_add_pd(a, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+                    b = _mm256_add_pd(b, _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+                }
+                a = _mm256_add_pd(a, b);
+                double total = reduceAdd(_mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1)));
+                for (; i < size; i++) total += x[i] * y[i];
+                return total;
+            }
+
+            SSQ_TARGET_AVX2 float avx2Min(const float* data, size_t size) {
+                if (size < 8) return sse2Min(data, size);
+                __m256 m = _mm256_loadu_ps(data);
+                size_t i = 8;
+                for (; i + 8 <= size; i += 8) m = _mm256_min_ps(m, _mm256_loadu_ps(data + i));
+                float result = reduceMin(_mm_min_ps(_mm256_castps256_ps128(m), _mm256_extractf128_ps(m, 1)));
+                for (; i < size; i++) if (data[i] < result) result = data[i];
+                return result;
+            }
+
+            SSQ_TARGET_AVX2 double avx2Min(const double* data, size_t size) {
+                if (size < 4) return sse2Min(data, size);
+                __m256d m = _mm256_loadu_pd(data);
+                size_t i = 4;
+                for (; i + 4 <= size; i += 4) m = _mm256_min_pd(m, _mm256_loadu_pd(data + i));
+                double result = reduceMin(_mm_min_pd(_mm256_castpd256_pd128(m), _mm256_extractf128_pd(m, 1)));
+                for (; i < size; i++) if (data[i] < result) result = data[i];
+                return result;
+            }
+
+            SSQ_TARGET_AVX2 float avx2Max(const float* data, size_t size) {
+                if (size < 8) return sse2Max(data, size);
+                __m256 m = _mm256_loadu_ps(data);
+                size_t i = 8;
+                for (; i + 8 <= size; i += 8) m = _mm256_max_ps(m, _mm256_loadu_ps(data + i));
+                float result = reduceMax(_mm_max_ps(_mm256_castps256_ps128(m), _mm256_extractf128_ps(m, 1)));
+                for (; i < size; i++) if (data[i] > result) result = data[i];
+                return result;
+            }
+
+            SSQ_TARGET_AVX2 double avx2Max(const double* data, size_t size) {
+                if (size < 4) return sse2Max(data, size);
+                __m256d m = _mm256_loadu_pd(data);
+                size_t i = 4;
+                for (; i + 4 <= size; i += 4) m = _mm256_max_pd(m, _mm256_loadu_pd(data + i));
+                double result = reduceMax(_mm_max_pd(_mm256_castpd256_pd128(m), _mm256_extractf128_pd(m, 1)));
+                for (; i < size; i++) if (data[i] > result) result = data[i];
+                return result;
+            }
+
+            SSQ_TARGET_AVX2 void avx2Scale(float* data, size_t size, float factor) {
+                const __m256 f = _mm256_set1_ps(factor);
+                size_t i = 0;
+                for (; i + 8 <= size; i += 8) _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), f));
+                for (; i < size; i++) data[i] *= factor;
+            }
+
+            SSQ_TARGET_AVX2 void avx2Scale(double* data, size_t size, double factor) {
+                const __m256d f = _mm256_set1_pd(factor);
+                size_t i = 0;
+                for (; i + 4 <= size; i += 4) _mm256_storeu_pd(data + i, _mm256_mul_pd(_mm256_loadu_pd(data + i), f));
+                for (; i < size; i++) data[i] *= factor;
+            }
+
+            bool hasAvx2() {
+#ifdef _MSC_VER
+                int info[4];
+                __cpuid(info, 0);
+                if (info[0] < 7) return false;
+                __cpuid(info, 1);
+                // The OS must save the AVX registers
+                const int osxsave = 1 << 27;
+                const int avx = 1 << 28;
+                if ((info[2] & (osxsave | avx)) != (osxsave | avx) || (_xgetbv(0) & 0x6) != 0x6) return false;
+                __cpuidex(info, 7, 0);
+                return (info[1] & (1 << 5)) != 0;
+#else
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2") != 0;
+#endif
+            }
+#endif
+
+            template<typename T>
+            Kernels<T> selectKernels() {
+#ifdef SSQ_VECMATH_SSE2
+                if (hasAvx2())
+                    return Kernels<T>{InstructionSet::AVX2, &avx2Sum, &avx2Dot, &avx2Min, &avx2Max, &avx2Scale};
+                return Kernels<T>{InstructionSet::SSE2, &sse2Sum, &sse2Dot, &sse2Min, &sse2Max, &sse2Scale};
+#else
+                return Kernels<T>{InstructionSet::SCALAR, &scalarSum<T, T>, &scalarDot<T, T>,
+                    &scalarMin<T>, &scalarMax<T>, &scalarScale<T, T>};
+#endif
+            }
+
+            // Selected once, on first use
+            template<typename T>
+            const Kernels<T>& kernels() {
+                static const Kernels<T> selected = selectKernels<T>();
+                return selected;
+            }
+
+            // Integers are accumulated in 64 bits
+            template<typename T>
+            struct Accumulator {
+                typedef typename std::conditional<std::is_floating_point<T>::value, T, int64_t>::type type;
+            };
+
+            template<typename T>
+            typename Accumulator<T>::type sumOf(const T* data, size_t size) {
+                return scalarSum<T, typename Accumulator<T>::type>(data, size);
+            }
+            float sumOf(const float* data, size_t size) {
+                return kernels<float>().sum(data, size);
+            }
+            double sumOf(const double* data, size_t size) {
+                return kernels<double>().sum(data, size);
+            }
+
+            template<typename T>
+            typename Accumulator<T>::type dotOf(const T* a, const T* b, size_t size) {
+                return scalarDot<T, typename Accumulator<T>::type>(a, b, size);
+            }
+            float dotOf(const float* a, const float* b, size_t size) {
+                return kernels<float>().dot(a, b, size);
+            }
+            double dotOf(const double* a, const double* b, size_t size) {
+                return kernels<double>().dot(a, b, size);
+            }
+
+            template<typename T>
+            T minOf(const T* data, size_t size) {
+                return scalarMin(data, size);
+            }
+            float minOf(const float* data, size_t size) {
+                return kernels<float>().min(data, size);
+            }
+            double minOf(const double* data, size_t size) {
+                return kernels<double>().min(data, size);
+            }
+
+            template<typename T>
+            T maxOf(const T* data, size_t size) {
+                return scalarMax(data, size);
+            }
+            float maxOf(const float* data, size_t size) {
+                return kernels<float>().max(data, size);
+            }
+            double maxOf(const double* data, size_t size) {
+                return kernels<double>().max(data, size);
+            }
+
+            template<typename T>
+            void scaleOf(T* data, size_t size, double factor) {
+                scalarScale(data, size, factor);
+            }
+            void scaleOf(float* data, size_t size, double factor) {
+                kernels<float>().scale(data, size, static_cast<float>(factor));
+            }
+            void scaleOf(double* data, size_t size, double factor) {
+                kernels<double>().scale(data, size, factor);
+            }
+
+            template<typename T>
+            typename std::enable_if<std::is_floating_point<T>::value>::type pushNumber(HSQUIRRELVM vm, T value) {
+                sq_pushfloat(vm, static_cast<SQFloat>(value));
+            }
+
+            template<typename T>
+            typename std::enable_if<!std::is_floating_point<T>::value>::type pushNumber(HSQUIRRELVM vm, T value) {
+                sq_pushinteger(vm, static_cast<SQInteger>(value));
+            }
+
+            template<typename Op>
+            void visit(const detail::BufferInfo& info, Op& op) {
+                switch (info.type) {
+                    case detail::BufferType::INT8: op(static_cast<int8_t*>(info.data)); break;
+                    case detail::BufferType::UINT8: op(static_cast<uint8_t*>(info.data)); break;
+                    case detail::BufferType::INT16: op(static_cast<int16_t*>(info.data)); break;
+                    case detail::BufferType::UINT16: op(static_cast<uint16_t*>(info.data)); break;
+                    case detail::BufferType::INT32: op(static_cast<int32_t*>(info.data)); break;
+                    case detail::BufferType::UINT32: op(static_cast<uint32_t*>(info.data)); break;
+                    case detail::BufferType::INT64: op(static_cast<int64_t*>(info.data)); break;
+                    case detail::BufferType::FLOAT: op(static_cast<float*>(info.data)); break;
+                    case detail::BufferType::DOUBLE: op(static_cast<double*>(info.data)); break;
+                    default: break;
+                }
+            }
+
+            // Numbers of a buffer, or of an array copied into a temporary buffer
+            struct Input {
+                detail::BufferInfo info;
+                std::vector<double> floats;
+                std::vector<int64_t> integers;
+                bool isArray;
+            };
+
+            SQRESULT loadArray(HSQUIRRELVM vm, SQInteger index, Input& input) {
+                const SQInteger size = sq_getsize(vm, index);
+                input.floats.reserve(static_cast<size_t>(size));
+                input.integers.reserve(static_cast<size_t>(size));
+                bool integral = true;
+
+                sq_push(vm, index);
+                sq_pushnull(vm);
+                while (SQ_SUCCEEDED(sq_next(vm, -2))) {
+                    const SQObjectType type = sq_gettype(vm, -1);
+                    if (type == OT_INTEGER) {
+                        SQInteger value;
+                        sq_getinteger(vm, -1, &value);
+                        input.integers.push_back(value);
+                        input.floats.push_back(static_cast<double>(value));
+                    } else if (type == OT_FLOAT) {
+                        SQFloat value;
+                        sq_getfloat(vm, -1, &value);
+                        input.floats.push_back(value);
+                        integral = false;
+                    } else {
+                        sq_pop(vm, 4);
+                        return sq_throwerror(vm, "array contains a value which is not a number");
+                    }
+                    sq_pop(vm, 2);
+                }
+                sq_pop(vm, 2);
+
+                input.isArray = true;
+                input.info.size = input.floats.size();
+                if (integral) {
+                    input.info.data = input.integers.data();
+                    input.info.type = detail::BufferType::INT64;
+                } else {
+                    input.info.data = input.floats.data();
+                    input.info.type = detail::BufferType::DOUBLE;
+                }
+                return SQ_OK;
+            }
+
+            SQRESULT getInput(HSQUIRRELVM vm, SQInteger index, Input& input) {
+                if (sq_gettype(vm, index) == OT_ARRAY)
+                    return loadArray(vm, index, input);
+
+                input.isArray = false;
+                if (!detail::getBuffer(vm, index, input.info))
+                    return sq_throwerror(vm, "expected a buffer or an array");
+                if (input.info.type == detail::BufferType::BYTES)
+                    return sq_throwerror(vm, "blobs are not typed, use a buffer");
+                return SQ_OK;
+            }
+
+            struct ToDouble {
+                template<typename T>
+                void operator () (const T* data) {
+                    output.assign(data, data + size);
+                }
+                size_t size;
+                std::vector<double>& output;
+            };
+
+            // Converts the input to doubles, used when combining different types
+            void convertToDouble(Input& input) {
+                if (input.info.type == detail::BufferType::DOUBLE) return;
+                if (!input.isArray) {
+                    ToDouble op{input.info.size, input.floats};
+                    visit(input.info, op);
+                }
+                input.info.data = input.floats.data();
+                input.info.type = detail::BufferType::DOUBLE;
+            }
+
+            struct Sum {
+                template<typename T>
+                void operator () (const T* data) {
+                    pushNumber(vm, sumOf(data, size));
+                }
+                HSQUIRRELVM vm;
+                size_t size;
+            };
+
+            struct Dot {
+                template<typename T>
+                void operator () (const T* a) {
+                    pushNumber(vm, dotOf(a, static_cast<const T*>(b), size));
+                }
+                HSQUIRRELVM vm;
+                size_t size;
+                const void* b;
+            };
+
+            struct MinMax {
+                template<typename T>
+                void operator () (const T* data) {
+                    pushNumber(vm, max ? maxOf(data, size) : minOf(data, size));
+                }
+                HSQUIRRELVM vm;
+                size_t size;
+                bool max;
+            };
+
+            struct Scale {
+                template<typename T>
+                void operator () (T* data) {
+                    scaleOf(data, size, factor);
+                }
+                size_t size;
+                double factor;
+            };
+
+            SQInteger scriptSum(HSQUIRRELVM vm) {
+                Input input;
+                if (SQ_FAILED(getInput(vm, 2, input))) return SQ_ERROR;
+                Sum op{vm, input.info.size};
+                visit(input.info, op);
+                return 1;
+            }
+
+            SQInteger minMax(HSQUIRRELVM vm, bool max) {
+                Input input;
+                if (SQ_FAILED(getInput(vm, 2, input))) return SQ_ERROR;
+                if (input.info.size == 0) {
+                    sq_pushnull(vm);
+                    return 1;
+                }
+                MinMax op{vm, input.info.size, max};
+                visit(input.info, op);
+                return 1;
+            }
+
+            SQInteger scriptMin(HSQUIRRELVM vm) {
+                return minMax(vm, false);
+            }
+
+            SQInteger scriptMax(HSQUIRRELVM vm) {
+                return minMax(vm, true);
+            }
+
+            SQInteger scriptDot(HSQUIRRELVM vm) {
+                Input a;
+                Input b;
+                if (SQ_FAILED(getInput(vm, 2, a)) || SQ_FAILED(getInput(vm, 3, b))) return SQ_ERROR;
+                if (a.info.size != b.info.size) return sq_throwerror(vm, "sizes of the arguments differ");
+                if (a.info.type != b.info.type) {
+                    convertToDouble(a);
+                    convertToDouble(b);
+                }
+                Dot op{vm, a.info.size, b.info.data};
+                visit(a.info, op);
+                return 1;
+            }
+
+            SQInteger scriptScale(HSQUIRRELVM vm) {
+                Input input;
+                if (SQ_FAILED(getInput(vm, 2, input))) return SQ_ERROR;
+
+                SQFloat factor;
+                sq_getfloat(vm, 3, &factor);
+                const bool integerFactor = sq_gettype(vm, 3) == OT_INTEGER;
+
+                if (!input.isArray) {
+                    Scale op{input.info.size, factor};
+                    visit(input.info, op);
+                } else if (input.info.type == detail::BufferType::INT64 && integerFactor) {
+                    // Same result as multiplying the integers in a script
+                    SQInteger integer;
+                    sq_getinteger(vm, 3, &integer);
+                    for (size_t i = 0; i < input.integers.size(); i++) {
+                        sq_pushinteger(vm, static_cast<SQInteger>(i));
+                        sq_pushinteger(vm, static_cast<SQInteger>(input.integers[i] * integer));
+                        sq_set(vm, 2);
+                    }
+                } else {
+                    scaleOf(input.floats.data(), input.floats.size(), factor);
+                    for (size_t i = 0; i < input.floats.size(); i++) {
+                        sq_pushinteger(vm, static_cast<SQInteger>(i));
+                        sq_pushfloat(vm, static_cast<SQFloat>(input.floats[i]));
+                        sq_set(vm, 2);
+                    }
+                }
+                sq_push(vm, 2);
+                return 1;
+            }
+
+            struct TypeName {
+                const char* name;
+                detail::BufferType type;
+                size_t size;
+            };
+
+            const TypeName typeNames[] = {
+                {"int8", detail::BufferType::INT8, sizeof(int8_t)},
+                {"uint8", detail::BufferType::UINT8, sizeof(uint8_t)},
+                {"int16", detail::BufferType::INT16, sizeof(int16_t)},
+                {"uint16", detail::BufferType::UINT16, sizeof(uint16_t)},
+                {"int32", detail::BufferType::INT32, sizeof(int32_t)},
+                {"uint32", detail::BufferType::UINT32, sizeof(uint32_t)},
+                {"int64", detail::BufferType::INT64, sizeof(int64_t)},
+                {"float", detail::BufferType::FLOAT, sizeof(float)},
+                {"double", detail::BufferType::DOUBLE, sizeof(double)}
+            };
+
+            SQInteger scriptBuffer(HSQUIRRELVM vm) {
+                SQInteger size;
+                sq_getinteger(vm, 2, &size);
+                if (size < 0) return sq_throwerror(vm, "size must not be negative");
+
+                const SQChar* name = "float";
+                if (sq_gettop(vm) >= 3) sq_getstring(vm, 3, &name);
+                for (const TypeName& typeName : typeNames) {
+                    if (std::strcmp(typeName.name, name) == 0) {
+                        detail::pushBuffer(vm, typeName.type, typeName.size, static_cast<size_t>(size), nullptr);
+                        return 1;
+                    }
+                }
+                return sq_throwerror(vm, "unknown element type");
+            }
+
+            void addFunction(HSQUIRRELVM vm, const char* name, SQFUNCTION func, SQInteger minParams, SQInteger maxParams, const char* mask) {
+                sq_pushstring(vm, name, -1);
+                sq_newclosure(vm, func, 0);
+                sq_setparamscheck(vm, minParams, maxParams, mask);
+                sq_setnativeclosurename(vm, -1, name);
+                sq_newslot(vm, -3, SQFalse);
+            }
+        }
+
+        InstructionSet getInstructionSet() {
+            return kernels<float>().isa;
+        }
+
+        float sum(const float* data, size_t size) {
+            return sumOf(data, size);
+        }
+
+        double sum(const double* data, size_t size) {
+            return sumOf(data, size);
+        }
+
+        float dot(const float* a, const float* b, size_t size) {
+            return dotOf(a, b, size);
+        }
+
+        double dot(const double* a, const double* b, size_t size) {
+            return dotOf(a, b, size);
+        }
+
+        void scale(float* data, size_t size, float factor) {
+            kernels<float>().scale(data, size, factor);
+        }
+
+        void scale(double* data, size_t size, double factor) {
+            kernels<double>().scale(data, size, factor);
+        }
+
+        void registerLib(HSQUIRRELVM vm) {
+            sq_pushstring(vm, "vecmath", -1);
+            sq_newtable(vm);
+
+            addFunction(vm, "sum", &scriptSum, 2, 2, ".a|u|x");
+            addFunction(vm, "min", &scriptMin, 2, 2, ".a|u|x");
+            addFunction(vm, "max", &scriptMax, 2, 2, ".a|u|x");
+            addFunction(vm, "dot", &scriptDot, 3, 3, ".a|u|xa|u|x");
+            addFunction(vm, "scale", &scriptScale, 3, 3, ".a|u|xn");
+            addFunction(vm, "buffer", &scriptBuffer, 2, 3, ".is");
+
+            sq_newslot(vm, -3, SQFalse);
+        }
+    }
+}
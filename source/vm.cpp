@@ -15,6 +15,9 @@
 #include "simplesquirrel/object.hpp"
 #include "simplesquirrel/enum.hpp"
 #include "simplesquirrel/vm.hpp"
+#include "simplesquirrel/profiler.hpp"
+#include "simplesquirrel/json.hpp"
+#include "simplesquirrel/vecmath.hpp"
 
 static SQInteger squirrel_istream_read_char(SQUserPointer stream)
 {
@@ -40,11 +43,15 @@ namespace ssq {
         return *static_cast<VM*>(ptr);
     }
 
-    VM::VM():Table(), foreignPtr(nullptr) {
+    VM::VM():Table(), foreignPtr(nullptr), profiler(nullptr),
+        hasInstructionBudget(false), instructionBudget(0), hasDeadline(false), deadlineCounter(0),
+        interruptReason(nullptr), stackTracking(false), threadStackPeak(0), stackSlots(0) {
 
     }
 
-    VM::VM(size_t stackSize, uint32_t flags):Table(), foreignPtr(nullptr) {
+    VM::VM(size_t stackSize, uint32_t flags):Table(), foreignPtr(nullptr), profiler(nullptr),
+        hasInstructionBudget(false), instructionBudget(0), hasDeadline(false), deadlineCounter(0),
+        interruptReason(nullptr), stackTracking(false), threadStackPeak(0), stackSlots(0) {
         vm = sq_open(stackSize);
         sq_setforeignptr(vm, this);
         sq_setsharedforeignptr(vm, this);
@@ -63,7 +70,9 @@ namespace ssq {
         sq_pop(vm, 1);
     }
 
-    VM::VM(const HSQOBJECT& threadObj):Table(), foreignPtr(nullptr) {
+    VM::VM(const HSQOBJECT& threadObj):Table(), foreignPtr(nullptr), profiler(nullptr),
+        hasInstructionBudget(false), instructionBudget(0), hasDeadline(false), deadlineCounter(0),
+        interruptReason(nullptr), stackTracking(false), threadStackPeak(0), stackSlots(0) {
         assert(threadObj._type == OT_THREAD);
 
         vm = threadObj._unVal.pThread;
@@ -77,15 +86,30 @@ namespace ssq {
     }
 
     void VM::destroy() {
-        classMap.clear();
         if (vm != nullptr) {
             sq_resetobject(&obj);
 
             VM& mainVM = VM::getMain(vm);
             if (&mainVM == this) { // This is the main VM
+#ifdef SSQ_TRACK_REFS
+                // Handles which outlive the VM would release into the closed VM
+                if (countLiveRefs() > 0) {
+                    std::cerr << "simplesquirrel: C++ handles outlive the VM" << std::endl;
+                    writeLiveRefs(std::cerr);
+                }
+                detachLiveRefs();
+#endif
+                classMap.clear();
+                classCopiers.clear();
+
+                if (profiler) {
+                    profiler->detach();
+                    profiler = nullptr;
+                }
+
                 // Destroy all threads
-                for (HSQOBJECT& threadObj : threads) {
-                    sq_resetobject(&threadObj);
+                for (auto& pair : threads) {
+                    sq_resetobject(&pair.second);
                 }
                 threads.clear();
 
@@ -121,10 +145,29 @@ namespace ssq {
         //swap(runtimeException, other.runtimeException);
         //swap(compileException, other.compileException);
         swap(classMap, other.classMap);
+        swap(classCopiers, other.classCopiers);
+        swap(threads, other.threads);
         swap(foreignPtr, other.foreignPtr);
+        swap(profiler, other.profiler);
+        swap(nativeStats, other.nativeStats);
+        swap(nativeStatsClassNames, other.nativeStatsClassNames);
+        swap(hasInstructionBudget, other.hasInstructionBudget);
+        swap(instructionBudget, other.instructionBudget);
+        swap(hasDeadline, other.hasDeadline);
+        swap(deadlineCounter, other.deadlineCounter);
+        swap(deadline, other.deadline);
+        swap(interruptReason, other.interruptReason);
+        swap(stackTracking, other.stackTracking);
+        swap(threadStackPeak, other.threadStackPeak);
+        swap(stackFrames, other.stackFrames);
+        swap(stackSlots, other.stackSlots);
+        swap(stackStats, other.stackStats);
+        swap(gcState, other.gcState);
     }
         
-    VM::VM(VM&& other) NOEXCEPT :Table(), foreignPtr(nullptr) {
+    VM::VM(VM&& other) NOEXCEPT :Table(), foreignPtr(nullptr), profiler(nullptr),
+        hasInstructionBudget(false), instructionBudget(0), hasDeadline(false), deadlineCounter(0),
+        interruptReason(nullptr), stackTracking(false), threadStackPeak(0), stackSlots(0) {
         swap(other);
     }
 
@@ -141,6 +184,10 @@ namespace ssq {
             sqstd_register_systemlib(vm);
         if(flags & ssq::Libs::STRING)
             sqstd_register_stringlib(vm);
+        if(flags & ssq::Libs::JSON)
+            json::registerLib(vm);
+        if(flags & ssq::Libs::VECMATH)
+            vecmath::registerLib(vm);
         sq_pop(vm, 1);
     }
 
@@ -189,12 +236,58 @@ namespace ssq {
         return sq_gettop(vm);
     }
 
+    void VM::enableDebugInfo(bool enable) {
+        sq_enabledebuginfo(vm, enable ? SQTrue : SQFalse);
+    }
+
+    void VM::setInstructionBudget(uint64_t instructions) {
+        hasInstructionBudget = true;
+        instructionBudget = instructions;
+        interruptReason = nullptr;
+        VM::getMain(vm).updateDebugHook();
+    }
+
+    void VM::setDeadline(std::chrono::steady_clock::time_point deadline) {
+        hasDeadline = true;
+        deadlineCounter = 0;
+        this->deadline = deadline;
+        interruptReason = nullptr;
+        VM::getMain(vm).updateDebugHook();
+    }
+
+    void VM::setTimeLimit(std::chrono::milliseconds limit) {
+        setDeadline(std::chrono::steady_clock::now() + limit);
+    }
+
+    void VM::clearBudget() {
+        if (!hasBudget() && !isInterrupted()) return;
+        hasInstructionBudget = false;
+        instructionBudget = 0;
+        hasDeadline = false;
+        interruptReason = nullptr;
+        VM::getMain(vm).updateDebugHook();
+    }
+
+    bool VM::hasBudget() const {
+        return hasInstructionBudget || hasDeadline;
+    }
+
+    bool VM::isInterrupted() const {
+        return interruptReason != nullptr;
+    }
+
+    uint64_t VM::getRemainingInstructions() const {
+        return instructionBudget;
+    }
+
     Script VM::compileSource(const char* source, const char* name) {
+        return tryCompileSource(source, name).unwrap(vm);
+    }
+
+    Result<Script> VM::tryCompileSource(const char* source, const char* name) {
         Script script(vm);
         if (SQ_FAILED(sq_compilebuffer(vm, source, strlen(source), name, true))) {
-            //if (!compileException)
-                throw CompileException(vm, "Source cannot be compiled!");
-            //throw *compileException;
+            return Error(ErrorCode::COMPILE_ERROR, "Source cannot be compiled!");
         }
 
         sq_getstackobj(vm,-1,&script.getRaw());
@@ -204,11 +297,13 @@ namespace ssq {
     }
 
     Script VM::compileSource(std::istream& source, const char* name) {
+        return tryCompileSource(source, name).unwrap(vm);
+    }
+
+    Result<Script> VM::tryCompileSource(std::istream& source, const char* name) {
         Script script(vm);
         if (SQ_FAILED(sq_compile(vm, squirrel_istream_read_char, &source, name, SQTrue))) {
-            //if (!compileException)
-                throw CompileException(vm, "Source cannot be compiled!");
-            //throw *compileException;
+            return Error(ErrorCode::COMPILE_ERROR, "Source cannot be compiled!");
         }
 
         sq_getstackobj(vm,-1,&script.getRaw());
@@ -218,11 +313,13 @@ namespace ssq {
     }
 
     Script VM::compileFile(const char* path) {
+        return tryCompileFile(path).unwrap(vm);
+    }
+
+    Result<Script> VM::tryCompileFile(const char* path) {
         Script script(vm);
         if (SQ_FAILED(sqstd_loadfile(vm, path, true))) {
-            //if (!compileException)
-                throw CompileException(vm, "File not found or cannot be read!");
-            //throw *compileException;
+            return Error(ErrorCode::COMPILE_ERROR, "File not found or cannot be read!");
         }
 
         sq_getstackobj(vm, -1, &script.getRaw());
@@ -232,86 +329,89 @@ namespace ssq {
     }
 
     void VM::run(const Script& script, bool printCallstack) {
+        tryRun(script, printCallstack).unwrap(vm);
+    }
+
+    Result<void> VM::tryRun(const Script& script, bool printCallstack) {
         if (script.isEmpty()) {
-            throw RuntimeException(vm, "Empty script object.");
+            return Error(ErrorCode::RUNTIME_ERROR, "Empty script object.");
         }
 
+        Result<void> interrupt = checkInterrupt();
+        if (!interrupt) return interrupt;
+
         const SQInteger old_top = sq_gettop(vm);
         sq_pushobject(vm, script.getRaw());
         sq_pushroottable(vm);
-        try {
-            if (SQ_FAILED(sq_call(vm, 1, SQFalse, SQTrue))) {
-                //if (!runtimeException)
-                    throw RuntimeException(vm, "Error running script!");
-                //throw *runtimeException;
-            }
-
-            // Root table may've changed
-            sq_resetobject(&obj);
-            sq_pushroottable(vm);
-            sq_getstackobj(vm, -1, &obj);
-            sq_addref(vm, &obj);
-            sq_pop(vm, 1);
-
-            if (sq_getvmstate(vm) != SQ_VMSTATE_SUSPENDED) {
-                sq_settop(vm, old_top);
-            }
-        }
-        catch (const RuntimeException&) {
+        if (SQ_FAILED(sq_call(vm, 1, SQFalse, SQTrue))) {
             if (printCallstack) {
                 sqstd_printcallstack(vm);
             }
             sq_settop(vm, old_top);
-            throw;
+            interrupt = checkInterrupt();
+            if (!interrupt) return interrupt;
+            return Error(ErrorCode::RUNTIME_ERROR, "Error running script!");
         }
-        catch (const std::exception& err) {
+
+        // Root table may've changed
+        sq_resetobject(&obj);
+        sq_pushroottable(vm);
+        sq_getstackobj(vm, -1, &obj);
+        sq_addref(vm, &obj);
+        sq_pop(vm, 1);
+
+        if (sq_getvmstate(vm) != SQ_VMSTATE_SUSPENDED) {
             sq_settop(vm, old_top);
-            throw std::runtime_error(std::string("Running script failed: ") + err.what());
         }
+        // The script may have caught the error of the interrupt
+        return checkInterrupt();
     }
 
     Object VM::runAndReturn(const Script& script, bool printCallstack) {
+        return tryRunAndReturn(script, printCallstack).unwrap(vm);
+    }
+
+    Result<Object> VM::tryRunAndReturn(const Script& script, bool printCallstack) {
         if (script.isEmpty()) {
-            throw RuntimeException(vm, "Empty script object.");
+            return Error(ErrorCode::RUNTIME_ERROR, "Empty script object.");
         }
 
+        Result<void> interrupt = checkInterrupt();
+        if (!interrupt) return interrupt.getError();
+
         const SQInteger old_top = sq_gettop(vm);
         sq_pushobject(vm, script.getRaw());
         sq_pushroottable(vm);
-        try {
-            if (SQ_FAILED(sq_call(vm, 1, SQTrue, SQTrue))) {
-                //if (!runtimeException)
-                    throw RuntimeException(vm, "Error running script!");
-                //throw *runtimeException;
-            }
-
-            // Root table may've changed
-            sq_resetobject(&obj);
-            sq_pushroottable(vm);
-            sq_getstackobj(vm, -1, &obj);
-            sq_addref(vm, &obj);
-            sq_pop(vm, 1);
-
-            Object ret = detail::pop<Object>(vm, -1);
-            sq_settop(vm, old_top);
-            return ret;
-        }
-        catch (const RuntimeException&) {
+        if (SQ_FAILED(sq_call(vm, 1, SQTrue, SQTrue))) {
             if (printCallstack) {
                 sqstd_printcallstack(vm);
             }
             sq_settop(vm, old_top);
-            throw;
-        }
-        catch (const std::exception& err) {
-            sq_settop(vm, old_top);
-            throw std::runtime_error(std::string("Running script failed: ") + err.what());
+            interrupt = checkInterrupt();
+            if (!interrupt) return interrupt.getError();
+            return Error(ErrorCode::RUNTIME_ERROR, "Error running script!");
         }
+
+        // Root table may've changed
+        sq_resetobject(&obj);
+        sq_pushroottable(vm);
+        sq_getstackobj(vm, -1, &obj);
+        sq_addref(vm, &obj);
+        sq_pop(vm, 1);
+
+        Object ret(vm);
+        sq_getstackobj(vm, -1, &ret.getRaw());
+        sq_addref(vm, &ret.getRaw());
+        sq_settop(vm, old_top);
+        interrupt = checkInterrupt();
+        if (!interrupt) return interrupt.getError();
+        return ret;
     }
 
     VM VM::newThread(size_t stackSize) {
         assert(VM::getMain(vm).getHandle() == vm); // Assert this is the main VM
 
+        StackGuard guard(vm);
         HSQUIRRELVM thread = sq_newthread(vm, stackSize);
         if (!thread)
             throw RuntimeException(vm, "Failed to create thread!");
@@ -322,39 +422,50 @@ namespace ssq {
             throw RuntimeException(vm, "Failed to get Squirrel thread from stack!");
         sq_addref(vm, &threadObj);
 
-        VM threadVM(threadObj);
-        threads.push_back(std::move(threadObj));
+        if (needsDebugHook(thread))
+            sq_setnativedebughook(thread, &VM::debugHook);
 
-        sq_pop(vm, 1); // Pop thread
+        VM threadVM(threadObj);
+        threads.emplace(thread, threadObj);
         return threadVM;
     }
 
-    void VM::destroyThread(VM& threadVM) {
+    VM VM::newThread() {
+        return newThread(getSuggestedThreadStackSize());
+    }
+
+    size_t VM::getSuggestedThreadStackSize() const {
+        assert(VM::getMain(vm).getHandle() == vm); // Assert this is the main VM
+
+        if (threadStackPeak == 0) return 1024;
+        // Headroom for native calls and temporaries, which are not tracked
+        return threadStackPeak + threadStackPeak / 4 + 32;
+    }
+
+    void VM::destroyThread(VM& threadVM, bool collectGarbage) {
         assert(VM::getMain(vm).getHandle() == vm); // Assert this is the main VM
         assert(threadVM.vm);
 
-        auto it = std::find_if(threads.begin(), threads.end(),
-            [&threadVM](const HSQOBJECT& threadObj) {
-                return threadVM.vm == threadObj._unVal.pThread;
-            });
+        auto it = threads.find(threadVM.vm);
         assert(it != threads.end());
 
-        sq_resetobject(&*it);
+        sq_release(vm, &it->second);
         threads.erase(it);
 
-        sq_collectgarbage(vm);
+        if (collectGarbage)
+            gc().collectOrSchedule();
         threadVM.vm = nullptr;
     }
 
     Enum VM::addEnum(const char* name) {
         Enum enm(vm);
+        StackGuard guard(vm);
         sq_pushconsttable(vm);
         sq_pushstring(vm, name, strlen(name));
         detail::push<Object>(vm, enm);
         if(SQ_FAILED(sq_newslot(vm, -3, SQFalse))) {
             throw RuntimeException(vm, "Failed to add enumerator '" + std::string(name) + "'!");
         }
-        sq_pop(vm,1); // pop table
         return std::move(enm);
     }
 
@@ -365,21 +476,104 @@ namespace ssq {
         return *this;
     }
 
-    Object VM::callAndReturn(SQUnsignedInteger nparams, SQInteger top) const {
+    Result<void> VM::checkNumOfParams(const Function& func, std::size_t params) {
+        Result<std::pair<unsigned int, unsigned int>> funcParams = func.tryGetNumOfParams();
+        if(!funcParams) return funcParams.getError();
+        if(params < funcParams.value().first || params > funcParams.value().second) {
+            return Error(ErrorCode::ARGUMENT_MISMATCH, "Number of arguments does not match");
+        }
+        return Result<void>();
+    }
+
+    Result<Object> VM::callAndReturn(SQUnsignedInteger nparams, SQInteger top) const {
+        Result<void> interrupt = checkInterrupt();
+        if (!interrupt) {
+            sq_settop(vm, top);
+            return interrupt.getError();
+        }
+
         if(SQ_FAILED(sq_call(vm, 1 + nparams, SQTrue, SQTrue))) {
             sq_settop(vm, top);
-            //if (!runtimeException)
-                throw RuntimeException(vm, "Error running script!");
-            //throw *runtimeException;
+            interrupt = checkInterrupt();
+            if (!interrupt) return interrupt.getError();
+            return Error(ErrorCode::RUNTIME_ERROR, "Error running script!");
         }
 
         Object ret(vm);
         sq_getstackobj(vm, -1, &ret.getRaw());
         sq_addref(vm, &ret.getRaw());
         sq_settop(vm, top);
+        // The script may have caught the error of the interrupt
+        interrupt = checkInterrupt();
+        if (!interrupt) return interrupt.getError();
         return ret;
     }
 
+    size_t VM::countLiveRefs() const {
+#ifdef SSQ_TRACK_REFS
+        if (vm == nullptr) return 0;
+        const VM& mainVM = VM::getMain(vm);
+        size_t count = 0;
+        detail::RefTracker::forEach([&](Object& object, const detail::RefSite&) {
+            if (mainVM.holdsLiveRef(object)) count++;
+        });
+        return count;
+#else
+        return 0;
+#endif
+    }
+
+    void VM::dumpLiveRefs(std::ostream& out) const {
+#ifdef SSQ_TRACK_REFS
+        if (vm == nullptr) return;
+        VM::getMain(vm).writeLiveRefs(out);
+#else
+        out << "Reference tracking is disabled, build with SSQ_TRACK_REFS" << std::endl;
+#endif
+    }
+
+#ifdef SSQ_TRACK_REFS
+    bool VM::holdsLiveRef(const Object& object) const {
+        // Only compares the handles, threads destroyed earlier may have left
+        // dangling handles behind
+        const HSQUIRRELVM handle = object.getHandle();
+        if (&object == this || handle == nullptr) return false;
+        if (handle != vm && threads.find(handle) == threads.end()) return false;
+        return (object.getRaw()._type & SQOBJECT_REF_COUNTED) != 0;
+    }
+
+    void VM::writeLiveRefs(std::ostream& out) const {
+        std::map<Type, size_t> types;
+        size_t total = 0;
+        detail::RefTracker::forEach([&](Object& object, const detail::RefSite&) {
+            if (!holdsLiveRef(object)) return;
+            types[object.getType()]++;
+            total++;
+        });
+
+        out << "Live references: " << total << "\n";
+        for (const auto& pair : types) {
+            out << "  " << typeToStr(pair.first) << ": " << pair.second << "\n";
+        }
+        detail::RefTracker::forEach([&](Object& object, const detail::RefSite& site) {
+            if (!holdsLiveRef(object)) return;
+            out << typeToStr(object.getType()) << " held by " << static_cast<const void*>(&object) << "\n";
+            detail::RefTracker::writeSite(out, site);
+        });
+        out.flush();
+    }
+
+    void VM::detachLiveRefs() {
+        detail::RefTracker::forEach([&](Object& object, const detail::RefSite&) {
+            const HSQUIRRELVM handle = object.getHandle();
+            if (&object == this || handle == nullptr) return;
+            if (handle == vm || threads.find(handle) != threads.end()) {
+                detail::RefTracker::detach(object);
+            }
+        });
+    }
+#endif
+
     void VM::debugStack() const {
         auto top = getTop();
         while(top >= 0) {
@@ -449,27 +643,177 @@ namespace ssq {
         ));
     }
 */
-    void VM::pushArgs() {
+    void VM::updateDebugHook() {
+        assert(VM::getMain(vm).getHandle() == vm); // Assert this is the main VM
+
+        sq_setnativedebughook(vm, needsDebugHook(vm) ? &VM::debugHook : nullptr);
+        for (auto& pair : threads) {
+            sq_setnativedebughook(pair.first, needsDebugHook(pair.first) ? &VM::debugHook : nullptr);
+        }
+    }
+
+    bool VM::needsDebugHook(HSQUIRRELVM handle) const {
+        if (profiler || stackTracking) return true;
+        VM* owner = VM::get(handle);
+        return owner && owner->hasBudget();
+    }
+
+    void VM::consumeBudget() {
+        // The hook must not be removed from within itself, it stays installed and
+        // only stops counting until the budget is cleared or replaced
+        if (hasInstructionBudget) {
+            if (instructionBudget == 0) {
+                hasInstructionBudget = false;
+                hasDeadline = false;
+                interruptReason = "Instruction budget exhausted!";
+                return;
+            }
+            instructionBudget--;
+        }
+        if (hasDeadline && (deadlineCounter++ & 1023) == 0) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                hasInstructionBudget = false;
+                hasDeadline = false;
+                interruptReason = "Deadline exceeded!";
+            }
+        }
+    }
+
+    Result<void> VM::checkInterrupt() const {
+        const VM* self = VM::get(vm);
+        if (self && self->interruptReason) {
+            return Error(ErrorCode::TIMEOUT, self->interruptReason);
+        }
+        return Result<void>();
+    }
+
+    bool detail::raiseInterrupt(HSQUIRRELVM vm) {
+        VM* self = VM::get(vm);
+        if (!self || !self->interruptReason) return false;
+        sq_throwerror(vm, self->interruptReason);
+        return true;
+    }
+
+    void VM::setStackTracking(bool enable) {
+        assert(VM::getMain(vm).getHandle() == vm); // Assert this is the main VM
+
+        stackTracking = enable;
+        threadStackPeak = 0;
+        resetStackStats();
+        for (auto& pair : threads) {
+            if (VM* thread = VM::get(pair.first))
+                thread->resetStackStats();
+        }
+        updateDebugHook();
+    }
 
+    const StackStats& VM::getStackStats() const {
+        return stackStats;
     }
 
-    std::unordered_map<size_t, HSQOBJECT> VM::classMap = {};
+    void VM::resetStackStats() {
+        stackFrames.clear();
+        stackSlots = 0;
+        stackStats = StackStats();
+    }
+
+    GarbageCollector VM::gc() {
+        return GarbageCollector(*this);
+    }
+
+    void VM::trackStack(SQInteger type) {
+        if (type == 'c') {
+            // The hook runs in the frame of the called function
+            const SQInteger size = sq_gettop(vm);
+            stackFrames.push_back(size);
+            stackSlots += static_cast<size_t>(size);
+            stackStats.peakDepth = std::max(stackStats.peakDepth, stackFrames.size());
+            stackStats.peakSlots = std::max(stackStats.peakSlots, stackSlots);
+
+            VM& mainVM = VM::getMain(vm);
+            if (&mainVM != this)
+                mainVM.threadStackPeak = std::max(mainVM.threadStackPeak, stackSlots);
+        } else if (type == 'r' && !stackFrames.empty()) {
+            // Also reported for frames unwound by an exception
+            stackSlots -= static_cast<size_t>(stackFrames.back());
+            stackFrames.pop_back();
+        }
+    }
+
+    void VM::debugHook(HSQUIRRELVM vm, SQInteger type, const SQChar*, SQInteger, const SQChar*) {
+        VM* self = VM::get(vm);
+        VM& mainVM = VM::getMain(vm);
+        if (self && mainVM.stackTracking)
+            self->trackStack(type);
+
+        if (self && self->hasBudget())
+            self->consumeBudget();
+
+        if (mainVM.profiler)
+            mainVM.profiler->sample(vm);
+    }
+
+    const std::map<std::string, NativeCallStats>& VM::getNativeStats() const {
+        return nativeStats;
+    }
+
+    void VM::resetNativeStats() {
+        for (auto& pair : nativeStats) {
+            pair.second = NativeCallStats();
+        }
+    }
+
+    void VM::pushArgs() {
+
+    }
 
     void VM::addClassObj(size_t hashCode, const HSQOBJECT& obj) {
-        classMap[hashCode] = obj;
+        VM::getMain(vm).classMap[hashCode] = obj;
     }
 
-    const HSQOBJECT& VM::getClassObj(size_t hashCode) {
-        return classMap.at(hashCode);
+    const HSQOBJECT& VM::getClassObj(size_t hashCode) const {
+        return VM::getMain(vm).classMap.at(hashCode);
     }
 
     namespace detail {
-        void addClassObj(size_t hashCode, const HSQOBJECT& obj) {
-            VM::addClassObj(hashCode, obj);
+        void addClassObj(HSQUIRRELVM vm, size_t hashCode, const HSQOBJECT& obj) {
+            VM::getMain(vm).addClassObj(hashCode, obj);
+        }
+
+        const HSQOBJECT& getClassObj(HSQUIRRELVM vm, size_t hashCode) {
+            return VM::getMain(vm).getClassObj(hashCode);
         }
 
-        const HSQOBJECT& getClassObj(size_t hashCode) {
-            return VM::getClassObj(hashCode);
+        void addClassCopier(HSQUIRRELVM vm, size_t hashCode, const ClassCopier& copier) {
+            VM::getMain(vm).classCopiers[hashCode] = copier;
+        }
+
+        const ClassCopier* getClassCopier(HSQUIRRELVM vm, size_t hashCode) {
+            VM& mainVM = VM::getMain(vm);
+            auto it = mainVM.classCopiers.find(hashCode);
+            if (it == mainVM.classCopiers.end() || !it->second.copy) return nullptr;
+            return &it->second;
+        }
+
+        void registerNativeStatsClass(HSQUIRRELVM vm, size_t hashCode, const char* name) {
+            VM::getMain(vm).nativeStatsClassNames[hashCode] = name;
+        }
+
+        NativeCallStats* registerNativeStats(HSQUIRRELVM vm, const char* name, SQInteger classIdx) {
+            VM& mainVM = VM::getMain(vm);
+
+            // Methods are keyed as "Class.method"
+            std::string key;
+            SQUserPointer typeTag = nullptr;
+            if (sq_gettype(vm, classIdx) == OT_CLASS && SQ_SUCCEEDED(sq_gettypetag(vm, classIdx, &typeTag))) {
+                auto it = mainVM.nativeStatsClassNames.find(reinterpret_cast<size_t>(typeTag));
+                if (it != mainVM.nativeStatsClassNames.end()) {
+                    key = it->second + ".";
+                }
+            }
+            key += name;
+
+            return &mainVM.nativeStats[key];
         }
     }
 }
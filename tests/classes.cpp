@@ -940,3 +940,299 @@ TEST_CASE("Register class and extend it") {
     REQUIRE(fooPtr->getMsg() == "World");
 }
 
+
+TEST_CASE("Register class from a table of functions") {
+    class Counter : public ssq::ExposableClass {
+    public:
+        Counter():value(0) {
+        }
+
+        static Counter* self(HSQUIRRELVM vm) {
+            SQUserPointer ptr;
+            sq_getinstanceup(vm, 1, &ptr, nullptr, SQTrue);
+            return static_cast<Counter*>(static_cast<ssq::ExposableClass*>(ptr));
+        }
+        static SQInteger add(HSQUIRRELVM vm) {
+            SQInteger amount;
+            sq_getinteger(vm, 2, &amount);
+            self(vm)->value += amount;
+            return 0;
+        }
+        static SQInteger getValue(HSQUIRRELVM vm) {
+            sq_pushinteger(vm, self(vm)->value);
+            return 1;
+        }
+        static SQInteger setValue(HSQUIRRELVM vm) {
+            SQInteger value;
+            sq_getinteger(vm, 2, &value);
+            self(vm)->value = value;
+            return 0;
+        }
+        static SQInteger limit(HSQUIRRELVM vm) {
+            sq_pushinteger(vm, 100);
+            return 1;
+        }
+
+        SQInteger value;
+    };
+
+    static const ssq::FuncDef counterFuncs[] = {
+        { "add", &Counter::add, 2, 2, "xi", ssq::FuncDef::NONE },
+        { "value", &Counter::getValue, 0, 0, nullptr, ssq::FuncDef::GETTER },
+        { "value", &Counter::setValue, 0, 0, nullptr, ssq::FuncDef::SETTER },
+        { "limit", &Counter::limit, 0, 0, nullptr, ssq::FuncDef::STATIC }
+    };
+    static const ssq::FuncDef globalFuncs[] = {
+        { "twice", [](HSQUIRRELVM vm) -> SQInteger {
+            SQInteger value;
+            sq_getinteger(vm, 2, &value);
+            sq_pushinteger(vm, value * 2);
+            return 1;
+        }, 2, 2, ".i", ssq::FuncDef::NONE }
+    };
+
+    static const std::string source = STRINGIFY(
+        function run() {
+            local counter = Counter();
+            counter.add(twice(5));
+            counter.value = counter.value + 1;
+            return counter.value + Counter.limit();
+        }
+    );
+
+    ssq::VM vm(1024);
+    ssq::Class cls = vm.addClass("Counter", []() { return new Counter(); });
+    cls.addFuncs(counterFuncs);
+    vm.addFuncs(globalFuncs);
+    vm.run(vm.compileSource(source.c_str()));
+
+    REQUIRE(vm.callFunc(vm.findFunc("run"), vm).toInt() == 111);
+}
+
+TEST_CASE("Register classes lazily") {
+    class Foo : public ssq::ExposableClass {
+    public:
+        int get() const {
+            return 42;
+        }
+    };
+
+    static const std::string source = STRINGIFY(
+        function useFoo() {
+            return Foo().get();
+        }
+        function useMissing() {
+            return missing;
+        }
+        function useMath() {
+            return math.twice(4);
+        }
+    );
+
+    int created = 0;
+    ssq::VM vm(1024);
+    vm.addLazy("Foo", [&](ssq::Table& table) {
+        created++;
+        ssq::Class cls = table.addClass("Foo", []() { return new Foo(); });
+        cls.addFunc("get", &Foo::get);
+    });
+    vm.addLazy("Bar", [&](ssq::Table& table) {
+        created++;
+        table.addClass("Bar", []() { return new Foo(); });
+    });
+    ssq::Table math = vm.addTable("math");
+    math.addLazy("twice", [](ssq::Table& table) {
+        table.addFunc("twice", [](int value) -> int { return value * 2; });
+    });
+    vm.run(vm.compileSource(source.c_str()));
+    const auto top = vm.getTop();
+
+    REQUIRE(created == 0);
+    REQUIRE(vm.callFunc(vm.findFunc("useFoo"), vm).toInt() == 42);
+    REQUIRE(vm.callFunc(vm.findFunc("useFoo"), vm).toInt() == 42);
+    REQUIRE(created == 1);
+    REQUIRE(vm.callFunc(vm.findFunc("useMath"), vm).toInt() == 8);
+    REQUIRE_THROWS_AS(vm.callFunc(vm.findFunc("useMissing"), vm), const ssq::RuntimeException&);
+
+    REQUIRE(vm.findClass("Bar").getType() == ssq::Type::CLASS);
+    REQUIRE(created == 2);
+    REQUIRE(top == vm.getTop());
+}
+
+TEST_CASE("Register lazily behind an existing delegate") {
+    static const std::string source = STRINGIFY(
+        assigned <- [];
+        settings <- {};
+        settingsDelegate <- {};
+        settingsDelegate.shared <- "delegate";
+        settingsDelegate._set <- function(key, value) {
+            assigned.append(key);
+        };
+        settingsDelegate._get <- function(key) {
+            if (key != "fallback") throw null;
+            return this == ::settings ? "default" : "wrong this";
+        };
+        settings.setdelegate(settingsDelegate);
+
+        function assign() {
+            settings.volume = 5;
+            return assigned.len();
+        }
+        function readLazy() {
+            return settings.twice(3);
+        }
+        function readFallback() {
+            return settings.fallback;
+        }
+        function readShared() {
+            return settings.shared;
+        }
+        function readMissing() {
+            return settings.missing;
+        }
+    );
+
+    ssq::VM vm(1024);
+    vm.run(vm.compileSource(source.c_str()));
+    ssq::Table settings = vm.findTable("settings");
+    settings.addLazy("twice", [](ssq::Table& table) {
+        table.addFunc("twice", [](int value) -> int { return value * 2; });
+    });
+    const auto top = vm.getTop();
+
+    REQUIRE(vm.callFunc(vm.findFunc("assign"), vm).toInt() == 1);
+    REQUIRE(vm.callFunc(vm.findFunc("readLazy"), vm).toInt() == 6);
+    REQUIRE(vm.callFunc(vm.findFunc("readFallback"), vm).toString() == "default");
+    REQUIRE(vm.callFunc(vm.findFunc("readShared"), vm).toString() == "delegate");
+    REQUIRE_THROWS_AS(vm.callFunc(vm.findFunc("readMissing"), vm), const ssq::RuntimeException&);
+    REQUIRE(top == vm.getTop());
+}
+
+TEST_CASE("Weak references release instances") {
+    static int alive = 0;
+    class Foo : public ssq::ExposableClass {
+    public:
+        Foo() {
+            alive++;
+        }
+        ~Foo() {
+            alive--;
+        }
+        int get() const {
+            return 42;
+        }
+    };
+
+    static const std::string source = STRINGIFY(
+        cache <- [];
+        function remember(foo) {
+            cache.append(foo);
+        }
+        function forget() {
+            cache.clear();
+        }
+        settings <- {};
+        function weakCached() {
+            return weakGet(cache[0].weakref());
+        }
+        function weakTable() {
+            return weakGet(settings.weakref());
+        }
+    );
+
+    ssq::VM vm(1024);
+    ssq::Class cls = vm.addClass("Foo", ssq::Class::Ctor<Foo()>());
+    cls.addFunc("get", &Foo::get);
+    vm.addFunc("weakGet", [](ssq::SqWeakRef ref) -> int {
+        ssq::Instance inst = ref.lock();
+        return inst.isEmpty() ? -1 : 1;
+    });
+    vm.run(vm.compileSource(source.c_str()));
+    const auto top = vm.getTop();
+
+    std::vector<ssq::SqWeakRef> weak;
+    {
+        std::vector<ssq::Instance> strong;
+        for (int i = 0; i < 100; i++) {
+            strong.push_back(vm.newInstance(cls));
+            weak.push_back(ssq::SqWeakRef(strong.back()));
+        }
+        REQUIRE(alive == 100);
+        REQUIRE(!weak.front().expired());
+        REQUIRE(vm.callFunc(cls.findFunc("get"), weak.front()).toInt() == 42);
+        REQUIRE(vm.callFunc(vm.findFunc("weakGet"), vm, strong.front()).toInt() == 1);
+        vm.callFunc(vm.findFunc("remember"), vm, strong.front());
+    }
+
+    // Only the instance kept by the script survives
+    REQUIRE(alive == 1);
+    REQUIRE(!weak.front().expired());
+    REQUIRE(weak.back().expired());
+    REQUIRE(weak.back().lock().isEmpty());
+    REQUIRE(vm.callFunc(vm.findFunc("weakGet"), vm, weak.back()).toInt() == -1);
+    // Weak references created by scripts must point to instances too
+    REQUIRE(vm.callFunc(vm.findFunc("weakCached"), vm).toInt() == 1);
+    REQUIRE_THROWS_AS(vm.callFunc(vm.findFunc("weakTable"), vm), const ssq::RuntimeException&);
+
+    vm.callFunc(vm.findFunc("forget"), vm);
+    REQUIRE(alive == 0);
+    REQUIRE(weak.front().expired());
+    REQUIRE(top == vm.getTop());
+}
+
+TEST_CASE("Bind methods known at compile time") {
+    class Foo : public ssq::ExposableClass {
+    public:
+        void set(int v) {
+            value = v;
+        }
+        int get() const {
+            return value;
+        }
+        std::string describe(const std::string& prefix, int times) const {
+            std::string str;
+            for (int i = 0; i < times; i++) str += prefix;
+            return str + std::to_string(value);
+        }
+        int fail() {
+            throw std::runtime_error("Foo failed");
+        }
+        int value = 0;
+    };
+
+    static constexpr ssq::FuncDef funcs[] = {
+        { "twice", &ssq::nativeMethod<SSQ_METHOD(&Foo::get)>, 1, 1, "x", ssq::FuncDef::NONE }
+    };
+
+    static const std::string source = STRINGIFY(
+        function run() {
+            local foo = Foo();
+            foo.set(21);
+            return foo.describe("x", 2) + ":" + foo.get() + ":" + foo.twice();
+        }
+        function badArgs() {
+            Foo().set("string");
+        }
+        function fail() {
+            Foo().fail();
+        }
+    );
+
+    ssq::VM vm(1024, ssq::Libs::STRING);
+    ssq::Class cls = vm.addClass("Foo", ssq::Class::Ctor<Foo()>());
+    cls.addMethod<SSQ_METHOD(&Foo::set)>("set");
+    cls.addMethod<SSQ_METHOD(&Foo::get)>("get");
+    cls.addMethod<SSQ_METHOD(&Foo::describe)>("describe");
+    cls.addMethod<SSQ_METHOD(&Foo::fail)>("fail");
+    cls.addFuncs(funcs);
+    vm.run(vm.compileSource(source.c_str()));
+
+    REQUIRE(vm.callFunc(vm.findFunc("run"), vm).toString() == "xx21:21:21");
+    REQUIRE_THROWS_AS(vm.callFunc(vm.findFunc("badArgs"), vm), const ssq::RuntimeException&);
+    try {
+        vm.callFunc(vm.findFunc("fail"), vm);
+        FAIL("Expected an exception");
+    } catch (const ssq::RuntimeException& e) {
+        REQUIRE(std::string(e.what()).find("Foo failed") != std::string::npos);
+    }
+}
@@ -0,0 +1,268 @@
+#define CATCH_CONFIG_MAIN 
+#include "catch.hpp"
+#include <simplesquirrel/simplesquirrel.hpp>
+#include <sstream>
+
+#define STRINGIFY(x) #x
+
+TEST_CASE("Profile a script") {
+    static const std::string source = STRINGIFY(
+        function inner() {
+            local sum = 0;
+            for (local i = 0; i < 100000; i++) {
+                sum += i;
+            }
+            return sum;
+        }
+
+        function outer() {
+            local sum = 0;
+            for (local i = 0; i < 50; i++) {
+                sum += inner();
+            }
+            return sum;
+        }
+    );
+
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.enableDebugInfo(true);
+    vm.run(vm.compileSource(source.c_str(), "profiled.nut"));
+
+    ssq::Profiler profiler(vm, 5000);
+    REQUIRE(profiler.getRate() == 5000);
+    REQUIRE(profiler.isRunning() == false);
+
+    profiler.start();
+    REQUIRE(profiler.isRunning());
+    REQUIRE_THROWS_AS(ssq::Profiler(vm).start(), const ssq::RuntimeException&);
+
+    vm.callFunc(vm.findFunc("outer"), vm);
+    profiler.stop();
+
+    REQUIRE(profiler.isRunning() == false);
+    REQUIRE(profiler.getNumOfSamples() > 0);
+
+    std::stringstream ss;
+    profiler.writeCollapsed(ss);
+    const std::string collapsed = ss.str();
+    REQUIRE(collapsed.find("outer (profiled.nut:") != std::string::npos);
+    REQUIRE(collapsed.find(";inner (profiled.nut:") != std::string::npos);
+
+    // Stopped profiler does not collect
+    const size_t samples = profiler.getNumOfSamples();
+    vm.callFunc(vm.findFunc("outer"), vm);
+    REQUIRE(profiler.getNumOfSamples() == samples);
+
+    profiler.reset();
+    REQUIRE(profiler.getNumOfSamples() == 0);
+    REQUIRE(profiler.getStacks().empty());
+
+    // A profiler created from a thread outlives the thread
+    ssq::VM thread = vm.newThread(1024);
+    ssq::Profiler threadProfiler(thread, 5000);
+    threadProfiler.start();
+    thread.callFunc(thread.findFunc("inner"), thread);
+    vm.destroyThread(thread);
+    vm.callFunc(vm.findFunc("inner"), vm);
+    threadProfiler.stop();
+    REQUIRE(threadProfiler.getNumOfSamples() > 0);
+}
+
+TEST_CASE("Profiler outlives the VM") {
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    ssq::Profiler profiler(vm);
+    profiler.start();
+    vm.destroy();
+    REQUIRE(profiler.isRunning() == false);
+}
+
+TEST_CASE("Native call statistics") {
+    static const std::string source = STRINGIFY(
+        for (local i = 0; i < 10; i++) {
+            add(i, 1);
+        }
+        local foo = Foo();
+        foo.bar();
+        try { fail(); } catch (e) {}
+    );
+
+    class Foo : public ssq::ExposableClass {
+    public:
+        void bar() {
+        }
+    };
+
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.addFunc("add", [](int a, int b) -> int {
+        return a + b;
+    });
+    vm.addFunc("fail", []() -> void {
+        throw std::runtime_error("failed");
+    });
+    ssq::Class cls = vm.addClass("Foo", []() -> Foo* {
+        return new Foo();
+    });
+    cls.addFunc("bar", &Foo::bar);
+
+    vm.run(vm.compileSource(source.c_str()));
+
+    const auto& stats = vm.getNativeStats();
+#ifdef SSQ_NATIVE_STATS
+    REQUIRE(stats.size() == 4);
+    REQUIRE(stats.at("add").calls == 10);
+    REQUIRE(stats.at("add").exceptions == 0);
+    REQUIRE(stats.at("add").totalNs >= stats.at("add").maxNs);
+    REQUIRE(stats.at("fail").calls == 1);
+    REQUIRE(stats.at("fail").exceptions == 1);
+    REQUIRE(stats.at("Foo.constructor").calls == 1);
+    REQUIRE(stats.at("Foo.bar").calls == 1);
+
+    vm.resetNativeStats();
+    REQUIRE(stats.at("add").calls == 0);
+#else
+    REQUIRE(stats.empty());
+#endif
+}
+
+TEST_CASE("Interrupt a runaway script") {
+    // Not STRINGIFY, Squirrel only reports a line when the executed line changes
+    static const char* source =
+        "lastError <- null;\n"
+        "function spin() {\n"
+        "    local n = 0;\n"
+        "    while (true) {\n"
+        "        n++;\n"
+        "        tick();\n"
+        "    }\n"
+        "}\n"
+        "function swallow() {\n"
+        "    for (local i = 0; i < 100000; i++) {\n"
+        "        try {\n"
+        "            tick();\n"
+        "        } catch (e) {\n"
+        "            lastError = e;\n"
+        "        }\n"
+        "    }\n"
+        "    return 1;\n"
+        "}\n"
+        "total <- 0;\n"
+        "function fill(n) {\n"
+        "    for (local i = 0; i < n; i++) {\n"
+        "        ::total += 1;\n"
+        "    }\n"
+        "}\n"
+        "function count(n) {\n"
+        "    local sum = 0;\n"
+        "    for (local i = 0; i < n; i++) {\n"
+        "        sum += i;\n"
+        "    }\n"
+        "    return sum;\n"
+        "}\n";
+
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.enableDebugInfo(true);
+    int ticks = 0;
+    vm.addFunc("tick", [&]() {
+        ticks++;
+    });
+    vm.run(vm.compileSource(source));
+
+    SECTION("Instruction budget") {
+        ssq::VM thread = vm.newThread(1024);
+        thread.setInstructionBudget(10000);
+        REQUIRE(thread.hasBudget());
+        REQUIRE(vm.hasBudget() == false);
+
+        REQUIRE_THROWS_AS(thread.callFunc(thread.findFunc("spin"), thread), const ssq::TimeoutException&);
+        REQUIRE(ticks > 0);
+        REQUIRE(thread.hasBudget() == false);
+        REQUIRE(thread.isInterrupted());
+
+        // Stays interrupted until the budget is cleared
+        REQUIRE_THROWS_AS(thread.callFunc(thread.findFunc("count"), thread, 10), const ssq::TimeoutException&);
+        thread.clearBudget();
+        REQUIRE(thread.isInterrupted() == false);
+        REQUIRE(thread.callFunc(thread.findFunc("count"), thread, 10).toInt() == 45);
+        vm.destroyThread(thread);
+    }
+
+    SECTION("Deadline") {
+        ssq::VM thread = vm.newThread(1024);
+        thread.setTimeLimit(std::chrono::milliseconds(20));
+
+        REQUIRE_THROWS_AS(thread.callFunc(thread.findFunc("spin"), thread), const ssq::TimeoutException&);
+        REQUIRE(thread.isInterrupted());
+        vm.destroyThread(thread);
+    }
+
+    SECTION("Script catching the interrupt") {
+        ssq::VM thread = vm.newThread(1024);
+        thread.setInstructionBudget(1000);
+
+        REQUIRE_THROWS_AS(thread.callFunc(thread.findFunc("swallow"), thread), const ssq::TimeoutException&);
+        REQUIRE(vm.find("lastError").toString() == "Instruction budget exhausted!");
+        // Every bound function called after the interrupt has failed
+        REQUIRE(ticks < 1000);
+        vm.destroyThread(thread);
+    }
+
+    SECTION("Pure script loops are not stopped") {
+        ssq::VM thread = vm.newThread(1024);
+        thread.setInstructionBudget(100);
+
+        // The loop runs to its end, the interrupt is only delivered on return
+        REQUIRE_THROWS_AS(thread.callFunc(thread.findFunc("fill"), thread, 10000), const ssq::TimeoutException&);
+        REQUIRE(vm.find("total").toInt() == 10000);
+        vm.destroyThread(thread);
+    }
+
+    SECTION("Script within the budget") {
+        vm.setInstructionBudget(100000);
+        REQUIRE(vm.callFunc(vm.findFunc("count"), vm, 100).toInt() == 4950);
+        REQUIRE(vm.getRemainingInstructions() < 100000 - 100);
+        vm.clearBudget();
+        REQUIRE(vm.hasBudget() == false);
+    }
+
+    // The main VM is not affected by interrupted threads
+    REQUIRE(vm.isInterrupted() == false);
+    REQUIRE(vm.callFunc(vm.findFunc("count"), vm, 10).toInt() == 45);
+}
+
+TEST_CASE("Track live references") {
+    ssq::Table leaked;
+    {
+        ssq::VM vm(1024);
+        const size_t base = vm.countLiveRefs();
+        ssq::Table table = vm.newTable();
+        ssq::Array array = vm.newArray();
+        ssq::Object number = vm.newArray().find("len");
+        std::stringstream ss;
+        vm.dumpLiveRefs(ss);
+#ifdef SSQ_TRACK_REFS
+        REQUIRE(vm.countLiveRefs() == base + 3);
+        REQUIRE(ss.str().find("TABLE: 1") != std::string::npos);
+        REQUIRE(ss.str().find("ARRAY: 1") != std::string::npos);
+        REQUIRE(ss.str().find("NATIVECLOSURE: 1") != std::string::npos);
+
+        ssq::VM thread = vm.newThread(1024);
+        {
+            // The thread itself holds the root table
+            ssq::Table threadTable = thread.newTable();
+            REQUIRE(thread.countLiveRefs() == base + 5);
+        }
+        vm.destroyThread(thread);
+
+        leaked = vm.newTable();
+        REQUIRE(vm.countLiveRefs() == base + 4);
+#else
+        REQUIRE(vm.countLiveRefs() == 0);
+        REQUIRE(ss.str().find("SSQ_TRACK_REFS") != std::string::npos);
+#endif
+    }
+#ifdef SSQ_TRACK_REFS
+    // Emptied when the VM was destroyed
+    REQUIRE(leaked.isEmpty());
+    REQUIRE(leaked.getHandle() == nullptr);
+#endif
+}
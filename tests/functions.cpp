@@ -4,6 +4,10 @@
 
 #define STRINGIFY(x) #x
 
+static int multiply(int a, int b) {
+    return a * b;
+}
+
 TEST_CASE("Find and call function"){
     static const std::string source = STRINGIFY(
         function foo(a, b) {
@@ -705,3 +709,173 @@ TEST_CASE("Test passing instance") {
     ssq::Script script = vm.compileSource(source.c_str());
     vm.run(script);
 }
+
+TEST_CASE("Call function in batch") {
+    static const std::string source = STRINGIFY(
+        count <- 0;
+
+        function update(position, speed, dt) {
+            count++;
+            return position + speed * dt;
+        }
+
+        function fail(value) {
+            if (value > 1) throw "too large";
+            return value;
+        }
+    );
+
+    ssq::VM vm(1024);
+    vm.run(vm.compileSource(source.c_str()));
+    const auto top = vm.getTop();
+
+    std::vector<std::tuple<float, float, float>> entities;
+    for (int i = 0; i < 100; i++) {
+        entities.emplace_back(static_cast<float>(i), 2.0f, 0.5f);
+    }
+
+    SECTION("Collect results") {
+        std::vector<float> results(entities.size());
+        auto end = vm.callBatch<float>(vm.findFunc("update"), vm, entities, results.begin());
+        REQUIRE(end == results.end());
+        REQUIRE(results[0] == Approx(1.0f));
+        REQUIRE(results[99] == Approx(100.0f));
+        REQUIRE(vm.find("count").toInt() == 100);
+        REQUIRE(top == vm.getTop());
+    }
+
+    SECTION("Discard results") {
+        vm.callBatch(vm.findFunc("update"), vm, entities);
+        REQUIRE(vm.find("count").toInt() == 100);
+        REQUIRE(top == vm.getTop());
+    }
+
+    SECTION("Errors") {
+        std::vector<std::tuple<int>> values = { std::make_tuple(0), std::make_tuple(1), std::make_tuple(2) };
+        std::vector<int> results;
+        REQUIRE_THROWS_AS(vm.callBatch<int>(vm.findFunc("fail"), vm, values, std::back_inserter(results)), const ssq::RuntimeException&);
+        REQUIRE(results.size() == 2);
+        REQUIRE(top == vm.getTop());
+
+        std::vector<std::tuple<int, int>> pairs = { std::make_tuple(0, 1) };
+        REQUIRE_THROWS_AS(vm.callBatch(vm.findFunc("fail"), vm, pairs), const ssq::RuntimeException&);
+    }
+}
+
+TEST_CASE("Exceptions thrown from natives") {
+    static const std::string source = STRINGIFY(
+        function check(value) {
+            try {
+                validate(value);
+            } catch (e) {
+                return e;
+            }
+            return "ok";
+        }
+        function throwFirst() {
+            throw "first";
+        }
+        function throwSecond() {
+            throw "second";
+        }
+    );
+
+    ssq::VM vm(1024);
+    vm.addFunc("validate", [](int value) -> void {
+        if (value < 0) throw ssq::TypeException("bad value", "positive integer", std::to_string(value));
+    });
+    vm.addFunc("nested", [&vm]() -> std::string {
+        try {
+            vm.callFunc(vm.findFunc("throwFirst"), vm);
+        } catch (const ssq::RuntimeException& first) {
+            // Running more script must not change the error of the first exception
+            try {
+                vm.callFunc(vm.findFunc("throwSecond"), vm);
+            } catch (const ssq::RuntimeException&) {
+            }
+            return first.what();
+        }
+        return "";
+    });
+    vm.run(vm.compileSource(source.c_str()));
+
+    const std::string message = "Squirrel exception: Type error bad value expected: positive integer got: -5 (no detailed info)";
+    REQUIRE(vm.callFunc(vm.findFunc("check"), vm, 5).toString() == "ok");
+    REQUIRE(vm.callFunc(vm.findFunc("check"), vm, -5).toString() == message);
+
+    const std::string nested = vm.callFunc(vm.findFunc("nested"), vm).toString();
+    REQUIRE(nested.find("first") != std::string::npos);
+    REQUIRE(nested.find("second") == std::string::npos);
+
+    ssq::TypeException e("bad value", "positive integer", "-5");
+    char buffer[20];
+    REQUIRE(e.format(buffer, sizeof(buffer)) == message.size());
+    REQUIRE(std::string(buffer) == message.substr(0, sizeof(buffer) - 1));
+    REQUIRE(e.what() == message);
+
+    // Only StaticText is kept by pointer, arrays are copied
+    char got[8] = "-5";
+    ssq::TypeException copied(ssq::StaticText("bad value"), "positive integer", got);
+    got[0] = 'x';
+    REQUIRE(copied.what() == message);
+
+    // Exceptions thrown out of a call keep the error of the VM after it is gone
+    std::string detail;
+    try {
+        ssq::VM other(1024);
+        other.run(other.compileSource("throw \"boom\";"));
+    } catch (const ssq::RuntimeException& err) {
+        detail = err.what();
+    }
+    REQUIRE(detail.find("boom") != std::string::npos);
+}
+
+TEST_CASE("Bind stateless functions without std::function") {
+    static const std::string source = STRINGIFY(
+        function run() {
+            return add(1, 2) + ":" + multiply(3, 4) + ":" + top() + ":" + offset(5) + ":" + greet("x");
+        }
+        function badArgs() {
+            add("a", 2);
+        }
+    );
+
+    ssq::VM vm(1024);
+    int base = 100;
+    vm.addFunc("add", [](int a, int b) -> int {
+        return a + b;
+    });
+    vm.addFunc("multiply", &multiply);
+    vm.addFunc("multiply2", multiply);
+    vm.addFunc("top", [](HSQUIRRELVM v) -> int {
+        return static_cast<int>(sq_gettop(v));
+    });
+    vm.addFunc("offset", [&](int a) -> int {
+        return base + a;
+    });
+    vm.addFunc("greet", [](const std::string& name, int times) -> std::string {
+        std::string str;
+        for (int i = 0; i < times; i++) str += name;
+        return str;
+    }, ssq::DefaultArguments<int>(3));
+    vm.run(vm.compileSource(source.c_str()));
+
+    REQUIRE(vm.callFunc(vm.findFunc("run"), vm).toString() == "3:12:1:105:xxx");
+    REQUIRE_THROWS_AS(vm.callFunc(vm.findFunc("badArgs"), vm), const ssq::RuntimeException&);
+
+    auto freeVars = [&](const char* name) -> SQInteger {
+        SQInteger nparamsmin, nparamsmax, nfreevars;
+        sq_pushobject(vm.getHandle(), vm.findFunc(name).getRaw());
+        sq_getclosureinfo(vm.getHandle(), -1, &nparamsmin, &nparamsmax, &nfreevars);
+        sq_pop(vm.getHandle(), 1);
+        return nfreevars;
+    };
+#ifndef SSQ_NATIVE_STATS
+    REQUIRE(freeVars("add") == 0);
+    REQUIRE(freeVars("top") == 0);
+    REQUIRE(freeVars("multiply") == 1);
+    REQUIRE(freeVars("multiply2") == 1);
+#endif
+    REQUIRE(freeVars("offset") == 1);
+    REQUIRE(freeVars("greet") == 2);
+}
@@ -1,6 +1,7 @@
 #define CATCH_CONFIG_MAIN 
 #include "catch.hpp"
 #include <simplesquirrel/simplesquirrel.hpp>
+#include <sstream>
 
 #define STRINGIFY(x) #x
 
@@ -356,3 +357,521 @@ TEST_CASE("Test param packer") {
     ssq::detail::paramPacker<std::nullptr_t>(ptr);
     REQUIRE(std::string(ptr) == "o");
 }
+
+TEST_CASE("Transfer objects between VMs") {
+    class Point: public ssq::ExposableClass {
+    public:
+        Point(int x): x(x) {
+        }
+        int x;
+    };
+
+    static const std::string source = STRINGIFY(
+        function make() {
+            local shared = [];
+            shared.append(1);
+            shared.append("x");
+            shared.append(null);
+            local data = {};
+            data.a <- shared;
+            data.b <- shared;
+            data.self <- data;
+            data.point <- Point(3);
+            return data;
+        }
+
+        function check(data) {
+            data.point.x = 10;
+            return data.self == data && data.a == data.b && data.a[1] == "x" && data.a.len() == 3;
+        }
+
+        function getX(data) {
+            return data.point.x;
+        }
+    );
+
+    ssq::VM vm1(1024, ssq::Libs::NONE);
+    ssq::VM vm2(1024, ssq::Libs::NONE);
+    for (ssq::VM* vm : {&vm1, &vm2}) {
+        ssq::Class cls = vm->addClass("Point", ssq::Class::Ctor<Point(int)>());
+        cls.addVar("x", &Point::x);
+        vm->run(vm->compileSource(source.c_str()));
+    }
+
+    ssq::Object data = vm1.callFunc(vm1.findFunc("make"), vm1);
+    const auto top1 = vm1.getTop();
+    const auto top2 = vm2.getTop();
+
+    ssq::Object copy = ssq::transfer(data, vm2);
+    REQUIRE(top1 == vm1.getTop());
+    REQUIRE(top2 == vm2.getTop());
+    REQUIRE(copy.getHandle() == vm2.getHandle());
+    REQUIRE(vm2.callFunc(vm2.findFunc("check"), vm2, copy).to<bool>());
+
+    // The instance is a copy, not a shared pointer
+    REQUIRE(vm2.callFunc(vm2.findFunc("getX"), vm2, copy).to<int>() == 10);
+    REQUIRE(vm1.callFunc(vm1.findFunc("getX"), vm1, data).to<int>() == 3);
+
+    SECTION("Functions cannot be transferred") {
+        REQUIRE_THROWS_AS(ssq::transfer(vm1.findFunc("make"), vm2), const ssq::TypeException&);
+        REQUIRE(top2 == vm2.getTop());
+    }
+}
+
+TEST_CASE("Serialize objects") {
+    static const std::string source = STRINGIFY(
+        function make() {
+            local list = [];
+            list.append(-1);
+            list.append(300);
+            list.append(-100000);
+            list.append(1.5);
+            list.append(null);
+            list.append(true);
+            local data = {};
+            data.name <- "player";
+            data.list <- list;
+            data.empty <- {};
+            return data;
+        }
+
+        function check(data) {
+            return data.name == "player" && data.list.len() == 6 && data.list[0] == -1 &&
+                data.list[1] == 300 && data.list[2] == -100000 && data.list[3] == 1.5 &&
+                data.list[4] == null && data.list[5] == true && data.empty.len() == 0;
+        }
+    );
+
+    ssq::VM vm(1024, ssq::Libs::NONE);
+    vm.run(vm.compileSource(source.c_str()));
+    ssq::Object data = vm.callFunc(vm.findFunc("make"), vm);
+    const auto top = vm.getTop();
+
+    SECTION("Round trip through memory") {
+        const std::string bytes = ssq::serialize(data);
+        REQUIRE(top == vm.getTop());
+        ssq::Object copy = ssq::deserialize(vm, bytes);
+        REQUIRE(top == vm.getTop());
+        REQUIRE(vm.callFunc(vm.findFunc("check"), vm, copy).to<bool>());
+    }
+
+    SECTION("Round trip through streams") {
+        std::stringstream stream;
+        ssq::serialize(data, stream);
+        ssq::serialize(vm.newTable(), stream);
+        ssq::Object copy = ssq::deserialize(vm, stream);
+        REQUIRE(vm.callFunc(vm.findFunc("check"), vm, copy).to<bool>());
+        REQUIRE(ssq::deserialize(vm, stream).getType() == ssq::Type::TABLE);
+    }
+
+    SECTION("MessagePack payload") {
+        ssq::Table table = vm.newTable();
+        table.set("a", 1);
+        REQUIRE(ssq::serialize(table) == std::string("SSQ\x01\x81\xa1" "a\x01", 8));
+    }
+
+    SECTION("Invalid data") {
+        const std::string bytes = ssq::serialize(data);
+        REQUIRE_THROWS_AS(ssq::deserialize(vm, bytes.substr(0, bytes.size() - 1)), const ssq::RuntimeException&);
+        REQUIRE_THROWS_AS(ssq::deserialize(vm, std::string("JSON")), const ssq::RuntimeException&);
+        REQUIRE(top == vm.getTop());
+    }
+
+    SECTION("Untrusted string lengths") {
+        // A 4 GB string in nine bytes
+        std::stringstream oversized(std::string("SSQ\x01\xdb\xff\xff\xff\xff", 9));
+        REQUIRE_THROWS_AS(ssq::deserialize(vm, oversized), const ssq::RuntimeException&);
+
+        // A 1 MB string followed by three bytes
+        std::stringstream truncated(std::string("SSQ\x01\xdb\x00\x10\x00\x00" "abc", 12));
+        REQUIRE_THROWS_AS(ssq::deserialize(vm, truncated), const ssq::RuntimeException&);
+        REQUIRE(top == vm.getTop());
+
+        // Strings longer than the read ahead still arrive in one piece
+        const std::string text(200 * 1024, 'x');
+        ssq::Table table = vm.newTable();
+        table.set("text", text);
+        std::stringstream stream;
+        ssq::serialize(table, stream);
+        REQUIRE(ssq::deserialize(vm, stream).toTable().get<std::string>("text") == text);
+    }
+
+    SECTION("Cycles and functions are rejected") {
+        ssq::Table table = vm.newTable();
+        table.set("self", table);
+        REQUIRE_THROWS_AS(ssq::serialize(table), const ssq::TypeException&);
+        REQUIRE_THROWS_AS(ssq::serialize(vm.findFunc("make")), const ssq::TypeException&);
+        REQUIRE(top == vm.getTop());
+    }
+}
+
+TEST_CASE("Convert objects to and from JSON") {
+    static const std::string source = STRINGIFY(
+        function check(data) {
+            return data.list.len() == 4 && data.list[0] == -12 &&
+                data.list[1] == 2.5 && data.list[2] == null && data.list[3] == false &&
+                data.nested.empty.len() == 0;
+        }
+
+        function roundTrip(text) {
+            return json.stringify(json.parse(text));
+        }
+    );
+
+    ssq::VM vm(1024, ssq::Libs::JSON);
+    vm.run(vm.compileSource(source.c_str()));
+    const auto top = vm.getTop();
+
+    const std::string text = "{ \"name\": \"caf\\u00e9 \\\"bar\\\"\",\n"
+        "  \"list\": [-12, 2.5e0, null, false],\n"
+        "  \"nested\": { \"empty\": [] } }";
+
+    SECTION("Parse") {
+        ssq::Object data = ssq::json::parse(vm, text);
+        REQUIRE(top == vm.getTop());
+        REQUIRE(data.getType() == ssq::Type::TABLE);
+        REQUIRE(vm.callFunc(vm.findFunc("check"), vm, data).to<bool>());
+        REQUIRE(data.toTable().get<std::string>("name") == "caf\xc3\xa9 \"bar\"");
+
+        ssq::Object copy = ssq::json::parse(vm, ssq::json::stringify(data, 2));
+        REQUIRE(vm.callFunc(vm.findFunc("check"), vm, copy).to<bool>());
+    }
+
+    SECTION("Stringify") {
+        REQUIRE(ssq::json::stringify(ssq::json::parse(vm, "[1, 1.5, \"a\\nb\", true, {}, [null]]")) ==
+            "[1,1.5,\"a\\nb\",true,{},[null]]");
+        REQUIRE(ssq::json::stringify(ssq::json::parse(vm, "[2.0]")) == "[2.0]");
+        REQUIRE(ssq::json::stringify(ssq::json::parse(vm, "{\"a\": [1]}"), 2) == "{\n  \"a\": [\n    1\n  ]\n}");
+    }
+
+    SECTION("Script functions") {
+        auto result = vm.callFunc(vm.findFunc("roundTrip"), vm, std::string("[1, {\"b\": \"c\"}]"));
+        REQUIRE(result.to<std::string>() == "[1,{\"b\":\"c\"}]");
+    }
+
+    SECTION("Errors") {
+        REQUIRE_THROWS_AS(ssq::json::parse(vm, "{\"a\": 1,\n \"b\" 2}"), const ssq::RuntimeException&);
+        REQUIRE_THROWS_AS(ssq::json::parse(vm, "[1, 2"), const ssq::RuntimeException&);
+        REQUIRE_THROWS_AS(ssq::json::parse(vm, "[1] 2"), const ssq::RuntimeException&);
+        REQUIRE_THROWS_AS(ssq::json::stringify(vm.findFunc("check")), const ssq::TypeException&);
+        REQUIRE(top == vm.getTop());
+
+        try {
+            ssq::json::parse(vm, "{\"a\": 1,\n \"b\" 2}");
+        } catch (const ssq::RuntimeException& e) {
+            REQUIRE(std::string(e.what()).find("line 2, column 6") != std::string::npos);
+        }
+    }
+}
+
+TEST_CASE("Share buffers with scripts") {
+    static const std::string source = STRINGIFY(
+        function fill(buffer) {
+            foreach (i, value in buffer) buffer[i] = i * 2;
+            return typeof buffer;
+        }
+
+        function sum(buffer) {
+            local total = 0.0;
+            for (local i = 0; i < buffer.len(); i++) total += buffer[i];
+            return total;
+        }
+
+        function outOfRange(buffer) {
+            return buffer[buffer.len()];
+        }
+
+        function makeBlob() {
+            local data = blob(8);
+            data.writen(7 | (9 << 16), 'i');
+            return data;
+        }
+    );
+
+    ssq::VM vm(1024, ssq::Libs::BLOB);
+    vm.run(vm.compileSource(source.c_str()));
+    const auto top = vm.getTop();
+
+    SECTION("Owned by the VM") {
+        ssq::Buffer<int32_t> buffer = vm.newBuffer<int32_t>(16);
+        REQUIRE(buffer.size() == 16);
+        REQUIRE(buffer[3] == 0);
+        REQUIRE(vm.callFunc(vm.findFunc("fill"), vm, buffer).to<std::string>() == "buffer");
+        REQUIRE(buffer[3] == 6);
+        REQUIRE(vm.callFunc(vm.findFunc("sum"), vm, buffer).to<float>() == Approx(240.0f));
+        REQUIRE(top == vm.getTop());
+    }
+
+    SECTION("View of C++ memory") {
+        std::vector<float> samples = { 0.5f, 1.5f, 2.0f };
+        ssq::Buffer<float> view = vm.newBufferView(samples.data(), samples.size());
+        REQUIRE(view.data() == samples.data());
+        REQUIRE(vm.callFunc(vm.findFunc("sum"), vm, view).to<float>() == Approx(4.0f));
+        vm.callFunc(vm.findFunc("fill"), vm, view);
+        REQUIRE(samples[2] == Approx(4.0f));
+        REQUIRE_THROWS_AS(vm.callFunc(vm.findFunc("outOfRange"), vm, view), const ssq::RuntimeException&);
+    }
+
+    SECTION("Function arguments") {
+        vm.addFunc("total", [](ssq::Buffer<int16_t> buffer) -> int {
+            int total = 0;
+            for (auto value : buffer) total += value;
+            return total;
+        });
+        std::vector<int16_t> values = { 1, -2, 300 };
+        auto view = vm.newBufferView(values.data(), values.size());
+        REQUIRE(vm.callFunc(vm.findFunc("total"), vm, view).to<int>() == 299);
+    }
+
+    SECTION("Blobs") {
+        ssq::Buffer<uint16_t> blob(vm.callFunc(vm.findFunc("makeBlob"), vm));
+        REQUIRE(blob.size() == 4);
+        REQUIRE(blob[0] == 7);
+        REQUIRE(blob[1] == 9);
+    }
+
+    SECTION("Type mismatch") {
+        ssq::Object buffer = vm.newBuffer<uint8_t>(4);
+        REQUIRE_THROWS_AS(ssq::Buffer<float>(buffer), const ssq::TypeException&);
+        REQUIRE_THROWS_AS(ssq::Buffer<float>(vm.newTable()), const ssq::TypeException&);
+    }
+}
+
+TEST_CASE("Vector math library") {
+    static const std::string source = STRINGIFY(
+        function loopSum(x) {
+            local total = 0;
+            foreach (value in x) total += value;
+            return total;
+        }
+
+        function makeBuffer(size) {
+            local x = vecmath.buffer(size);
+            for (local i = 0; i < size; i++) x[i] = (i % 7) - 3.5;
+            return x;
+        }
+
+        function checkBuffer(size) {
+            local x = makeBuffer(size);
+            local y = makeBuffer(size);
+            local dot = 0.0;
+            local low = x[0];
+            local high = x[0];
+            foreach (i, value in x) {
+                dot += value * y[i];
+                if (value < low) low = value;
+                if (value > high) high = value;
+            }
+            vecmath.scale(y, 2);
+            return vecmath.sum(x) == loopSum(x) && vecmath.dot(x, y) == dot * 2 &&
+                vecmath.min(x) == low && vecmath.max(x) == high && y[size - 1] == x[size - 1] * 2;
+        }
+
+        function checkArray() {
+            local ints = [];
+            ints.append(4);
+            ints.append(-2);
+            ints.append(9);
+            local floats = [];
+            floats.append(0.5);
+            floats.append(1);
+            floats.append(2.5);
+            local integral = vecmath.sum(ints) == 11 && typeof vecmath.sum(ints) == "integer";
+            local mixed = vecmath.dot(ints, floats) == 2 + -2 + 22.5;
+            vecmath.scale(ints, 3);
+            vecmath.scale(floats, 2);
+            return integral && mixed && ints[2] == 27 && floats[0] == 1.0 &&
+                vecmath.min(ints) == -6 && vecmath.max([]) == null;
+        }
+
+        function checkIntegers() {
+            local x = vecmath.buffer(5, "int16");
+            foreach (i, value in x) x[i] = i * 1000;
+            return vecmath.sum(x) == 10000 && vecmath.max(x) == 4000;
+        }
+    );
+
+    ssq::VM vm(1024, ssq::Libs::VECMATH);
+    vm.run(vm.compileSource(source.c_str()));
+
+    SECTION("Buffers") {
+        // Sizes around the vector widths exercise the remainder loops
+        for (int size : { 1, 3, 4, 7, 8, 15, 16, 17, 33, 100 }) {
+            REQUIRE(vm.callFunc(vm.findFunc("checkBuffer"), vm, size).to<bool>());
+        }
+    }
+
+    SECTION("Arrays") {
+        REQUIRE(vm.callFunc(vm.findFunc("checkArray"), vm).to<bool>());
+    }
+
+    SECTION("Integer buffers") {
+        REQUIRE(vm.callFunc(vm.findFunc("checkIntegers"), vm).to<bool>());
+    }
+
+    SECTION("C++ kernels") {
+        std::vector<float> values = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f };
+        REQUIRE(ssq::vecmath::sum(values.data(), values.size()) == Approx(45.0f));
+        REQUIRE(ssq::vecmath::dot(values.data(), values.data(), values.size()) == Approx(285.0f));
+        ssq::vecmath::scale(values.data(), values.size(), 0.5f);
+        REQUIRE(values[8] == Approx(4.5f));
+    }
+}
+
+TEST_CASE("Failed operations keep the stack balanced") {
+    static const std::string source = STRINGIFY(
+        function makeLocked() {
+            local t = {};
+            t.setdelegate({ _newslot = function(key, value) { throw "locked"; } });
+            return t;
+        }
+    );
+
+    ssq::VM vm(1024);
+    vm.run(vm.compileSource(source.c_str()));
+    ssq::Table locked = vm.callFunc(vm.findFunc("makeLocked"), vm).toTable();
+    ssq::Array array = vm.newArray();
+    array.push(std::string("text"));
+    const auto top = vm.getTop();
+
+    for (int i = 0; i < 100; i++) {
+        REQUIRE_THROWS(locked.set("key", i));
+        REQUIRE_THROWS(locked.addTable("table"));
+        REQUIRE_THROWS(array.get<int>(0));
+        REQUIRE_THROWS(array.get<int>(5));
+        REQUIRE_THROWS(array.set(5, i));
+        REQUIRE_THROWS(array.convert<int>());
+        REQUIRE_THROWS(vm.find("missing"));
+        REQUIRE_THROWS(vm.callBatch<int>(vm.findFunc("makeLocked"), vm, std::vector<std::tuple<>>(1), std::vector<int>(1).begin()));
+    }
+    REQUIRE(top == vm.getTop());
+
+    ssq::StackGuard guard(vm.getHandle());
+    sq_pushinteger(vm.getHandle(), 1);
+    REQUIRE(guard.getTop() == top);
+}
+
+TEST_CASE("Borrowed object references") {
+    static const std::string source = STRINGIFY(
+        config <- {};
+        config.width <- 640;
+        config.height <- 480;
+        config.title <- "window";
+        computed <- {}.setdelegate({
+            _get = function(key) {
+                return key + "!";
+            }
+        });
+        function sumValues(table) {
+            return sumNative(table);
+        }
+    );
+
+    ssq::VM vm(1024);
+    vm.addFunc("sumNative", [](ssq::ObjectRef table) -> int {
+        int sum = 0;
+        table.forEach([&](ssq::ObjectRef, ssq::ObjectRef value) {
+            if (value.getType() == ssq::Type::INTEGER) sum += value.to<int>();
+        });
+        return sum;
+    });
+    vm.run(vm.compileSource(source.c_str()));
+    const auto top = vm.getTop();
+
+    ssq::Object config = vm.find("config");
+    ssq::ObjectRef ref(config);
+    REQUIRE(ref.getType() == ssq::Type::TABLE);
+    REQUIRE(ref.find("width").to<int>() == 640);
+    REQUIRE(ref.find("title").to<std::string>() == "window");
+    REQUIRE_THROWS_AS(ref.find("depth"), const ssq::NotFoundException&);
+    // Values produced by delegates have no owner
+    REQUIRE_THROWS_AS(ssq::ObjectRef(vm.find("computed")).find("depth"), const ssq::NotFoundException&);
+
+    size_t count = 0;
+    ref.forEach([&](ssq::ObjectRef key, ssq::ObjectRef) {
+        REQUIRE(key.getType() == ssq::Type::STRING);
+        count++;
+    });
+    REQUIRE(count == 3);
+    REQUIRE(vm.callFunc(vm.findFunc("sumValues"), vm, config).toInt() == 1120);
+
+    ssq::Object title = ref.find("title").toObject();
+    config.toTable().remove("title");
+    REQUIRE(title.toString() == "window");
+    REQUIRE(top == vm.getTop());
+}
+
+TEST_CASE("Non-throwing API") {
+    static const std::string source = STRINGIFY(
+        values <- [];
+        values.append(1);
+        values.append("two");
+        function add(a, b) {
+            return a + b;
+        }
+        function fail() {
+            throw "failed";
+        }
+    );
+
+    ssq::VM vm(1024);
+    REQUIRE(vm.tryCompileSource("function (").getError().getCode() == ssq::ErrorCode::COMPILE_ERROR);
+    ssq::Result<ssq::Script> script = vm.tryCompileSource(source.c_str());
+    REQUIRE(script.isOk());
+    REQUIRE(vm.tryRun(script.value()));
+    const auto top = vm.getTop();
+
+    ssq::Result<ssq::Function> add = vm.tryGet<ssq::Function>("add");
+    REQUIRE(add);
+    REQUIRE(vm.tryCallFunc(add.value(), vm, 2, 3).value().toInt() == 5);
+    REQUIRE(vm.tryCallFunc(add.value(), vm, 2).getError().getCode() == ssq::ErrorCode::ARGUMENT_MISMATCH);
+    REQUIRE(vm.tryCallFunc(vm.findFunc("fail"), vm).getError().getCode() == ssq::ErrorCode::RUNTIME_ERROR);
+    REQUIRE(vm.tryGet<int>("missing").getError().getCode() == ssq::ErrorCode::NOT_FOUND);
+    REQUIRE(vm.tryGet<int>("add").getError().getCode() == ssq::ErrorCode::TYPE_MISMATCH);
+    REQUIRE(vm.tryGet<int>("missing").valueOr(42) == 42);
+
+    ssq::Array values = vm.find("values").toArray();
+    REQUIRE(values.tryGet<int>(0).value() == 1);
+    REQUIRE(values.tryGet<int>(1).getError().getCode() == ssq::ErrorCode::TYPE_MISMATCH);
+    REQUIRE(values.tryGet<int>(2).getError().getCode() == ssq::ErrorCode::RUNTIME_ERROR);
+    REQUIRE(values.trySet(0, 10));
+    REQUIRE(!values.trySet(5, 10));
+
+    REQUIRE(vm.trySet("answer", 42));
+    REQUIRE(vm.find("answer").toInt() == 42);
+    REQUIRE_THROWS_AS(vm.tryGet<int>("missing").unwrap(vm.getHandle()), const ssq::NotFoundException&);
+    REQUIRE(top == vm.getTop());
+}
+
+TEST_CASE("Compact object handles") {
+    class Foo : public ssq::ExposableClass {
+    };
+
+    REQUIRE(!std::is_polymorphic<ssq::Object>::value);
+    REQUIRE(sizeof(ssq::Object) == sizeof(ssq::ObjectRef));
+    REQUIRE(sizeof(ssq::Table) == sizeof(ssq::Object));
+
+    ssq::VM vm(1024);
+    ssq::Table table = vm.newTable();
+    const auto refs = sq_getrefcount(vm.getHandle(), &table.getRaw());
+
+    std::vector<ssq::Object> handles;
+    for (int i = 0; i < 1000; i++) {
+        handles.push_back(table);
+    }
+    REQUIRE(sq_getrefcount(vm.getHandle(), &table.getRaw()) == refs + 1000);
+    handles.erase(handles.begin(), handles.begin() + 500);
+    REQUIRE(sq_getrefcount(vm.getHandle(), &table.getRaw()) == refs + 500);
+    handles.clear();
+    REQUIRE(sq_getrefcount(vm.getHandle(), &table.getRaw()) == refs);
+
+    ssq::Instance instance = vm.newInstance(vm.addClass("Foo", ssq::Class::Ctor<Foo()>()));
+    const auto instanceRefs = sq_getrefcount(vm.getHandle(), &instance.getRaw());
+    {
+        ssq::SqWeakRef weak(instance);
+        ssq::SqWeakRef copy(weak);
+        copy = weak;
+        REQUIRE(sq_getrefcount(vm.getHandle(), &instance.getRaw()) == instanceRefs);
+    }
+    REQUIRE(sq_getrefcount(vm.getHandle(), &instance.getRaw()) == instanceRefs);
+}
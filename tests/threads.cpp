@@ -0,0 +1,412 @@
+#define CATCH_CONFIG_MAIN 
+#include "catch.hpp"
+#include <simplesquirrel/simplesquirrel.hpp>
+#include <thread>
+
+#define STRINGIFY(x) #x
+
+TEST_CASE("Suspend and resume a coroutine") {
+    static const std::string source = STRINGIFY(
+        function counter(start, step) {
+            local value = start;
+            while (true) {
+                local received = suspend(value);
+                if (received == null) {
+                    return "done";
+                }
+                value += received * step;
+            }
+        }
+
+        function fails() {
+            suspend(1);
+            throw "failure";
+        }
+    );
+
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.run(vm.compileSource(source.c_str()));
+
+    ssq::Coroutine coroutine(vm, vm.findFunc("counter"));
+    REQUIRE(coroutine.getState() == ssq::Coroutine::State::IDLE);
+    REQUIRE_THROWS_AS(coroutine.resume(1), const ssq::RuntimeException&);
+
+    const SQInteger top = coroutine.getThread().getTop();
+
+    ssq::Object value = coroutine.start(10, 2);
+    REQUIRE(coroutine.isSuspended());
+    REQUIRE(value.toInt() == 10);
+    REQUIRE_THROWS_AS(coroutine.start(10, 2), const ssq::RuntimeException&);
+
+    REQUIRE(coroutine.resume(3).toInt() == 16);
+    REQUIRE(coroutine.resumeAs<int>(1) == 18);
+    REQUIRE(coroutine.getValue().toInt() == 18);
+
+    value = coroutine.resume();
+    REQUIRE(coroutine.isFinished());
+    REQUIRE(value.toString() == "done");
+    REQUIRE(coroutine.getThread().getTop() == top);
+
+    // Reuse the thread
+    coroutine.reset(vm.findFunc("fails"));
+    REQUIRE(coroutine.start().toInt() == 1);
+    REQUIRE_THROWS_AS(coroutine.resume(), const ssq::RuntimeException&);
+    REQUIRE(coroutine.isFinished());
+    REQUIRE(coroutine.getThread().getTop() == top);
+
+    ssq::Coroutine moved = std::move(coroutine);
+    moved.reset(vm.findFunc("counter"));
+    REQUIRE(moved.start(1, 1).toInt() == 1);
+}
+
+TEST_CASE("Many suspended coroutines") {
+    static const std::string source = STRINGIFY(
+        function task(id) {
+            local sum = 0;
+            for (local i = 0; i < 3; i++) {
+                sum += suspend(id);
+            }
+            return sum;
+        }
+    );
+
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.run(vm.compileSource(source.c_str()));
+    ssq::Function task = vm.findFunc("task");
+
+    std::vector<ssq::Coroutine> coroutines;
+    for (int i = 0; i < 1000; i++) {
+        coroutines.emplace_back(vm, task, 64);
+        REQUIRE(coroutines.back().start(i).toInt() == i);
+    }
+
+    for (int round = 0; round < 3; round++) {
+        for (auto& coroutine : coroutines) {
+            coroutine.resume(round);
+        }
+    }
+
+    for (auto& coroutine : coroutines) {
+        REQUIRE(coroutine.isFinished());
+        REQUIRE(coroutine.getValue().toInt() == 3);
+    }
+}
+
+TEST_CASE("Schedule tasks") {
+    static const std::string source = STRINGIFY(
+        events <- [];
+
+        function worker(name, count) {
+            for (local i = 0; i < count; i++) {
+                events.append(name + i);
+                suspend();
+            }
+        }
+
+        function sleeper() {
+            suspend(10);
+            events.append("awake");
+        }
+
+        function listener() {
+            local value = suspend("event");
+            events.append("got " + value);
+        }
+
+        function broken() {
+            suspend();
+            throw "broken";
+        }
+    );
+
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.run(vm.compileSource(source.c_str()));
+    ssq::Array events = vm.find("events").toArray();
+
+    ssq::Scheduler scheduler(vm, 64);
+
+    SECTION("Round-robin and priorities") {
+        scheduler.spawn(vm.findFunc("worker"), std::string("a"), 2);
+        scheduler.spawn(vm.findFunc("worker"), std::string("b"), 2);
+        scheduler.spawn(1, vm.findFunc("worker"), std::string("c"), 2);
+        REQUIRE(scheduler.getNumOfTasks() == 3);
+        REQUIRE(scheduler.getNumOfReadyTasks() == 3);
+
+        while (scheduler.getNumOfTasks() > 0) {
+            scheduler.run();
+        }
+
+        const std::vector<std::string> expected = {"a0", "b0", "c0", "c1", "a1", "b1"};
+        REQUIRE(events.convert<std::string>() == expected);
+    }
+
+    SECTION("Timers and signals") {
+        scheduler.spawn(vm.findFunc("sleeper"));
+        auto listener = scheduler.spawn(vm.findFunc("listener"));
+        REQUIRE(scheduler.getNumOfReadyTasks() == 0);
+        REQUIRE(scheduler.getNextWakeup() > std::chrono::steady_clock::now());
+
+        REQUIRE(scheduler.run() == 0);
+        REQUIRE(scheduler.signal("event", 42) == 1);
+        REQUIRE(scheduler.signal("event", 42) == 0);
+        REQUIRE(scheduler.run() == 1);
+        REQUIRE(scheduler.isAlive(listener) == false);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+        REQUIRE(scheduler.run() == 1);
+
+        const std::vector<std::string> expected = {"got 42", "awake"};
+        REQUIRE(events.convert<std::string>() == expected);
+        REQUIRE(scheduler.getNumOfTasks() == 0);
+    }
+
+    SECTION("Errors and cancellation") {
+        auto broken = scheduler.spawn(vm.findFunc("broken"));
+        REQUIRE_THROWS_AS(scheduler.run(), const ssq::RuntimeException&);
+        REQUIRE(scheduler.isAlive(broken) == false);
+
+        size_t errors = 0;
+        scheduler.setErrorHandler([&](ssq::Scheduler::TaskId, const std::exception&) {
+            errors++;
+        });
+        scheduler.spawn(vm.findFunc("broken"));
+        scheduler.run();
+        REQUIRE(errors == 1);
+
+        auto cancelled = scheduler.spawn(vm.findFunc("worker"), std::string("e"), 2);
+        REQUIRE(scheduler.getNumOfReadyTasks() == 1);
+        REQUIRE(scheduler.cancel(cancelled));
+        REQUIRE(scheduler.getNumOfReadyTasks() == 0);
+        REQUIRE(scheduler.run() == 0);
+
+        auto listener = scheduler.spawn(vm.findFunc("listener"));
+        REQUIRE(scheduler.cancel(listener));
+        REQUIRE(scheduler.cancel(listener) == false);
+        REQUIRE(scheduler.signal("event", 1) == 0);
+        REQUIRE(scheduler.getNumOfTasks() == 0);
+
+        // Slots and threads are reused
+        auto reused = scheduler.spawn(vm.findFunc("worker"), std::string("d"), 1);
+        REQUIRE(reused != listener);
+        REQUIRE(scheduler.isAlive(reused));
+    }
+}
+
+TEST_CASE("Interrupt scheduled tasks") {
+    // Not STRINGIFY, Squirrel only reports a line when the executed line changes
+    static const char* source =
+        "function step() {\n"
+        "    return 1;\n"
+        "}\n"
+        "function limited() {\n"
+        "    exhaust();\n"
+        "    step();\n"
+        "    suspend();\n"
+        "}\n"
+        "function worker() {\n"
+        "    while (true) {\n"
+        "        suspend();\n"
+        "        step();\n"
+        "    }\n"
+        "}\n";
+
+    ssq::VM vm(1024, ssq::Libs::ALL);
+    vm.enableDebugInfo(true);
+    ssq::Scheduler scheduler(vm, 64);
+    vm.addFunc("exhaust", [&]() {
+        scheduler.getThread(scheduler.getCurrentTask())->setInstructionBudget(0);
+    });
+    vm.run(vm.compileSource(source));
+
+    SECTION("While spawning") {
+        REQUIRE_THROWS_AS(scheduler.spawn(vm.findFunc("limited")), const ssq::TimeoutException&);
+        REQUIRE(scheduler.getNumOfTasks() == 0);
+        REQUIRE(scheduler.getCurrentTask() == 0);
+    }
+
+    SECTION("While running") {
+        size_t timeouts = 0;
+        scheduler.setErrorHandler([&](ssq::Scheduler::TaskId, const std::exception& e) {
+            if (dynamic_cast<const ssq::TimeoutException*>(&e)) timeouts++;
+        });
+
+        auto limited = scheduler.spawn(vm.findFunc("worker"));
+        auto other = scheduler.spawn(vm.findFunc("worker"));
+        scheduler.getThread(limited)->setInstructionBudget(0);
+        REQUIRE(scheduler.run() == 2);
+        REQUIRE(timeouts == 1);
+        REQUIRE(scheduler.isAlive(limited) == false);
+        REQUIRE(scheduler.getThread(limited) == nullptr);
+        REQUIRE(scheduler.isAlive(other));
+        REQUIRE(scheduler.getNumOfTasks() == 1);
+        REQUIRE(scheduler.getNumOfReadyTasks() == 1);
+        REQUIRE(scheduler.getCurrentTask() == 0);
+
+        // The slot is reused without the budget
+        auto reused = scheduler.spawn(vm.findFunc("worker"));
+        REQUIRE(scheduler.getThread(reused)->hasBudget() == false);
+        REQUIRE(scheduler.run() == 2);
+        REQUIRE(timeouts == 1);
+        REQUIRE(scheduler.getNumOfTasks() == 2);
+    }
+}
+
+TEST_CASE("Run jobs on multiple VMs") {
+    static const std::string source = STRINGIFY(
+        function fib(n) {
+            return n < 2 ? n : fib(n - 1) + fib(n - 2);
+        }
+    );
+
+    std::atomic<int> initialized(0);
+    auto script = ssq::VMExecutor::runScript(source, "executor.nut");
+    ssq::VMExecutor executor(4, [&](ssq::VM& vm) {
+        script(vm);
+        initialized++;
+    });
+    REQUIRE(executor.getNumOfWorkers() == 4);
+    REQUIRE(initialized == 4);
+
+    SECTION("Call global functions") {
+        std::vector<std::future<int>> results;
+        for (int i = 0; i < 20; i++) {
+            results.push_back(executor.call<int>("fib", i));
+        }
+        REQUIRE(results[10].get() == 55);
+        REQUIRE(results[19].get() == 4181);
+    }
+
+    SECTION("Submit callables") {
+        auto result = executor.submit([](ssq::VM& vm) {
+            return vm.callFunc(vm.findFunc("fib"), vm, 12).to<int>();
+        });
+        REQUIRE(result.get() == 144);
+    }
+
+    SECTION("Exceptions are returned through the future") {
+        auto result = executor.call<int>("missing");
+        REQUIRE_THROWS_AS(result.get(), const ssq::NotFoundException&);
+    }
+}
+
+TEST_CASE("Classes are registered per VM") {
+    class Foo: public ssq::ExposableClass {
+    public:
+        int value = 1;
+    };
+
+    static const std::string source = STRINGIFY(
+        function check(foo) {
+            return foo instanceof Foo;
+        }
+    );
+
+    ssq::VM vm1(1024, ssq::Libs::NONE);
+    ssq::VM vm2(1024, ssq::Libs::NONE);
+    vm1.addClass("Foo", ssq::Class::Ctor<Foo()>());
+    vm2.addClass("Foo", ssq::Class::Ctor<Foo()>());
+    vm2.run(vm2.compileSource(source.c_str()));
+
+    vm1.destroy();
+
+    Foo foo;
+    REQUIRE(vm2.callFunc(vm2.findFunc("check"), vm2, &foo).to<bool>());
+}
+
+TEST_CASE("Track stack usage") {
+    static const std::string source = STRINGIFY(
+        function recurse(depth) {
+            local a = depth;
+            local b = depth * 2;
+            if (depth > 1) return recurse(depth - 1) + a + b;
+            return 0;
+        }
+
+        function fails(depth) {
+            if (depth > 1) return fails(depth - 1);
+            throw "failure";
+        }
+    );
+
+    ssq::VM vm(1024, ssq::Libs::NONE);
+    vm.run(vm.compileSource(source.c_str()));
+    REQUIRE(vm.getSuggestedThreadStackSize() == 1024);
+    vm.setStackTracking(true);
+
+    vm.callFunc(vm.findFunc("recurse"), vm, 10);
+    const ssq::StackStats shallow = vm.getStackStats();
+    REQUIRE(shallow.peakDepth >= 10);
+    REQUIRE(shallow.peakSlots >= 10 * 3);
+
+    ssq::VM thread = vm.newThread(64);
+    thread.callFunc(thread.findFunc("recurse"), thread, 100);
+    REQUIRE(thread.getStackStats().peakDepth >= 100);
+    REQUIRE(thread.getStackStats().peakSlots > shallow.peakSlots);
+    REQUIRE(vm.getStackStats().peakDepth == shallow.peakDepth);
+
+    // Frames unwound by an exception are released too
+    thread.resetStackStats();
+    REQUIRE_THROWS_AS(thread.callFunc(thread.findFunc("fails"), thread, 20), const ssq::RuntimeException&);
+    thread.callFunc(thread.findFunc("recurse"), thread, 30);
+    REQUIRE(thread.getStackStats().peakDepth >= 30);
+    REQUIRE(thread.getStackStats().peakDepth < 50);
+
+    const size_t suggested = vm.getSuggestedThreadStackSize();
+    REQUIRE(suggested > 100 * 3);
+    REQUIRE(suggested < 1024 * 16);
+    ssq::VM tuned = vm.newThread();
+    REQUIRE(tuned.callFunc(tuned.findFunc("recurse"), tuned, 3).toInt() == 15);
+
+    vm.setStackTracking(false);
+    REQUIRE(vm.getStackStats().peakDepth == 0);
+    REQUIRE(vm.getSuggestedThreadStackSize() == 1024);
+}
+
+TEST_CASE("Control garbage collection") {
+    static const std::string source = STRINGIFY(
+        function makeCycles(count) {
+            for (local i = 0; i < count; i++) {
+                local a = {};
+                local b = { other = a };
+                a.other <- b;
+            }
+        }
+    );
+
+    ssq::VM vm(1024);
+    vm.run(vm.compileSource(source.c_str()));
+    ssq::Function makeCycles = vm.findFunc("makeCycles");
+
+    vm.callFunc(makeCycles, vm, 10);
+    REQUIRE(vm.gc().collect() >= 20);
+    REQUIRE(vm.gc().getStats().collections == 1);
+    REQUIRE(vm.gc().getStats().lastFreed >= 20);
+
+    {
+        ssq::GarbageCollector::Pause pause(vm);
+        ssq::VM thread = vm.newThread();
+        vm.destroyThread(thread);
+        REQUIRE(vm.gc().isPaused());
+        REQUIRE(vm.gc().isPending());
+        REQUIRE(vm.gc().update() == 0);
+        REQUIRE(vm.gc().getStats().collections == 1);
+    }
+    REQUIRE(!vm.gc().isPaused());
+    REQUIRE(vm.gc().isPending());
+    vm.gc().update();
+    REQUIRE(!vm.gc().isPending());
+    REQUIRE(vm.gc().getStats().collections == 2);
+
+    vm.gc().setAutoCollect(false);
+    ssq::VM thread = vm.newThread();
+    ssq::GarbageCollector threadGc = thread.gc();
+    vm.destroyThread(thread);
+    REQUIRE(vm.gc().isPending());
+    REQUIRE(threadGc.getStats().collections == 2);
+    vm.callFunc(makeCycles, vm, 5);
+    REQUIRE(vm.gc().update() >= 10);
+    REQUIRE(vm.gc().getStats().collections == 3);
+
+    vm.gc().resetStats();
+    REQUIRE(vm.gc().getStats().collections == 0);
+}